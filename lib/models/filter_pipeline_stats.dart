@@ -0,0 +1,40 @@
+/// One filter stage of the live filter pipeline.
+class FilterStageStats {
+  final int filterId; // first filter; repeated stateful filters share a stage
+  final bool ordered; // stateful filter: one worker, frames in order
+  final int workers;
+  final int queued;
+  final int peakQueued;
+  final int processed;
+  final double meanMs;
+
+  const FilterStageStats({
+    required this.filterId,
+    required this.ordered,
+    required this.workers,
+    required this.queued,
+    required this.peakQueued,
+    required this.processed,
+    required this.meanMs,
+  });
+}
+
+/// Depth and counters of the live filter pipeline
+/// (layout: windows/runner/filter_pipeline.h).
+class FilterPipelineStats {
+  final int inFlight;
+  final int maxInFlight;
+  final int submitted;
+  final int completed;
+  final int dropped;
+  final List<FilterStageStats> stages;
+
+  const FilterPipelineStats({
+    required this.inFlight,
+    required this.maxInFlight,
+    required this.submitted,
+    required this.completed,
+    required this.dropped,
+    required this.stages,
+  });
+}
@@ -106,6 +106,57 @@ class GraphHardEdge {
   });
 }
 
+/// Kinds of graph change events, in the order they are applied within a
+/// version (windows/runner/whiteboard_graph_changes.h).
+enum GraphChangeType {
+  edgeRemoved,
+  nodeRemoved,
+  nodeAdded,
+  nodeMoved, // bbox, centroid or contour changed
+  nodeUpdated, // other fields only; keep the previous contour
+  edgeAdded,
+}
+
+class GraphChangeEvent {
+  final GraphChangeType type;
+  final int firstId; // node id, or the first node of an edge
+  final int secondId; // second node of an edge
+  final GraphNodeInfo? node; // added, moved and updated nodes
+  final List<Offset>? contour; // added and moved nodes, canvas coordinates
+
+  const GraphChangeEvent({
+    required this.type,
+    required this.firstId,
+    this.secondId = -1,
+    this.node,
+    this.contour,
+  });
+}
+
+/// Graph changes after a version the caller already has. When
+/// [needsFullSnapshot] is set there are no events: reload with the full
+/// getters and continue from [version].
+class GraphChangeSet {
+  final int sinceVersion;
+  final int version; // version the events bring the caller to
+  final int latestVersion;
+  final bool needsFullSnapshot;
+  final Rect? canvasBounds; // at the latest version
+  final List<GraphChangeEvent> events;
+
+  const GraphChangeSet({
+    required this.sinceVersion,
+    required this.version,
+    required this.latestVersion,
+    required this.needsFullSnapshot,
+    required this.canvasBounds,
+    required this.events,
+  });
+
+  /// The buffer could not hold every version; ask again from [version].
+  bool get hasMore => version < latestVersion;
+}
+
 class NodeComparison {
   static const int duplicateReasonPositionalOverlap = 1 << 0;
   static const int duplicateReasonCentroidIou = 1 << 1;
@@ -213,3 +264,88 @@ class NodeMaskImage {
     required this.rgbaBytes,
   });
 }
+
+/// Latency distribution of one canvas worker stage (or the frame total).
+class CanvasStageTiming {
+  final String name;
+  final int samples;
+  final double meanMs;
+  final double p50Ms;
+  final double p90Ms;
+  final double p99Ms;
+  final double maxMs;
+  final List<int> histogram; // counts per bin, see CanvasPerfSnapshot.binUpperEdgesMs
+
+  const CanvasStageTiming({
+    required this.name,
+    required this.samples,
+    required this.meanMs,
+    required this.p50Ms,
+    required this.p90Ms,
+    required this.p99Ms,
+    required this.maxMs,
+    required this.histogram,
+  });
+}
+
+/// Stage timings of the most recent canvas worker frames
+/// (layout: windows/runner/whiteboard_canvas_perf.h).
+class CanvasPerfSnapshot {
+  static const List<String> stageNames = [
+    'No-update mask',
+    'Motion gate',
+    'Binarize',
+    'Extract blobs',
+    'Enhance + filter',
+    'Match',
+    'Update graph',
+  ];
+
+  final int frames;
+  final int acceptedFrames;
+  final double meanBlobs;
+  final double meanMatched;
+  final int nodeCount;
+  final List<double> binUpperEdgesMs;
+  final List<CanvasStageTiming> stages;
+  final CanvasStageTiming total;
+
+  const CanvasPerfSnapshot({
+    required this.frames,
+    required this.acceptedFrames,
+    required this.meanBlobs,
+    required this.meanMatched,
+    required this.nodeCount,
+    required this.binUpperEdgesMs,
+    required this.stages,
+    required this.total,
+  });
+
+  /// Sum of the per-stage means; the denominator for each stage's share.
+  double get stageSumMs =>
+      stages.fold(0.0, (sum, stage) => sum + stage.meanMs);
+}
+
+/// Counters of the lock-free frame ring feeding the canvas helper process
+/// (layout: windows/runner/whiteboard_canvas_process.h).
+class CanvasFrameRingStats {
+  final int slots;
+  final int submitted;
+  final int consumed;
+  final int overwritten; // replaced before the helper took them
+  final int discarded; // claimed slot was incomplete (should stay 0)
+  final bool framePending;
+  final int lastConsumedFrameId;
+
+  const CanvasFrameRingStats({
+    required this.slots,
+    required this.submitted,
+    required this.consumed,
+    required this.overwritten,
+    required this.discarded,
+    required this.framePending,
+    required this.lastConsumedFrameId,
+  });
+
+  int get dropped => overwritten + discarded;
+}
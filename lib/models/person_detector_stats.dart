@@ -0,0 +1,51 @@
+/// Person detector backends; indices match PersonDetectorBackend in
+/// windows/runner/yolo_person_detector.h.
+enum PersonDetectorBackend { openCvCpu, openVinoCpu }
+
+/// Person detector model variants (yolo11n.onnx, yolo11n_fp16.onnx,
+/// yolo11n_int8.onnx); missing variants fall back to FP32.
+enum PersonDetectorPrecision { fp32, fp16, int8 }
+
+enum PersonDetectorState { idle, loading, ready, failed }
+
+/// Load state and inference latency of the shared person detector
+/// (layout: windows/runner/yolo_person_detector.h).
+class PersonDetectorStats {
+  final PersonDetectorState state;
+  final PersonDetectorBackend requestedBackend;
+  final PersonDetectorBackend activeBackend;
+  final PersonDetectorPrecision requestedPrecision;
+  final PersonDetectorPrecision activePrecision;
+  final int threads;
+  final double loadMs;
+  final double warmUpMs;
+  final int inferences;
+  final int samples; // inferences in the latency window
+  final double lastMs;
+  final double meanMs;
+  final double p50Ms;
+  final double p90Ms;
+  final double maxMs;
+
+  const PersonDetectorStats({
+    required this.state,
+    required this.requestedBackend,
+    required this.activeBackend,
+    required this.requestedPrecision,
+    required this.activePrecision,
+    required this.threads,
+    required this.loadMs,
+    required this.warmUpMs,
+    required this.inferences,
+    required this.samples,
+    required this.lastMs,
+    required this.meanMs,
+    required this.p50Ms,
+    required this.p90Ms,
+    required this.maxMs,
+  });
+
+  /// True when a requested variant was unavailable and the detector fell back.
+  bool get fellBack =>
+      activeBackend != requestedBackend || activePrecision != requestedPrecision;
+}
@@ -88,6 +88,12 @@ class _EditCanvasScreenState extends State<EditCanvasScreen> {
   }
 
   void _snapshotFromCpp() {
+    try {
+      _native.refreshGraphExport();
+    } catch (e) {
+      // The getters below still read the previous export.
+    }
+
     List<GraphNodeInfo> nodes;
     try {
       nodes = _native.getGraphNodes();
@@ -82,10 +82,14 @@ class _GraphDebugScreenState extends State<GraphDebugScreen> {
 
   List<GraphNodeInfo> _nodes = [];
   Rect? _canvasBounds;
+  // Live graph as of _graphVersion, kept up to date from graph change sets.
+  int? _graphVersion;
+  Map<int, GraphNodeInfo> _liveNodesById = {};
   int? _selectedIdA;
   int? _selectedIdB;
   NodeComparison? _comparison;
   String? _comparisonMessage;
+  CanvasPerfSnapshot? _perf;
 
   _GraphDebugMode _mode = _GraphDebugMode.live;
   List<_SnapshotGraphState> _snapshots = const [
@@ -122,6 +126,68 @@ class _GraphDebugScreenState extends State<GraphDebugScreen> {
     if (!mounted) return;
     AppLogger.graphDebug('_fetchFromCpp: starting');
 
+    final (enrichedNodes, bounds) = _pullLiveGraph();
+
+    CanvasPerfSnapshot? perf;
+    try {
+      perf = _native.getCanvasPerfSnapshot();
+    } catch (e) {
+      AppLogger.graphDebug('_fetchFromCpp: getCanvasPerfSnapshot() threw: $e');
+      perf = null;
+    }
+
+    NodeComparison? comp;
+    String? compMessage;
+    if (_selectedIdA != null && _selectedIdB != null) {
+      comp = _native.compareNodes(_selectedIdA!, _selectedIdB!);
+      if (comp == null) {
+        compMessage = 'Comparison unavailable for the selected pair.';
+      }
+    }
+
+    if (!mounted) return;
+    setState(() {
+      _nodes = enrichedNodes;
+      _canvasBounds = bounds;
+      _comparison = comp;
+      _comparisonMessage = compMessage;
+      _perf = perf;
+
+      final ids = enrichedNodes.map((n) => n.id).toSet();
+      if (_selectedIdA != null && !ids.contains(_selectedIdA)) {
+        _selectedIdA = null;
+      }
+      if (_selectedIdB != null && !ids.contains(_selectedIdB)) {
+        _selectedIdB = null;
+      }
+    });
+  }
+
+  /// Brings the live graph up to date: only the changes since the last pull
+  /// when the native side keeps them, otherwise a full reload.
+  (List<GraphNodeInfo>, Rect?) _pullLiveGraph() {
+    GraphChangeSet? changes;
+    try {
+      changes = _native.getGraphChanges(_graphVersion ?? -1);
+      // A change set too large for one buffer continues where it stopped.
+      for (int i = 0; changes != null && !changes.needsFullSnapshot && i < 8; i++) {
+        _applyGraphChanges(changes);
+        if (!changes.hasMore) {
+          return (_liveNodesById.values.toList(), changes.canvasBounds);
+        }
+        changes = _native.getGraphChanges(changes.version);
+      }
+    } catch (e) {
+      AppLogger.graphDebug('_fetchFromCpp: getGraphChanges() threw: $e');
+      changes = null;
+    }
+
+    try {
+      _native.refreshGraphExport();
+    } catch (e) {
+      AppLogger.graphDebug('_fetchFromCpp: refreshGraphExport() threw: $e');
+    }
+
     List<GraphNodeInfo> nodes;
     try {
       nodes = _native.getGraphNodes();
@@ -150,31 +216,32 @@ class _GraphDebugScreenState extends State<GraphDebugScreen> {
     }
 
     final enrichedNodes = _mergeContoursIntoNodes(nodes, contours);
+    // The snapshot is at least as new as the version the change log named,
+    // so later change sets can be applied on top of it.
+    _graphVersion = changes != null && changes.needsFullSnapshot ? changes.version : null;
+    _liveNodesById = {for (final node in enrichedNodes) node.id: node};
+    return (enrichedNodes, bounds);
+  }
 
-    NodeComparison? comp;
-    String? compMessage;
-    if (_selectedIdA != null && _selectedIdB != null) {
-      comp = _native.compareNodes(_selectedIdA!, _selectedIdB!);
-      if (comp == null) {
-        compMessage = 'Comparison unavailable for the selected pair.';
+  void _applyGraphChanges(GraphChangeSet changes) {
+    for (final event in changes.events) {
+      final node = event.node;
+      switch (event.type) {
+        case GraphChangeType.nodeRemoved:
+          _liveNodesById.remove(event.firstId);
+        case GraphChangeType.nodeAdded:
+        case GraphChangeType.nodeMoved:
+        case GraphChangeType.nodeUpdated:
+          if (node == null) break;
+          final contour = event.contour ?? _liveNodesById[node.id]?.contour ?? const [];
+          _liveNodesById[node.id] =
+              _mergeContoursIntoNodes([node], {node.id: contour}).single;
+        case GraphChangeType.edgeRemoved:
+        case GraphChangeType.edgeAdded:
+          break; // edges are not drawn here
       }
     }
-
-    if (!mounted) return;
-    setState(() {
-      _nodes = enrichedNodes;
-      _canvasBounds = bounds;
-      _comparison = comp;
-      _comparisonMessage = compMessage;
-
-      final ids = enrichedNodes.map((n) => n.id).toSet();
-      if (_selectedIdA != null && !ids.contains(_selectedIdA)) {
-        _selectedIdA = null;
-      }
-      if (_selectedIdB != null && !ids.contains(_selectedIdB)) {
-        _selectedIdB = null;
-      }
-    });
+    _graphVersion = changes.version;
   }
 
   List<GraphNodeInfo> _mergeContoursIntoNodes(
@@ -822,6 +889,19 @@ class _GraphDebugScreenState extends State<GraphDebugScreen> {
                     'Comparison is not available yet for the selected pair.',
               ),
           ],
+          const Divider(color: Colors.grey),
+          Text(
+            'Worker budget',
+            style: Theme.of(context)
+                .textTheme
+                .titleMedium
+                ?.copyWith(color: Colors.white),
+          ),
+          const SizedBox(height: 8),
+          if (_perf != null)
+            _buildPerfCard(_perf!)
+          else
+            _buildMessageCard('No canvas frames processed yet.'),
         ],
       ),
     );
@@ -1436,6 +1516,60 @@ class _GraphDebugScreenState extends State<GraphDebugScreen> {
     );
   }
 
+  Widget _buildPerfCard(CanvasPerfSnapshot perf) {
+    final budget = perf.stageSumMs;
+    String ms(double v) => v.toStringAsFixed(v < 10 ? 2 : 1);
+
+    return Card(
+      color: Colors.grey[800],
+      child: Padding(
+        padding: const EdgeInsets.all(8),
+        child: Column(
+          crossAxisAlignment: CrossAxisAlignment.start,
+          children: [
+            _compRow(
+              'Frames',
+              '${perf.frames} (${perf.acceptedFrames} accepted)',
+              null,
+            ),
+            _compRow(
+              'Blobs / frame',
+              '${perf.meanBlobs.toStringAsFixed(1)} '
+                  '(${perf.meanMatched.toStringAsFixed(1)} matched)',
+              null,
+            ),
+            _compRow('Graph nodes', '${perf.nodeCount}', null),
+            const SizedBox(height: 4),
+            for (final stage in perf.stages)
+              _compRow(
+                stage.name,
+                '${ms(stage.meanMs)} / ${ms(stage.p90Ms)} ms'
+                    '${budget > 0 ? '  ${(stage.meanMs / budget * 100).toStringAsFixed(0)}%' : ''}',
+                budget <= 0
+                    ? null
+                    : stage.meanMs / budget >= 0.4
+                        ? _Verdict.different
+                        : stage.meanMs / budget >= 0.2
+                            ? _Verdict.maybe
+                            : null,
+              ),
+            const SizedBox(height: 4),
+            _compRow(
+              'Total',
+              '${ms(perf.total.meanMs)} / ${ms(perf.total.p90Ms)} / '
+                  '${ms(perf.total.p99Ms)} ms',
+              null,
+            ),
+            const Text(
+              'mean / p90 (total: mean / p90 / p99), share of stage sum',
+              style: TextStyle(color: Colors.grey, fontSize: 11),
+            ),
+          ],
+        ),
+      ),
+    );
+  }
+
   Widget _buildMessageCard(String message) {
     return Card(
       color: Colors.grey[800],
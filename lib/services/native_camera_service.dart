@@ -4,7 +4,9 @@ import 'dart:math' as math;
 import 'dart:typed_data';
 import 'dart:ui';
 import 'package:ffi/ffi.dart';
+import '../models/filter_pipeline_stats.dart';
 import '../models/graph_node_info.dart';
+import '../models/person_detector_stats.dart';
 import 'app_logger.dart';
 
 typedef GetTextureIdFunc = Int64 Function();
@@ -47,6 +49,14 @@ typedef SetLiveCropCorners = void Function(Pointer<Double> corners);
 typedef SetFilterParameterFunc = Void Function(Int32 filterId, Float param1);
 typedef SetFilterParameter = void Function(int filterId, double param1);
 
+typedef GetFilterPipelineStatsFunc = Int32 Function(Pointer<Float> buffer, Int32 maxFloats);
+typedef GetFilterPipelineStatsFFI = int Function(Pointer<Float> buffer, int maxFloats);
+
+typedef SetPersonDetectorConfigFunc = Void Function(Int32 backend, Int32 precision, Int32 threads);
+typedef SetPersonDetectorConfigFFI = void Function(int backend, int precision, int threads);
+typedef GetPersonDetectorStatsFunc = Int32 Function(Pointer<Float> buffer, Int32 maxFloats);
+typedef GetPersonDetectorStatsFFI = int Function(Pointer<Float> buffer, int maxFloats);
+
 // Panorama FFI types
 typedef SetPanoramaEnabledFunc = Void Function(Bool enabled);
 typedef SetPanoramaEnabled = void Function(bool enabled);
@@ -126,6 +136,9 @@ typedef GetSortedPositionFunc = Int32 Function(Int32 idx);
 typedef GetSortedPosition = int Function(int idx);
 
 // Graph debug FFI types
+typedef RefreshGraphExportFunc = Void Function();
+typedef RefreshGraphExportFFI = void Function();
+
 typedef GetGraphNodeCountFunc = Int32 Function();
 typedef GetGraphNodeCount = int Function();
 
@@ -174,9 +187,19 @@ typedef GetGraphCanvasBoundsFFI = bool Function(Pointer<Int32> bounds);
 typedef GetGraphNodeContoursFunc = Int32 Function(Pointer<Float> buffer, Int32 maxFloats);
 typedef GetGraphNodeContoursFFI = int Function(Pointer<Float> buffer, int maxFloats);
 
+typedef GetGraphChangesFunc = Int32 Function(
+  Int32 sinceVersion, Pointer<Float> buffer, Int32 maxFloats);
+typedef GetGraphChangesFFI = int Function(
+  int sinceVersion, Pointer<Float> buffer, int maxFloats);
+
 typedef GetGraphNodeMasksFunc = Int32 Function(Pointer<Uint8> buffer, Int32 maxBytes);
 typedef GetGraphNodeMasksFFI = int Function(Pointer<Uint8> buffer, int maxBytes);
 
+typedef GetCanvasPerfSnapshotFunc = Int32 Function(Pointer<Float> buffer, Int32 maxFloats);
+typedef GetCanvasPerfSnapshotFFI = int Function(Pointer<Float> buffer, int maxFloats);
+typedef GetCanvasFrameRingStatsFunc = Int32 Function(Pointer<Float> buffer, Int32 maxFloats);
+typedef GetCanvasFrameRingStatsFFI = int Function(Pointer<Float> buffer, int maxFloats);
+
 typedef CaptureGraphDebugSnapshotFunc = Bool Function(Int32 slot);
 typedef CaptureGraphDebugSnapshotFFI = bool Function(int slot);
 
@@ -280,6 +303,9 @@ class NativeCameraService {
   late GetFrameHeight _getFrameHeight;
   late SetLiveCropCorners _setLiveCropCorners;
   late SetFilterParameter _setFilterParameter;
+  GetFilterPipelineStatsFFI? _getFilterPipelineStats;
+  SetPersonDetectorConfigFFI? _setPersonDetectorConfig;
+  GetPersonDetectorStatsFFI? _getPersonDetectorStats;
 
   // Panorama bindings
   late SetPanoramaEnabled _setPanoramaEnabled;
@@ -374,6 +400,24 @@ class NativeCameraService {
     _setFilterParameter = _nativeLib
         .lookup<NativeFunction<SetFilterParameterFunc>>('SetFilterParameter')
         .asFunction();
+    try {
+      _getFilterPipelineStats = _nativeLib
+          .lookup<NativeFunction<GetFilterPipelineStatsFunc>>('GetFilterPipelineStats')
+          .asFunction();
+    } catch (_) {
+      _getFilterPipelineStats = null;
+    }
+    try {
+      _setPersonDetectorConfig = _nativeLib
+          .lookup<NativeFunction<SetPersonDetectorConfigFunc>>('SetPersonDetectorConfig')
+          .asFunction();
+      _getPersonDetectorStats = _nativeLib
+          .lookup<NativeFunction<GetPersonDetectorStatsFunc>>('GetPersonDetectorStats')
+          .asFunction();
+    } catch (_) {
+      _setPersonDetectorConfig = null;
+      _getPersonDetectorStats = null;
+    }
 
     // Panorama bindings
     _setPanoramaEnabled = _nativeLib
@@ -603,6 +647,101 @@ class NativeCameraService {
     _setFilterParameter(filterId, value);
   }
 
+  /// Returns depth, queue occupancy and drop counters of the live filter
+  /// pipeline, or null when the DLL does not export them.
+  FilterPipelineStats? getFilterPipelineStats() {
+    initialize();
+    if (_getFilterPipelineStats == null) return null;
+
+    // Header + one row per filter; generous so a long filter chain still fits.
+    const maxFloats = 256;
+    final buffer = malloc.allocate<Float>(maxFloats * sizeOf<Float>());
+    try {
+      final written = _getFilterPipelineStats!(buffer, maxFloats);
+      if (written < 8) return null;
+      final data = buffer.asTypedList(written);
+      if (data[0].toInt() != 1) return null;
+      final stageCount = data[1].toInt();
+      final rowFloats = data[7].toInt();
+      if (rowFloats < 7 || 8 + stageCount * rowFloats > written) return null;
+
+      return FilterPipelineStats(
+        inFlight: data[2].toInt(),
+        maxInFlight: data[3].toInt(),
+        submitted: data[4].toInt(),
+        completed: data[5].toInt(),
+        dropped: data[6].toInt(),
+        stages: [
+          for (int i = 0; i < stageCount; i++)
+            FilterStageStats(
+              filterId: data[8 + i * rowFloats].toInt(),
+              ordered: data[8 + i * rowFloats + 1] != 0,
+              workers: data[8 + i * rowFloats + 2].toInt(),
+              queued: data[8 + i * rowFloats + 3].toInt(),
+              peakQueued: data[8 + i * rowFloats + 4].toInt(),
+              processed: data[8 + i * rowFloats + 5].toInt(),
+              meanMs: data[8 + i * rowFloats + 6],
+            ),
+        ],
+      );
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
+  /// Switches the person detector's backend, model precision and OpenCV
+  /// thread count (0 = all cores). The model reloads in the background.
+  void setPersonDetectorConfig({
+    PersonDetectorBackend backend = PersonDetectorBackend.openCvCpu,
+    PersonDetectorPrecision precision = PersonDetectorPrecision.fp32,
+    int threads = 0,
+  }) {
+    initialize();
+    _setPersonDetectorConfig?.call(backend.index, precision.index, threads);
+  }
+
+  /// Returns load state and inference latency of the person detector, or
+  /// null when the DLL does not export them.
+  PersonDetectorStats? getPersonDetectorStats() {
+    initialize();
+    if (_getPersonDetectorStats == null) return null;
+
+    const maxFloats = 16;
+    final buffer = malloc.allocate<Float>(maxFloats * sizeOf<Float>());
+    try {
+      final written = _getPersonDetectorStats!(buffer, maxFloats);
+      if (written < maxFloats) return null;
+      final data = buffer.asTypedList(written);
+      if (data[0].toInt() != 1) return null;
+
+      PersonDetectorBackend backend(double v) => PersonDetectorBackend
+          .values[v.toInt().clamp(0, PersonDetectorBackend.values.length - 1)];
+      PersonDetectorPrecision precision(double v) => PersonDetectorPrecision
+          .values[v.toInt().clamp(0, PersonDetectorPrecision.values.length - 1)];
+
+      return PersonDetectorStats(
+        state: PersonDetectorState
+            .values[data[1].toInt().clamp(0, PersonDetectorState.values.length - 1)],
+        requestedBackend: backend(data[2]),
+        activeBackend: backend(data[3]),
+        requestedPrecision: precision(data[4]),
+        activePrecision: precision(data[5]),
+        threads: data[6].toInt(),
+        loadMs: data[7],
+        warmUpMs: data[8],
+        inferences: data[9].toInt(),
+        samples: data[10].toInt(),
+        lastMs: data[11],
+        meanMs: data[12],
+        p50Ms: data[13],
+        p90Ms: data[14],
+        maxMs: data[15],
+      );
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
   // --- Panorama Methods ---
 
   /// Enable or disable panorama mode
@@ -1129,6 +1268,7 @@ class NativeCameraService {
 
   // --- Graph Debug Methods ---
 
+  RefreshGraphExportFFI? _refreshGraphExport;
   late GetGraphNodeCount _getGraphNodeCount;
   late GetGraphNodesFFI _getGraphNodes;
   late GetGraphHardEdgesFFI _getGraphHardEdges;
@@ -1141,7 +1281,10 @@ class NativeCameraService {
   late LockAllGraphNodesFFI _lockAllGraphNodes;
   late GetGraphCanvasBoundsFFI _getGraphCanvasBounds;
   GetGraphNodeContoursFFI? _getGraphNodeContours;
+  GetGraphChangesFFI? _getGraphChanges;
   GetGraphNodeMasksFFI? _getGraphNodeMasks;
+  GetCanvasPerfSnapshotFFI? _getCanvasPerfSnapshot;
+  GetCanvasFrameRingStatsFFI? _getCanvasFrameRingStats;
   late CaptureGraphDebugSnapshotFFI _captureGraphDebugSnapshot;
   late GetGraphSnapshotNodeCountFFI _getGraphSnapshotNodeCount;
   late GetGraphSnapshotNodesFFI _getGraphSnapshotNodes;
@@ -1164,6 +1307,16 @@ class NativeCameraService {
     }
     AppLogger.ffi('_initializeGraphDebug: base initialize() done');
 
+    try {
+      _refreshGraphExport = _nativeLib
+          .lookup<NativeFunction<RefreshGraphExportFunc>>('RefreshGraphExport')
+          .asFunction();
+      AppLogger.ffi('  lookup RefreshGraphExport: OK');
+    } catch (e) {
+      _refreshGraphExport = null;
+      AppLogger.ffi('  lookup RefreshGraphExport: not found (optional) - $e');
+    }
+
     try {
       _getGraphNodeCount = _nativeLib
           .lookup<NativeFunction<GetGraphNodeCountFunc>>('GetGraphNodeCount')
@@ -1274,6 +1427,16 @@ class NativeCameraService {
       AppLogger.ffi('  lookup GetGraphNodeContours: not found (optional) - $e');
     }
 
+    try {
+      _getGraphChanges = _nativeLib
+          .lookup<NativeFunction<GetGraphChangesFunc>>('GetGraphChanges')
+          .asFunction();
+      AppLogger.ffi('  lookup GetGraphChanges: OK');
+    } catch (e) {
+      _getGraphChanges = null;
+      AppLogger.ffi('  lookup GetGraphChanges: not found (optional) - $e');
+    }
+
     try {
       _getGraphNodeMasks = _nativeLib
           .lookup<NativeFunction<GetGraphNodeMasksFunc>>('GetGraphNodeMasks')
@@ -1284,6 +1447,26 @@ class NativeCameraService {
       AppLogger.ffi('  lookup GetGraphNodeMasks: not found (optional) - $e');
     }
 
+    try {
+      _getCanvasPerfSnapshot = _nativeLib
+          .lookup<NativeFunction<GetCanvasPerfSnapshotFunc>>('GetCanvasPerfSnapshot')
+          .asFunction();
+      AppLogger.ffi('  lookup GetCanvasPerfSnapshot: OK');
+    } catch (e) {
+      _getCanvasPerfSnapshot = null;
+      AppLogger.ffi('  lookup GetCanvasPerfSnapshot: not found (optional) - $e');
+    }
+
+    try {
+      _getCanvasFrameRingStats = _nativeLib
+          .lookup<NativeFunction<GetCanvasFrameRingStatsFunc>>('GetCanvasFrameRingStats')
+          .asFunction();
+      AppLogger.ffi('  lookup GetCanvasFrameRingStats: OK');
+    } catch (e) {
+      _getCanvasFrameRingStats = null;
+      AppLogger.ffi('  lookup GetCanvasFrameRingStats: not found (optional) - $e');
+    }
+
     try {
       _captureGraphDebugSnapshot = _nativeLib
           .lookup<NativeFunction<CaptureGraphDebugSnapshotFunc>>(
@@ -1476,6 +1659,13 @@ class NativeCameraService {
     }
   }
 
+  /// Brings the graph the getters below read up to date. Call once per
+  /// refresh, before the first getter.
+  void refreshGraphExport() {
+    _initializeGraphDebug();
+    _refreshGraphExport?.call();
+  }
+
   int getGraphNodeCount() {
     _initializeGraphDebug();
     final count = _getGraphNodeCount();
@@ -1644,6 +1834,76 @@ class NativeCameraService {
     );
   }
 
+  /// Returns the graph changes after [sinceVersion] (-1 = only learn the
+  /// current version), or null when the DLL lacks them.
+  GraphChangeSet? getGraphChanges(int sinceVersion) {
+    _initializeGraphDebug();
+    if (_getGraphChanges == null) return null;
+
+    // Matches the largest change set the helper process hands over (4 MB).
+    const maxFloats = 1 << 20;
+    const headerFloats = 12;
+    const eventFloats = 4;
+    final buffer = malloc.allocate<Float>(maxFloats * sizeOf<Float>());
+    try {
+      final written = _getGraphChanges!(sinceVersion, buffer, maxFloats);
+      if (written < headerFloats) return null;
+      final data = buffer.asTypedList(written);
+      if (data[0].toInt() != 1) return null;
+
+      final events = <GraphChangeEvent>[];
+      final eventCount = data[3].toInt();
+      int offset = headerFloats;
+      for (int i = 0; i < eventCount && offset + eventFloats <= written; i++) {
+        final typeIndex = data[offset].toInt() - 1;
+        final payload = offset + eventFloats;
+        final payloadFloats = data[offset + 3].toInt();
+        if (typeIndex < 0 ||
+            typeIndex >= GraphChangeType.values.length ||
+            payloadFloats < 0 ||
+            payload + payloadFloats > written) {
+          break;
+        }
+        GraphNodeInfo? node;
+        List<Offset>? contour;
+        if (payloadFloats >= 24) {
+          node = _decodeGraphNodes(buffer + payload, 1).single;
+        }
+        if (payloadFloats > 24) {
+          final numPoints = data[payload + 24].toInt();
+          contour = [
+            for (int j = 0; j < numPoints && 26 + j * 2 < payloadFloats; j++)
+              Offset(data[payload + 25 + j * 2], data[payload + 26 + j * 2]),
+          ];
+        }
+        events.add(GraphChangeEvent(
+          type: GraphChangeType.values[typeIndex],
+          firstId: data[offset + 1].toInt(),
+          secondId: data[offset + 2].toInt(),
+          node: node,
+          contour: contour,
+        ));
+        offset = payload + payloadFloats;
+      }
+      AppLogger.graphDebug(
+          'getGraphChanges($sinceVersion): ${events.length} events, '
+          'version ${data[2].toInt()}/${data[5].toInt()}, full=${data[4] != 0}');
+
+      return GraphChangeSet(
+        sinceVersion: sinceVersion,
+        version: data[2].toInt(),
+        latestVersion: data[5].toInt(),
+        needsFullSnapshot: data[4] != 0,
+        canvasBounds: data[7] != 0
+            ? Rect.fromLTRB(data[8], data[9], data[10], data[11])
+            : null,
+        events: events,
+      );
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
   /// Returns per-node RGBA mask images: {nodeId: NodeMaskImage(width, height, rgbaBytes)}.
   /// Color pixels on white transparent background.
   Map<int, NodeMaskImage> getGraphNodeMasks() {
@@ -1692,6 +1952,99 @@ class NativeCameraService {
     }
   }
 
+  /// Returns per-stage timings of the recent canvas worker frames, or null
+  /// when the DLL does not export them or no frame has been processed yet.
+  CanvasPerfSnapshot? getCanvasPerfSnapshot() {
+    _initializeGraphDebug();
+    if (_getCanvasPerfSnapshot == null) return null;
+
+    // Header + bin edges + rows; generous so a newer layout still fits.
+    const maxFloats = 1024;
+    final buffer = malloc.allocate<Float>(maxFloats * sizeOf<Float>());
+    try {
+      final written = _getCanvasPerfSnapshot!(buffer, maxFloats);
+      if (written < 8) return null;
+      final data = buffer.asTypedList(written);
+      if (data[0].toInt() != 1) {
+        AppLogger.graphDebug('getCanvasPerfSnapshot: unknown layout ${data[0]}');
+        return null;
+      }
+      final frames = data[1].toInt();
+      final rowCount = data[3].toInt();
+      final binCount = data[4].toInt();
+      final rowFloats = 5 + binCount;
+      final rowsStart = 8 + binCount;
+      if (frames <= 0 || rowCount < 1 || rowsStart + rowCount * rowFloats > written) {
+        return null;
+      }
+
+      CanvasStageTiming readRow(int row, String name, int samples) {
+        final base = rowsStart + row * rowFloats;
+        return CanvasStageTiming(
+          name: name,
+          samples: samples,
+          meanMs: data[base],
+          p50Ms: data[base + 1],
+          p90Ms: data[base + 2],
+          p99Ms: data[base + 3],
+          maxMs: data[base + 4],
+          histogram: [for (int b = 0; b < binCount; b++) data[base + 5 + b].toInt()],
+        );
+      }
+
+      final accepted = data[2].toInt();
+      final stageCount = rowCount - 1;
+      final stages = <CanvasStageTiming>[];
+      for (int i = 0; i < stageCount; i++) {
+        final name = i < CanvasPerfSnapshot.stageNames.length
+            ? CanvasPerfSnapshot.stageNames[i]
+            : 'Stage $i';
+        // Stages after the motion gate only run on accepted frames.
+        stages.add(readRow(i, name, i <= 1 ? frames : accepted));
+      }
+
+      return CanvasPerfSnapshot(
+        frames: frames,
+        acceptedFrames: accepted,
+        meanBlobs: data[5],
+        meanMatched: data[6],
+        nodeCount: data[7].toInt(),
+        binUpperEdgesMs: [for (int b = 0; b < binCount; b++) data[8 + b]],
+        stages: stages,
+        total: readRow(stageCount, 'Total', frames),
+      );
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
+  /// Returns submit/drop counters of the frame ring feeding the canvas helper
+  /// process, or null when the canvas runs in-process or the DLL lacks them.
+  CanvasFrameRingStats? getCanvasFrameRingStats() {
+    _initializeGraphDebug();
+    if (_getCanvasFrameRingStats == null) return null;
+
+    const maxFloats = 8;
+    final buffer = malloc.allocate<Float>(maxFloats * sizeOf<Float>());
+    try {
+      final written = _getCanvasFrameRingStats!(buffer, maxFloats);
+      if (written < maxFloats) return null;
+      final data = buffer.asTypedList(written);
+      if (data[0].toInt() != 1) return null;
+      return CanvasFrameRingStats(
+        slots: data[1].toInt(),
+        submitted: data[2].toInt(),
+        consumed: data[3].toInt(),
+        overwritten: data[4].toInt(),
+        discarded: data[5].toInt(),
+        framePending: data[6] != 0,
+        lastConsumedFrameId: data[7].toInt(),
+      );
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
   bool captureGraphSnapshot(int slot) {
     _initializeGraphDebug();
     final ok = _captureGraphDebugSnapshot(slot);
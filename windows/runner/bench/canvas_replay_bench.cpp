@@ -0,0 +1,335 @@
+// ============================================================================
+// canvas_replay_bench.cpp -- Replay a recorded lecture through the canvas core
+//
+// Feeds frames (image directory or video) plus optional person masks through
+// WhiteboardCanvas::ProcessFrameSync on the calling thread and reports
+// per-stage latency percentiles and frames/sec. Decoding is excluded from all
+// timings.
+//
+// Usage:
+//   canvas_replay_bench --frames <dir|video> [--masks <dir|video>]
+//                       [--max-frames N] [--warmup N] [--render-mode stroke|raw]
+//                       [--csv out.csv] [--verify-shape-pass]
+//
+// Masks are matched to frames by index (sorted file name or video position),
+// thresholded at 127 and resized to the frame if needed. Without masks every
+// frame gets an empty person mask.
+//
+// --verify-shape-pass also runs the exhaustive global shape scan on every
+// matched frame, reports how often the top-k index picked a different node
+// offset, and fails if the rough offset moves by more than
+// kShapePassOffsetTolerance px on any frame. Timings then include the scan.
+// ============================================================================
+
+#include "whiteboard_canvas.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    std::string frames_path;
+    std::string masks_path;
+    int max_frames = -1;
+    int warmup_frames = 0;
+    CanvasRenderMode render_mode = CanvasRenderMode::kRaw;
+    std::string csv_path;
+    bool verify_shape_pass = false;
+};
+
+// Largest rough-offset difference between the top-k and exhaustive global shape
+// pass that --verify-shape-pass accepts; step 2 re-matches around it anyway.
+constexpr float kShapePassOffsetTolerance = 2.0f;
+
+// Sequential reader over either a directory of images or a video file.
+class FrameSource {
+public:
+    bool Open(const std::string& path, bool grayscale) {
+        grayscale_ = grayscale;
+        std::vector<cv::String> files;
+        try {
+            cv::glob(path, files, false);
+        } catch (const cv::Exception&) {
+            files.clear();
+        }
+        for (const auto& f : files) {
+            if (IsImageFile(f)) files_.push_back(f);
+        }
+        if (!files_.empty()) {
+            std::sort(files_.begin(), files_.end());
+            return true;
+        }
+        return capture_.open(path);
+    }
+
+    bool Read(cv::Mat& out) {
+        if (!files_.empty()) {
+            if (next_ >= files_.size()) return false;
+            out = cv::imread(files_[next_++],
+                             grayscale_ ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+            return !out.empty();
+        }
+        if (!capture_.isOpened() || !capture_.read(out) || out.empty()) return false;
+        if (grayscale_ && out.channels() != 1)
+            cv::cvtColor(out, out, cv::COLOR_BGR2GRAY);
+        return true;
+    }
+
+private:
+    static bool IsImageFile(const std::string& name) {
+        static const char* kExtensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff"};
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return (char)std::tolower(c); });
+        for (const char* ext : kExtensions) {
+            const std::string e(ext);
+            if (lower.size() >= e.size() &&
+                lower.compare(lower.size() - e.size(), e.size(), e) == 0) return true;
+        }
+        return false;
+    }
+
+    std::vector<std::string> files_;
+    size_t next_ = 0;
+    cv::VideoCapture capture_;
+    bool grayscale_ = false;
+};
+
+// Latency distribution of one row of the report.
+struct LatencySeries {
+    std::vector<double> samples;
+
+    void Add(double ms) { samples.push_back(ms); }
+
+    // Nearest-rank percentile; p in [0, 100].
+    double Percentile(double p) const {
+        if (samples.empty()) return 0.0;
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = (size_t)std::ceil(p / 100.0 * (double)sorted.size());
+        rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+        return sorted[rank - 1];
+    }
+
+    double Mean() const {
+        if (samples.empty()) return 0.0;
+        double sum = 0.0;
+        for (double s : samples) sum += s;
+        return sum / (double)samples.size();
+    }
+};
+
+const char* StageName(int stage) {
+    switch (static_cast<CanvasStage>(stage)) {
+        case CanvasStage::kNoUpdateMask: return "no_update_mask";
+        case CanvasStage::kMotionGate:   return "motion_gate";
+        case CanvasStage::kBinarize:     return "binarize";
+        case CanvasStage::kExtract:      return "extract_blobs";
+        case CanvasStage::kEnhance:      return "enhance_filter";
+        case CanvasStage::kMatch:        return "match";
+        case CanvasStage::kUpdate:       return "update_graph";
+        default:                         return "?";
+    }
+}
+
+void PrintUsage() {
+    std::cerr << "usage: canvas_replay_bench --frames <dir|video> [--masks <dir|video>]\n"
+                 "                           [--max-frames N] [--warmup N]\n"
+                 "                           [--render-mode stroke|raw] [--csv out.csv]\n"
+                 "                           [--verify-shape-pass]\n";
+}
+
+bool ParseOptions(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&](std::string& out) {
+            if (i + 1 >= argc) return false;
+            out = argv[++i];
+            return true;
+        };
+        std::string value;
+        if (arg == "--frames") {
+            if (!next(opts.frames_path)) return false;
+        } else if (arg == "--masks") {
+            if (!next(opts.masks_path)) return false;
+        } else if (arg == "--max-frames") {
+            if (!next(value)) return false;
+            opts.max_frames = std::atoi(value.c_str());
+        } else if (arg == "--warmup") {
+            if (!next(value)) return false;
+            opts.warmup_frames = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--render-mode") {
+            if (!next(value)) return false;
+            if (value == "stroke") opts.render_mode = CanvasRenderMode::kStroke;
+            else if (value == "raw") opts.render_mode = CanvasRenderMode::kRaw;
+            else return false;
+        } else if (arg == "--csv") {
+            if (!next(opts.csv_path)) return false;
+        } else if (arg == "--verify-shape-pass") {
+            opts.verify_shape_pass = true;
+        } else {
+            return false;
+        }
+    }
+    return !opts.frames_path.empty();
+}
+
+cv::Mat PrepareMask(const cv::Mat& raw_mask, const cv::Size& frame_size) {
+    if (raw_mask.empty()) return cv::Mat::zeros(frame_size, CV_8UC1);
+    cv::Mat mask = raw_mask;
+    if (mask.size() != frame_size)
+        cv::resize(mask, mask, frame_size, 0, 0, cv::INTER_NEAREST);
+    cv::threshold(mask, mask, 127, 255, cv::THRESH_BINARY);
+    return mask;
+}
+
+void PrintRow(const char* name, const LatencySeries& series) {
+    std::printf("  %-16s %7zu %9.3f %9.3f %9.3f %9.3f %9.3f\n", name,
+                series.samples.size(), series.Mean(), series.Percentile(50),
+                series.Percentile(90), series.Percentile(99), series.Percentile(100));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        PrintUsage();
+        return 2;
+    }
+
+    FrameSource frames;
+    if (!frames.Open(opts.frames_path, false)) {
+        std::cerr << "Cannot open frames: " << opts.frames_path << std::endl;
+        return 1;
+    }
+    FrameSource masks;
+    const bool has_masks = !opts.masks_path.empty();
+    if (has_masks && !masks.Open(opts.masks_path, true)) {
+        std::cerr << "Cannot open masks: " << opts.masks_path << std::endl;
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!opts.csv_path.empty()) {
+        csv.open(opts.csv_path);
+        if (!csv) {
+            std::cerr << "Cannot write CSV: " << opts.csv_path << std::endl;
+            return 1;
+        }
+        csv << "frame,accepted,total_ms";
+        for (int s = 0; s < kCanvasStageCount; s++) csv << ',' << StageName(s) << "_ms";
+        csv << ",blobs,matched,nodes\n";
+    }
+
+    WhiteboardCanvas canvas(CanvasExecutionMode::kInline);
+    canvas.SetRenderMode(opts.render_mode);
+    canvas.SetVerifyGlobalShapePass(opts.verify_shape_pass);
+
+    LatencySeries stage_series[kCanvasStageCount];
+    LatencySeries total_all;
+    LatencySeries total_accepted;
+    double busy_ms = 0.0;
+    long long blob_sum = 0, matched_sum = 0;
+    int measured = 0, accepted = 0, last_node_count = 0, index = 0;
+    long long shape_checked = 0, shape_mismatches = 0;
+    int shape_frames = 0, shape_frames_over = 0;
+    float shape_max_error = 0.0f;
+
+    cv::Mat frame, raw_mask;
+    while (opts.max_frames < 0 || index < opts.max_frames) {
+        if (!frames.Read(frame)) break;
+        if (frame.channels() == 4) cv::cvtColor(frame, frame, cv::COLOR_BGRA2BGR);
+        if (frame.type() != CV_8UC3) {
+            std::cerr << "Skipping frame " << index << ": unsupported type" << std::endl;
+            index++;
+            continue;
+        }
+        raw_mask.release();
+        if (has_masks) masks.Read(raw_mask);
+        const cv::Mat person_mask = PrepareMask(raw_mask, frame.size());
+
+        CanvasFrameStats stats;
+        if (!canvas.ProcessFrameSync(frame, person_mask, &stats)) {
+            std::cerr << "Frame " << index << " rejected" << std::endl;
+            index++;
+            continue;
+        }
+        if (stats.accepted) last_node_count = stats.node_count;
+        if (stats.shape_check_blobs > 0 || stats.shape_check_mismatches > 0) {
+            shape_frames++;
+            shape_checked += stats.shape_check_blobs;
+            shape_mismatches += stats.shape_check_mismatches;
+            shape_max_error = std::max(shape_max_error, stats.shape_check_offset_error);
+            if (stats.shape_check_offset_error > kShapePassOffsetTolerance) {
+                shape_frames_over++;
+                std::cerr << "Frame " << index << ": top-k rough offset is "
+                          << stats.shape_check_offset_error
+                          << " px from the exhaustive scan" << std::endl;
+            }
+        }
+
+        if (csv.is_open()) {
+            csv << index << ',' << (stats.accepted ? 1 : 0) << ',' << stats.total_ms;
+            for (int s = 0; s < kCanvasStageCount; s++) csv << ',' << stats.stage_ms[s];
+            csv << ',' << stats.blob_count << ',' << stats.matched_count
+                << ',' << stats.node_count << '\n';
+        }
+
+        if (index++ < opts.warmup_frames) continue;
+        measured++;
+        busy_ms += stats.total_ms;
+        total_all.Add(stats.total_ms);
+        // Stages up to the motion gate run on every frame; the rest only on
+        // accepted ones, so gated frames would otherwise skew them toward 0.
+        for (int s = 0; s <= static_cast<int>(CanvasStage::kMotionGate); s++)
+            stage_series[s].Add(stats.stage_ms[s]);
+        if (!stats.accepted) continue;
+        accepted++;
+        total_accepted.Add(stats.total_ms);
+        blob_sum += stats.blob_count;
+        matched_sum += stats.matched_count;
+        for (int s = static_cast<int>(CanvasStage::kMotionGate) + 1; s < kCanvasStageCount; s++)
+            stage_series[s].Add(stats.stage_ms[s]);
+    }
+
+    if (measured == 0) {
+        std::cerr << "No frames measured (read " << index << ", warmup "
+                  << opts.warmup_frames << ")" << std::endl;
+        return 1;
+    }
+
+    std::printf("canvas_replay_bench: %d frames measured (%d accepted, %d motion-gated), "
+                "warmup %d\n", measured, accepted, measured - accepted, opts.warmup_frames);
+    std::printf("  %-16s %7s %9s %9s %9s %9s %9s\n", "stage [ms]", "n", "mean", "p50",
+                "p90", "p99", "max");
+    for (int s = 0; s < kCanvasStageCount; s++) PrintRow(StageName(s), stage_series[s]);
+    PrintRow("total(all)", total_all);
+    PrintRow("total(accepted)", total_accepted);
+
+    const double fps = busy_ms > 0.0 ? 1000.0 * measured / busy_ms : 0.0;
+    std::printf("throughput: %.2f frames/s over %.1f ms of pipeline time\n", fps, busy_ms);
+    if (accepted > 0) {
+        std::printf("per accepted frame: %.1f blobs, %.1f matched; final graph %d nodes, "
+                    "canvas version %llu\n",
+                    (double)blob_sum / accepted, (double)matched_sum / accepted,
+                    last_node_count, (unsigned long long)canvas.GetCanvasVersion());
+    }
+    if (opts.verify_shape_pass) {
+        std::printf("shape pass check: %d frames, %lld blobs matched exhaustively, "
+                    "%lld with a different top-k offset; rough offset max error %.2f px, "
+                    "%d frames over %.1f px\n",
+                    shape_frames, shape_checked, shape_mismatches, shape_max_error,
+                    shape_frames_over, kShapePassOffsetTolerance);
+        if (shape_frames_over > 0) return 1;
+    }
+    return 0;
+}
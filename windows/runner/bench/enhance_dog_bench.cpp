@@ -0,0 +1,165 @@
+// ============================================================================
+// enhance_dog_bench.cpp -- Dense vs separable DoG in WhiteboardEnhance
+//
+// Times the reference 31x31 filter2D DoG against the separable path on 1080p
+// and 4K frames, and checks the separable output against the reference. Also
+// times the full serial WhiteboardEnhance against the strip-parallel variant
+// and checks that both produce identical images, once with the separable DoG
+// and once with the dense one (the strips must match the full frame in either
+// mode). With --reference-dog it also
+// times WhiteboardEnhance with the dense DoG switched on process-wide
+// (SetWhiteboardEnhanceReferenceDoG) and reports how far the end-to-end output
+// moves.
+// Frames are synthetic (board-like background, noise and dark strokes) unless
+// --image is given, in which case that image is resized to each resolution.
+//
+// Usage:
+//   enhance_dog_bench [--image board.png] [--iterations N] [--reference-dog]
+// ============================================================================
+
+#include "whiteboard_enhance.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+cv::Mat MakeSyntheticBoard(const cv::Size& size) {
+    cv::Mat board(size, CV_8UC3);
+    cv::randn(board, cv::Scalar(215, 220, 225), cv::Scalar(6, 6, 6));
+    cv::RNG rng(12345);
+    const int strokes = size.area() / 4000;
+    for (int i = 0; i < strokes; i++) {
+        cv::Point a(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::Point b(a.x + rng.uniform(-60, 60), a.y + rng.uniform(-30, 30));
+        const int shade = rng.uniform(10, 90);
+        cv::line(board, a, b, cv::Scalar(shade, shade, shade + rng.uniform(0, 120)),
+                 rng.uniform(2, 5), cv::LINE_AA);
+    }
+    return board;
+}
+
+template <typename Fn>
+double MeanMs(int iterations, Fn&& fn) {
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++) {
+        const auto t0 = SteadyClock::now();
+        fn();
+        total += std::chrono::duration<double, std::milli>(SteadyClock::now() - t0).count();
+    }
+    return total / std::max(1, iterations);
+}
+
+void Compare(const cv::Mat& reference, const cv::Mat& candidate,
+             double& max_abs, double& differing_fraction) {
+    cv::Mat diff;
+    cv::absdiff(reference, candidate, diff);
+    cv::minMaxLoc(diff.reshape(1), nullptr, &max_abs);
+    differing_fraction = (double)cv::countNonZero(diff.reshape(1)) / (double)diff.total() /
+                         (double)diff.channels();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string image_path;
+    int iterations = 5;
+    bool reference_dog = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--image") && i + 1 < argc) {
+            image_path = argv[++i];
+        } else if (!std::strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--reference-dog")) {
+            reference_dog = true;
+        } else {
+            std::fprintf(stderr, "usage: enhance_dog_bench [--image board.png] [--iterations N]"
+                                 " [--reference-dog]\n");
+            return 2;
+        }
+    }
+
+    cv::Mat source;
+    if (!image_path.empty()) {
+        source = cv::imread(image_path, cv::IMREAD_COLOR);
+        if (source.empty()) {
+            std::fprintf(stderr, "Cannot read image: %s\n", image_path.c_str());
+            return 1;
+        }
+    }
+
+    const cv::Size sizes[] = {cv::Size(1920, 1080), cv::Size(3840, 2160)};
+    std::printf("threads: %d\n", cv::getNumThreads());
+    std::printf("%-10s %12s %12s %8s %10s %12s %12s %12s %8s\n", "size", "dense [ms]",
+                "sep [ms]", "speedup", "max |d|", "differing", "enhance [ms]",
+                "parallel [ms]", "speedup");
+    for (const auto& size : sizes) {
+        cv::Mat frame;
+        if (source.empty()) frame = MakeSyntheticBoard(size);
+        else cv::resize(source, frame, size, 0, 0, cv::INTER_AREA);
+
+        cv::Mat reference, separable;
+        const double dense_ms = MeanMs(iterations, [&] {
+            reference = WhiteboardDoG(frame, WhiteboardDoGMode::kReference);
+        });
+        const double sep_ms = MeanMs(iterations, [&] {
+            separable = WhiteboardDoG(frame, WhiteboardDoGMode::kSeparable);
+        });
+        cv::Mat serial_out, parallel_out;
+        const double enhance_ms = MeanMs(iterations, [&] {
+            serial_out = WhiteboardEnhance(frame);
+        });
+        const double parallel_ms = MeanMs(iterations, [&] {
+            parallel_out = WhiteboardEnhanceParallel(frame);
+        });
+
+        double max_abs = 0.0, differing = 0.0;
+        Compare(reference, separable, max_abs, differing);
+        double parallel_abs = 0.0, parallel_differing = 0.0;
+        Compare(serial_out, parallel_out, parallel_abs, parallel_differing);
+        std::printf("%4dx%-5d %12.2f %12.2f %7.1fx %10.0f %11.4f%% %12.2f %12.2f %7.1fx\n",
+                    size.width, size.height, dense_ms, sep_ms,
+                    dense_ms / std::max(1e-6, sep_ms), max_abs, differing * 100.0, enhance_ms,
+                    parallel_ms, enhance_ms / std::max(1e-6, parallel_ms));
+        SetWhiteboardEnhanceReferenceDoG(true);
+        cv::Mat reference_out = WhiteboardEnhance(frame);
+        double dense_parallel_abs = 0.0, dense_parallel_differing = 0.0;
+        Compare(reference_out, WhiteboardEnhanceParallel(frame), dense_parallel_abs,
+                dense_parallel_differing);
+        SetWhiteboardEnhanceReferenceDoG(false);
+        std::printf("%10s parallel vs serial with dense DoG: max |d| %.0f, %.4f%% differing\n",
+                    "", dense_parallel_abs, dense_parallel_differing * 100.0);
+        if (reference_dog) {
+            SetWhiteboardEnhanceReferenceDoG(true);
+            const double reference_ms = MeanMs(iterations, [&] {
+                reference_out = WhiteboardEnhance(frame);
+            });
+            SetWhiteboardEnhanceReferenceDoG(false);
+            double enhance_abs = 0.0, enhance_differing = 0.0;
+            Compare(reference_out, serial_out, enhance_abs, enhance_differing);
+            std::printf("%10s enhance with dense DoG: %.2f ms, max |d| %.0f, %.4f%% differing\n",
+                        "", reference_ms, enhance_abs, enhance_differing * 100.0);
+        }
+        if (max_abs > 1.0) {
+            std::fprintf(stderr, "separable DoG exceeds the +-1 error bound\n");
+            return 1;
+        }
+        if (parallel_abs > 0.0) {
+            std::fprintf(stderr, "parallel WhiteboardEnhance differs from the serial path\n");
+            return 1;
+        }
+        if (dense_parallel_abs > 0.0) {
+            std::fprintf(stderr, "parallel WhiteboardEnhance with the dense DoG differs from"
+                                 " the serial path\n");
+            return 1;
+        }
+    }
+    return 0;
+}
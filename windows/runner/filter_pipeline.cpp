@@ -0,0 +1,229 @@
+#include "filter_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+FilterPipeline::FilterPipeline(FilterFn filter, SinkFn sink,
+                               std::function<bool(int32_t)> is_stateful)
+    : filter_(std::move(filter)),
+      sink_(std::move(sink)),
+      is_stateful_(std::move(is_stateful)) {}
+
+FilterPipeline::~FilterPipeline() {
+    Stop();
+}
+
+void FilterPipeline::Configure(const std::vector<int>& modes) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (modes == modes_) return;
+        DrainLocked(lock);
+    }
+    StopStages();
+    StartStages(modes);
+}
+
+bool FilterPipeline::Submit(cv::Mat&& frame, bool apply_filters) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    submitted_++;
+    if (in_flight_ >= max_in_flight_) {
+        dropped_++;
+        // Latest wins: the newest frame no stage has started yet is stale now.
+        if (!stages_.empty() && !stages_.front()->inbox.empty()) {
+            Item& stale = stages_.front()->inbox.rbegin()->second;
+            stale.frame = std::move(frame);
+            stale.apply_filters = apply_filters;
+            return true;
+        }
+        return false;
+    }
+
+    const uint64_t seq = next_seq_++;
+    in_flight_++;
+    Item item{std::move(frame), apply_filters};
+    if (stages_.empty()) {
+        lock.unlock();
+        Deliver(seq, std::move(item));
+        return true;
+    }
+
+    Stage& first = *stages_.front();
+    first.inbox.emplace(seq, std::move(item));
+    first.peak_occupancy = std::max(first.peak_occupancy, static_cast<int>(first.inbox.size()));
+    first.cv.notify_one();
+    return true;
+}
+
+uint64_t FilterPipeline::NextSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_seq_;
+}
+
+void FilterPipeline::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        DrainLocked(lock);
+    }
+    StopStages();
+    std::lock_guard<std::mutex> lock(mutex_);
+    modes_.clear();
+    max_in_flight_ = 2;
+}
+
+int FilterPipeline::GetStats(float* buffer, int max_floats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int stage_count = static_cast<int>(stages_.size());
+    const int total = kFilterPipelineHeaderFloats + stage_count * kFilterPipelineStageFloats;
+    if (!buffer || max_floats < total) return 0;
+
+    buffer[0] = static_cast<float>(kFilterPipelineStatsVersion);
+    buffer[1] = static_cast<float>(stage_count);
+    buffer[2] = static_cast<float>(in_flight_);
+    buffer[3] = static_cast<float>(max_in_flight_);
+    buffer[4] = static_cast<float>(submitted_);
+    buffer[5] = static_cast<float>(completed_);
+    buffer[6] = static_cast<float>(dropped_);
+    buffer[7] = static_cast<float>(kFilterPipelineStageFloats);
+
+    float* row = buffer + kFilterPipelineHeaderFloats;
+    for (const auto& stage : stages_) {
+        row[0] = static_cast<float>(stage->modes.front());
+        row[1] = stage->ordered ? 1.0f : 0.0f;
+        row[2] = static_cast<float>(stage->workers.size());
+        row[3] = static_cast<float>(stage->inbox.size());
+        row[4] = static_cast<float>(stage->peak_occupancy);
+        row[5] = static_cast<float>(stage->processed);
+        row[6] = stage->processed > 0
+            ? static_cast<float>(stage->busy_ms / static_cast<double>(stage->processed))
+            : 0.0f;
+        row += kFilterPipelineStageFloats;
+    }
+    return total;
+}
+
+void FilterPipeline::StartStages(const std::vector<int>& modes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    modes_ = modes;
+    for (int mode : modes) {
+        const bool stateful = is_stateful_(mode);
+        if (stateful) {
+            // A repeated stateful mode: fold its first stage and everything
+            // after it into one ordered stage, so one thread owns its state.
+            auto first = std::find_if(stages_.begin(), stages_.end(), [&](const auto& stage) {
+                return std::find(stage->modes.begin(), stage->modes.end(), mode) != stage->modes.end();
+            });
+            if (first != stages_.end()) {
+                Stage& folded = **first;
+                for (auto it = first + 1; it != stages_.end(); ++it) {
+                    folded.modes.insert(folded.modes.end(), (*it)->modes.begin(), (*it)->modes.end());
+                }
+                stages_.erase(first + 1, stages_.end());
+                folded.modes.push_back(mode);
+                folded.ordered = true;
+                continue;
+            }
+        }
+        auto stage = std::make_unique<Stage>();
+        stage->modes.push_back(mode);
+        stage->ordered = stateful;
+        stage->next_seq = next_seq_;
+        stages_.push_back(std::move(stage));
+    }
+    max_in_flight_ = std::min(kMaxInFlight, std::max(2, static_cast<int>(stages_.size()) + 1));
+    for (size_t i = 0; i < stages_.size(); i++) {
+        const int workers = stages_[i]->ordered ? 1 : kParallelStageWorkers;
+        for (int w = 0; w < workers; w++)
+            stages_[i]->workers.emplace_back(&FilterPipeline::WorkerLoop, this, i);
+    }
+}
+
+void FilterPipeline::StopStages() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto& stage : stages_) stage->cv.notify_all();
+    }
+    // Only the submitting thread changes stages_, so it can be walked unlocked.
+    for (auto& stage : stages_) {
+        for (auto& worker : stage->workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.clear();
+    stopping_ = false;
+}
+
+void FilterPipeline::DrainLocked(std::unique_lock<std::mutex>& lock) {
+    drained_cv_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+void FilterPipeline::WorkerLoop(size_t stage_index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Stage& stage = *stages_[stage_index];
+    while (true) {
+        stage.cv.wait(lock, [&] {
+            if (stopping_) return true;
+            if (stage.inbox.empty()) return false;
+            return !stage.ordered || stage.inbox.begin()->first == stage.next_seq;
+        });
+        if (stopping_) return;
+
+        auto node = stage.inbox.extract(stage.inbox.begin());
+        const uint64_t seq = node.key();
+        Item item = std::move(node.mapped());
+        if (stage.ordered) stage.next_seq = seq + 1;
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        if (item.apply_filters && !item.frame.empty()) {
+            // A failing filter must not stall the sequence; pass the frame on.
+            for (int32_t mode : stage.modes) {
+                try {
+                    filter_(item.frame, mode);
+                } catch (const std::exception& e) {
+                    std::cerr << "[FilterPipeline] filter " << mode << " failed: "
+                              << e.what() << std::endl;
+                }
+            }
+        }
+        const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        stage.processed++;
+        stage.busy_ms += ms;
+        if (stage_index + 1 < stages_.size()) {
+            Stage& next = *stages_[stage_index + 1];
+            next.inbox.emplace(seq, std::move(item));
+            next.peak_occupancy = std::max(next.peak_occupancy, static_cast<int>(next.inbox.size()));
+            next.cv.notify_one();
+            continue;
+        }
+
+        lock.unlock();
+        Deliver(seq, std::move(item));
+        lock.lock();
+    }
+}
+
+void FilterPipeline::Deliver(uint64_t seq, Item&& item) {
+    int delivered = 0;
+    {
+        std::lock_guard<std::mutex> sink_lock(sink_mutex_);
+        reorder_.emplace(seq, std::move(item));
+        while (!reorder_.empty() && reorder_.begin()->first == sink_next_seq_) {
+            auto node = reorder_.extract(reorder_.begin());
+            sink_next_seq_++;
+            if (!node.mapped().frame.empty()) sink_(node.mapped().frame, node.key());
+            delivered++;
+        }
+    }
+    if (delivered == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_flight_ -= delivered;
+    completed_ += delivered;
+    drained_cv_.notify_all();
+}
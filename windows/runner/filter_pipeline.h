@@ -0,0 +1,126 @@
+#pragma once
+// ============================================================================
+// filter_pipeline.h -- Staged executor for the live camera filter chain
+//
+// Every filter in the active sequence becomes one stage with its own queue and
+// workers, so while one frame is in CLAHE the next can already be in the
+// stabilizer. Stateless filters run data-parallel across frames; stateful ones
+// (stabilization, moving average, obstacle removal, ...) have a single worker
+// that takes frames strictly in submission order. Stateful filters keep their
+// state per mode, so a mode listed twice must not run on two threads: from its
+// first occurrence on, the filters are folded into one ordered stage. Frames
+// leave the last stage through a reorder buffer, so the sink always sees them
+// in submission order.
+//
+// The pipeline holds one frame per stage plus one waiting (at least 2, at most
+// kMaxInFlight), which also bounds every stage queue. When it is full, Submit
+// replaces the newest frame that has not started yet (latest wins) or, if every
+// frame is already running, drops the incoming one. Both count as drops.
+// ============================================================================
+
+#include <opencv2/opencv.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Stats layout (floats) written by FilterPipeline::GetStats:
+//
+//   [0] layout version            [4] frames submitted
+//   [1] stage count S             [5] frames completed
+//   [2] frames in flight          [6] frames dropped at the entry
+//   [3] max frames in flight      [7] floats per stage row
+//   then S rows: first filter mode, ordered (0/1), workers, queue occupancy,
+//                peak queue occupancy, frames processed, mean ms per frame
+// ---------------------------------------------------------------------------
+static constexpr int kFilterPipelineStatsVersion = 1;
+static constexpr int kFilterPipelineHeaderFloats = 8;
+static constexpr int kFilterPipelineStageFloats = 7;
+
+class FilterPipeline {
+public:
+    // Applies `mode` to `frame` in place (ApplyFilterSequenceInternal with one mode).
+    using FilterFn = std::function<void(cv::Mat& frame, int32_t mode)>;
+    // Receives finished frames in submission order, one call at a time, with
+    // the sequence number Submit gave them.
+    using SinkFn = std::function<void(cv::Mat& frame, uint64_t seq)>;
+
+    static constexpr int kMaxInFlight = 8;
+    static constexpr int kParallelStageWorkers = 2;
+
+    FilterPipeline(FilterFn filter, SinkFn sink, std::function<bool(int32_t)> is_stateful);
+    ~FilterPipeline();
+
+    FilterPipeline(const FilterPipeline&) = delete;
+    FilterPipeline& operator=(const FilterPipeline&) = delete;
+
+    // Rebuilds the stages for `modes` if they changed. Frames already in flight
+    // finish on the old stages first. Call from the submitting thread only.
+    void Configure(const std::vector<int>& modes);
+
+    // Queues `frame` (taken over, not copied). With apply_filters false the
+    // frame passes through every stage untouched but keeps its place in order.
+    // Returns false if the frame was dropped.
+    bool Submit(cv::Mat&& frame, bool apply_filters);
+
+    // Sequence number of the next Submit; every frame submitted so far has a
+    // lower one. Safe from any thread.
+    uint64_t NextSequence() const;
+
+    // Waits for in-flight frames and joins the workers.
+    void Stop();
+
+    // Writes the layout above. Returns the number of floats written, or 0 when
+    // max_floats cannot hold the header and every stage row.
+    int GetStats(float* buffer, int max_floats) const;
+
+private:
+    struct Item {
+        cv::Mat frame;
+        bool apply_filters = true;
+    };
+
+    struct Stage {
+        std::vector<int32_t> modes;          // applied in order; one unless folded
+        bool ordered = false;                // single worker, strict sequence order
+        uint64_t next_seq = 0;               // ordered stages: next sequence to take
+        std::map<uint64_t, Item> inbox;      // keyed by sequence, lowest first
+        std::condition_variable cv;
+        std::vector<std::thread> workers;
+        int peak_occupancy = 0;
+        uint64_t processed = 0;
+        double busy_ms = 0.0;
+    };
+
+    void StartStages(const std::vector<int>& modes);
+    void StopStages();
+    void WorkerLoop(size_t stage_index);
+    void Deliver(uint64_t seq, Item&& item);
+    void DrainLocked(std::unique_lock<std::mutex>& lock);
+
+    FilterFn filter_;
+    SinkFn sink_;
+    std::function<bool(int32_t)> is_stateful_;
+
+    mutable std::mutex mutex_;               // stages, inboxes, counters
+    std::condition_variable drained_cv_;
+    std::vector<int> modes_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    bool stopping_ = false;
+    uint64_t next_seq_ = 0;
+    int in_flight_ = 0;
+    int max_in_flight_ = 2;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+    uint64_t dropped_ = 0;
+
+    std::mutex sink_mutex_;                  // serializes the sink, guards reorder_
+    std::map<uint64_t, Item> reorder_;
+    uint64_t sink_next_seq_ = 0;
+};
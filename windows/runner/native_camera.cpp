@@ -2,11 +2,13 @@
 #include "screen_capture_source.h"
 #include "whiteboard_canvas.h"
 #include "whiteboard_enhance.h"
+#include "yolo_person_detector.h"
 #include "virtual_display_manager.h"
 #include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <chrono>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <objbase.h>
@@ -60,12 +62,6 @@ struct WhiteboardBridgePerfStats {
 static WhiteboardBridgePerfStats g_whiteboard_bridge_perf_stats;
 
 
-static double DurationMs(
-    const std::chrono::steady_clock::time_point& start,
-    const std::chrono::steady_clock::time_point& end) {
-    return std::chrono::duration<double, std::milli>(end - start).count();
-}
-
 static const char* FilterModeName(int mode) {
     switch (mode) {
         case 1: return "Invert";
@@ -86,6 +82,22 @@ static const char* FilterModeName(int mode) {
     }
 }
 
+// Filters that carry state from one frame to the next. The live pipeline gives
+// them a single worker fed in frame order; all others run frames in parallel.
+static bool IsStatefulFilterMode(int32_t mode) {
+    switch (mode) {
+        case 5:   // SmartObstacle: background subtractor + accumulated background
+        case 6:   // MovingAverage: frame ring
+        case 11:  // PersonRemoval: YOLO net + smoothed probability mask
+        case 12:  // ShakingStabilization: previous gray frame + offset
+        case 13:  // LightStabilization: running brightness
+        case 15:  // SmartVideoCrop: motion energy + crop targets
+            return true;
+        default:
+            return false;
+    }
+}
+
 static void MaybeLogFilterFrameTrace(int mode, const cv::Mat& frame) {
     (void)mode; (void)frame;
 }
@@ -175,6 +187,11 @@ NativeCamera::NativeCamera(flutter::TextureRegistrar* texture_registrar)
         }));
 
     texture_id_ = texture_registrar_->RegisterTexture(texture_variant_.get());
+    filter_pipeline_ = std::make_unique<FilterPipeline>(
+        [](cv::Mat& frame, int32_t mode) { ApplyFilterSequenceInternal(frame, &mode, 1); },
+        [this](cv::Mat& frame, uint64_t seq) { PublishDisplayFrame(frame, seq); },
+        IsStatefulFilterMode);
+    person_tracker_ = std::make_unique<PersonMaskTracker>(GetWhiteboardPersonMask);
     flutter_pixel_buffer_ = std::make_unique<FlutterDesktopPixelBuffer>();
     flutter_pixel_buffer_->width = 0;
     flutter_pixel_buffer_->height = 0;
@@ -209,6 +226,7 @@ void NativeCamera::Start() {
            last_whiteboard_input_frame_bgr_.release();
            last_person_mask_.release();
     }
+    ResetPersonMasks();
     // Notify Flutter to redraw (with the black frame)
     if (texture_id_ != -1) {
         texture_registrar_->MarkTextureFrameAvailable(texture_id_);
@@ -248,6 +266,9 @@ void NativeCamera::Stop() {
 
     join_with_timeout(capture_thread_, std::chrono::milliseconds(2000));
     join_with_timeout(processing_thread_, std::chrono::milliseconds(2000));
+    filter_pipeline_->Stop();
+    // The next session must not reuse (and phase-shift) this session's mask.
+    ResetPersonMasks();
     // capture_.release() is now handled inside the thread loop
 }
 
@@ -259,6 +280,7 @@ void NativeCamera::StartProcessingOnly() {
     // This is used for screen capture, which pushes frames via PushExternalFrame()
     is_running_ = true;
     is_stream_ = false;
+    ResetPersonMasks();
     processing_thread_ = std::thread(&NativeCamera::ProcessingThreadLoop, this);
 }
 
@@ -302,7 +324,23 @@ void NativeCamera::SetResolution(int width, int height) {
     }
 }
 
+// The host loads its detector only for host consumers: PersonRemoval and an
+// in-process canvas. A helper-process canvas runs its own.
+void EnsurePersonDetectorStarted() {
+    static std::once_flag started;
+    std::call_once(started, []() { PersonDetector::Instance().Start(GetModelPath); });
+}
+
+void NativeCamera::ResetPersonMasks() {
+    person_tracker_->Reset();
+    if (g_whiteboard_canvas) g_whiteboard_canvas->ResetPersonMask();
+}
+
 void NativeCamera::SetFilterSequence(int* filters, int count) {
+    // Warm the detector up before the first PersonRemoval frame needs it.
+    for (int i = 0; i < count; i++) {
+        if (filters[i] == 11) EnsurePersonDetectorStarted();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     active_filters_.clear();
     std::ostringstream stream;
@@ -427,6 +465,7 @@ void NativeCamera::CameraThreadLoop() {
 
             camera_index_ = pending_camera_index_.load();
             restart_requested_ = false;
+            ResetPersonMasks();
             needs_open = true;
         }
 
@@ -499,8 +538,9 @@ void NativeCamera::CameraThreadLoop() {
                 }
 
                 {
+                    // `frame` is a fresh buffer every iteration; hand it over.
                     std::lock_guard<std::mutex> lock(processing_mutex_);
-                    frame.copyTo(pending_frame_);
+                    pending_frame_ = frame;
                     has_new_frame_ = true;
                 }
                 processing_cv_.notify_one();
@@ -585,7 +625,9 @@ void NativeCamera::RefreshDisplayFrame() {
             if (g_whiteboard_canvas->GetOverview(
                     overview_size,
                     canvas_out)) {
-                display_bgr = canvas_out;
+                // canvas_out may share the canvas' memoized buffer, and raw mode
+                // runs the user filters on display_bgr in place below.
+                canvas_out.copyTo(display_bgr);
                 canvas_out.copyTo(last_canvas_frame);
                 canvas_hold_frame.release();
                 showing_canvas = true;
@@ -621,8 +663,11 @@ void NativeCamera::RefreshDisplayFrame() {
         ProcessFrame(display_bgr);
     }
 
+    // Frames still in the pipeline are older than this one.
+    const uint64_t refresh_seq = filter_pipeline_->NextSequence();
     {
         std::lock_guard<std::mutex> lock(mutex_);
+        display_refresh_seq_ = std::max(display_refresh_seq_, refresh_seq);
         cv::cvtColor(display_bgr, current_frame_, cv::COLOR_BGR2RGBA);
         display_frame_id_.fetch_add(1, std::memory_order_relaxed);
     }
@@ -655,13 +700,18 @@ void NativeCamera::ProcessingThreadLoop() {
                 continue;
             }
 
-            pending_frame_.copyTo(frame);
+            frame = pending_frame_;
+            pending_frame_.release();
             has_new_frame_ = false;
         }
 
+        // The captured pixels are shared, not copied, with the refresh cache
+        // and the canvas, so nothing below writes into them: display paths
+        // replace `frame` with a buffer of their own first.
+        const uchar* const captured_data = frame.data;
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            frame.copyTo(last_source_frame_bgr_);
+            last_source_frame_bgr_ = frame;
         }
 
         // Whiteboard canvas mode — incremental SLAM-like capture
@@ -673,27 +723,32 @@ void NativeCamera::ProcessingThreadLoop() {
             bool used_fallback_frame = false;
 
             if (!remote_process) {
-                const auto yolo_start = std::chrono::steady_clock::now();
-                personMask = GetWhiteboardPersonMask(frame);
-                const auto yolo_end = std::chrono::steady_clock::now();
-                g_yolo_perf_stats.inference_ms += DurationMs(yolo_start, yolo_end);
-                g_yolo_perf_stats.refreshes++;
+                PersonMaskTracker::UpdateInfo yolo_info;
+                personMask = person_tracker_->Update(frame, g_yolo_fps.load(), &yolo_info);
+                if (yolo_info.fresh) {
+                    g_yolo_perf_stats.inference_ms += yolo_info.inference_ms;
+                    g_yolo_perf_stats.refreshes++;
+                } else {
+                    g_yolo_perf_stats.reuses++;
+                }
                 g_yolo_perf_stats.frames++;
                 MaybePrintYoloPerfLog();
             }
 
             {
                 std::lock_guard<std::mutex> lock(mutex_);
-                frame.copyTo(last_whiteboard_input_frame_bgr_);
+                last_whiteboard_input_frame_bgr_ = frame;
                 if (!personMask.empty() && personMask.size() == frame.size() &&
                     personMask.type() == CV_8UC1) {
-                    personMask.copyTo(last_person_mask_);
+                    last_person_mask_ = personMask;
                 } else {
                     last_person_mask_.release();
                 }
             }
 
-            g_whiteboard_canvas->ProcessFrame(frame, personMask);
+            // In process the worker queues these Mats as they are; with the
+            // helper they are written once, into a frame ring slot.
+            g_whiteboard_canvas->ProcessSharedFrame(frame, personMask);
             g_whiteboard_bridge_perf_stats.submitted_frames++;
 
             bool showing_canvas = false;
@@ -722,7 +777,7 @@ void NativeCamera::ProcessingThreadLoop() {
                             canvas_out);
 
                     if (got_lock) {
-                        canvas_out.copyTo(frame);
+                        frame = canvas_out.clone();
                         frame.copyTo(last_canvas_frame);
                         canvas_hold_frame.release();
                         g_whiteboard_bridge_perf_stats.canvas_frames++;
@@ -730,7 +785,7 @@ void NativeCamera::ProcessingThreadLoop() {
                         overview_success = true;
                     } else if (!last_canvas_frame.empty()) {
                         // Keep showing the last canvas frame (may differ in size from camera frame).
-                        last_canvas_frame.copyTo(frame);
+                        frame = last_canvas_frame.clone();
                         g_whiteboard_bridge_perf_stats.canvas_misses++;
                         showing_canvas = true;
                         used_fallback_frame = true;
@@ -744,7 +799,7 @@ void NativeCamera::ProcessingThreadLoop() {
                     if (canvas_hold_frame.empty() || canvas_hold_frame.size() != frame.size()) {
                         frame.copyTo(canvas_hold_frame);
                     }
-                    canvas_hold_frame.copyTo(frame);
+                    frame = canvas_hold_frame.clone();
                     g_whiteboard_bridge_perf_stats.canvas_misses++;
                     showing_canvas = true;
                     used_fallback_frame = true;
@@ -768,24 +823,46 @@ void NativeCamera::ProcessingThreadLoop() {
                 false);
         }
         
-        // Apply camera filters: always for live view, and for raw canvas view
-        if (!g_whiteboard_enabled.load() || !g_whiteboard_canvas || !g_whiteboard_canvas->IsCanvasViewMode()) {
-            ProcessFrame(frame);
-        } else if (g_whiteboard_canvas->GetRenderMode() == CanvasRenderMode::kRaw) {
-            ProcessFrame(frame);
-        }
-
-        {
+        // Apply camera filters: always for live view, and for raw canvas view.
+        // Unfiltered frames still go through the pipeline to keep display order.
+        const bool apply_filters =
+            !g_whiteboard_enabled.load() || !g_whiteboard_canvas ||
+            !g_whiteboard_canvas->IsCanvasViewMode() ||
+            g_whiteboard_canvas->GetRenderMode() == CanvasRenderMode::kRaw;
+
+        std::vector<int> filters_copy;
+        if (apply_filters) {
+            // Always apply live perspective crop first (independent of filters)
+            ApplyLivePerspectiveCrop(frame);
             std::lock_guard<std::mutex> lock(mutex_);
-            // Convert BGR to RGBA (Flutter expects RGBA on Windows)
-            cv::cvtColor(frame, current_frame_, cv::COLOR_BGR2RGBA);
-            display_frame_id_.fetch_add(1, std::memory_order_relaxed);
+            filters_copy = active_filters_;
         }
-        
-        texture_registrar_->MarkTextureFrameAvailable(texture_id_);
+        // Filters run in place; the live frame may still be the captured one.
+        if (!filters_copy.empty() && frame.data == captured_data) {
+            frame = frame.clone();
+        }
+        filter_pipeline_->Configure(filters_copy);
+        filter_pipeline_->Submit(std::move(frame), apply_filters);
     }
 }
 
+void NativeCamera::PublishDisplayFrame(const cv::Mat& frame_bgr, uint64_t seq) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Submitted before a refresh: it would overwrite the refreshed frame.
+        if (seq < display_refresh_seq_) return;
+        // Convert BGR to RGBA (Flutter expects RGBA on Windows)
+        cv::cvtColor(frame_bgr, current_frame_, cv::COLOR_BGR2RGBA);
+        display_frame_id_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    texture_registrar_->MarkTextureFrameAvailable(texture_id_);
+}
+
+int NativeCamera::GetFilterPipelineStats(float* buffer, int max_floats) const {
+    return filter_pipeline_->GetStats(buffer, max_floats);
+}
+
 const FlutterDesktopPixelBuffer* NativeCamera::CopyPixelBuffer(size_t width, size_t height) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (current_frame_.empty()) {
@@ -812,8 +889,28 @@ const FlutterDesktopPixelBuffer* NativeCamera::CopyPixelBuffer(size_t width, siz
 
 static cv::Ptr<cv::BackgroundSubtractor> g_back_sub;
 static cv::Mat g_accumulated_background;
-static std::deque<cv::Mat> g_frame_history;
-static const size_t g_history_size = 5;
+
+// Moving Average keeps the last N frames in a ring together with their 16-bit
+// per-channel sum, so each frame costs one add, one subtract and one scaled
+// conversion regardless of N. N comes from SetFilterParameter(6, window).
+static constexpr int kMovingAverageDefaultWindow = 5;
+static constexpr int kMovingAverageMaxWindow = 255;  // 255 * 255 still fits CV_16U
+
+struct MovingAverageRing {
+    std::vector<cv::Mat> slots;  // capacity == window; reused, never reallocated
+    cv::Mat sum;                 // CV_16U, same channel count as the frames
+    int head = 0;                // next slot to overwrite (the oldest once full)
+    int count = 0;
+
+    void Reset(int window) {
+        slots.assign(window, cv::Mat());
+        sum.release();
+        head = 0;
+        count = 0;
+    }
+};
+
+static MovingAverageRing g_moving_average;
 
 static void ApplyCLAHE(cv::Mat& frame) {
     cv::Mat lab_image;
@@ -833,59 +930,126 @@ static void ApplySharpening(cv::Mat& frame) {
     cv::addWeighted(frame, 1.5, blurred, -0.5, 0, frame);
 }
 
-static void ApplyMovingAverage(cv::Mat& frame) {
-    // Clear history if frame size changed (e.g., camera switch)
-    if (!g_frame_history.empty() && g_frame_history.front().size() != frame.size()) {
-        g_frame_history.clear();
+static int MovingAverageWindow() {
+    float window = static_cast<float>(kMovingAverageDefaultWindow);
+    {
+        std::lock_guard<std::mutex> lock(g_filter_params_mutex);
+        auto it = g_filter_params.find(6);
+        if (it != g_filter_params.end()) window = it->second;
     }
+    return std::clamp(static_cast<int>(std::lround(window)), 1, kMovingAverageMaxWindow);
+}
+
+static void ApplyMovingAverage(cv::Mat& frame) {
+    if (frame.empty() || frame.depth() != CV_8U) return;
+    MovingAverageRing& ring = g_moving_average;
 
-    g_frame_history.push_back(frame.clone());
-    if (g_frame_history.size() > g_history_size) {
-        g_frame_history.pop_front();
+    // Restart the window on a new size/format (e.g., camera switch) or length
+    const int window = MovingAverageWindow();
+    if (static_cast<int>(ring.slots.size()) != window ||
+        (!ring.sum.empty() &&
+         (ring.sum.size() != frame.size() || ring.sum.channels() != frame.channels()))) {
+        ring.Reset(window);
     }
-    if (g_frame_history.empty()) return;
+    if (ring.sum.empty()) ring.sum = cv::Mat::zeros(frame.size(), CV_MAKETYPE(CV_16U, frame.channels()));
 
-    cv::Mat sum = cv::Mat::zeros(frame.size(), CV_32FC3);
-    for (const auto& f : g_frame_history) {
-        cv::Mat float_f;
-        f.convertTo(float_f, CV_32F);
-        cv::accumulate(float_f, sum);
+    cv::Mat& slot = ring.slots[ring.head];
+    if (ring.count == window) {
+        cv::subtract(ring.sum, slot, ring.sum, cv::noArray(), CV_16U);
+    } else {
+        ring.count++;
     }
-    sum = sum / static_cast<double>(g_frame_history.size());
-    sum.convertTo(frame, CV_8U);
+    frame.copyTo(slot);
+    cv::add(ring.sum, slot, ring.sum, cv::noArray(), CV_16U);
+    ring.head = (ring.head + 1) % window;
+
+    ring.sum.convertTo(frame, CV_8U, 1.0 / ring.count);
+}
+
+// Smart Whiteboard maps each channel through out = 255 * (0.5 - 0.5 * cos(pi * r^5)),
+// r = min(frame / background, 1), where background is a 7x7 median followed by a
+// 3x3 Gaussian. The curve is tabulated over r and evaluated in one fused pass per
+// row, so no float images are allocated.
+static constexpr int kSmartWhiteboardLutSize = 4096;
+
+// 3x3 Gaussian with sigma 0 is [1 2 1]^T [1 2 1] / 16, so background * 16 is an
+// integer in [0, 4080]; kept as a reciprocal table to avoid per-pixel divides.
+static constexpr int kSmartWhiteboardMaxWeightedSum = 255 * 16;
+
+static const uint8_t* SmartWhiteboardCurve() {
+    static const std::vector<uint8_t> lut = [] {
+        std::vector<uint8_t> table(kSmartWhiteboardLutSize);
+        for (int i = 0; i < kSmartWhiteboardLutSize; ++i) {
+            const double r = static_cast<double>(i) / (kSmartWhiteboardLutSize - 1);
+            const double v = 0.5 - 0.5 * std::cos(CV_PI * std::pow(r, 5.0));
+            table[i] = cv::saturate_cast<uint8_t>(v * 255.0);
+        }
+        return table;
+    }();
+    return lut.data();
+}
+
+static const float* SmartWhiteboardScaledReciprocals() {
+    // 16 * (LUT size - 1) / weighted_sum: frame * entry is the LUT index directly.
+    // A zero background maps any lit pixel past the end of the curve (clamped).
+    static const std::vector<float> inv = [] {
+        std::vector<float> table(kSmartWhiteboardMaxWeightedSum + 1);
+        table[0] = static_cast<float>(kSmartWhiteboardLutSize);
+        for (int s = 1; s <= kSmartWhiteboardMaxWeightedSum; ++s)
+            table[s] = 16.0f * (kSmartWhiteboardLutSize - 1) / static_cast<float>(s);
+        return table;
+    }();
+    return inv.data();
+}
+
+// BORDER_REFLECT_101 index for a 3-tap neighbour, matching GaussianBlur's default.
+static int Reflect101(int i, int n) {
+    if (n == 1) return 0;
+    if (i < 0) return 1;
+    if (i >= n) return n - 2;
+    return i;
 }
 
 static void ApplySmartWhiteboard(cv::Mat& frame) {
-    cv::Mat blurred_8u;
-    cv::medianBlur(frame, blurred_8u, 7);
-    cv::Mat float_frame;
-    frame.convertTo(float_frame, CV_32F);
-    cv::Mat blurred;
-    blurred_8u.convertTo(blurred, CV_32F);
-    cv::GaussianBlur(blurred, blurred, cv::Size(3, 3), 0);
-    cv::Mat normalized;
-    cv::divide(float_frame, blurred, normalized);
-    cv::min(normalized, 1.0f, normalized);
-    cv::pow(normalized, 5, normalized);
-    normalized = normalized * CV_PI;
-    
-    cv::Mat cos_val = normalized.clone();
-    int rows = cos_val.rows;
-    int cols = cos_val.cols * cos_val.channels();
-    if (cos_val.isContinuous()) {
-        cols *= rows;
-        rows = 1;
-    }
-    for (int i = 0; i < rows; ++i) {
-        float* ptr = cos_val.ptr<float>(i);
-        for (int j = 0; j < cols; ++j) {
-            ptr[j] = std::cos(ptr[j]);
+    if (frame.empty() || frame.depth() != CV_8U) return;
+
+    cv::Mat median;
+    cv::medianBlur(frame, median, 7);
+
+    const uint8_t* curve = SmartWhiteboardCurve();
+    const float* inv = SmartWhiteboardScaledReciprocals();
+    const int rows = frame.rows;
+    const int cols = frame.cols;
+    const int cn = frame.channels();
+    const int width = cols * cn;
+    const float max_index = static_cast<float>(kSmartWhiteboardLutSize - 1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        // Vertical [1 2 1] sums of the median, padded by one pixel on each side
+        // so the horizontal taps need no bounds checks.
+        std::vector<uint16_t> vsum((cols + 2) * cn);
+        for (int y = range.start; y < range.end; ++y) {
+            const uint8_t* up = median.ptr<uint8_t>(Reflect101(y - 1, rows));
+            const uint8_t* mid = median.ptr<uint8_t>(y);
+            const uint8_t* down = median.ptr<uint8_t>(Reflect101(y + 1, rows));
+            uint16_t* v = vsum.data() + cn;
+            for (int j = 0; j < width; ++j)
+                v[j] = static_cast<uint16_t>(up[j] + 2 * mid[j] + down[j]);
+            const int left = Reflect101(-1, cols) * cn;
+            const int right = Reflect101(cols, cols) * cn;
+            for (int c = 0; c < cn; ++c) {
+                v[c - cn] = v[left + c];
+                v[width + c] = v[right + c];
+            }
+
+            uint8_t* row = frame.ptr<uint8_t>(y);
+            for (int j = 0; j < width; ++j) {
+                const int s = v[j - cn] + 2 * v[j] + v[j + cn];
+                const float index = std::min(row[j] * inv[s], max_index);
+                row[j] = curve[static_cast<int>(index + 0.5f)];
+            }
         }
-    }
-    
-    cv::Mat enhanced = 0.5f - 0.5f * cos_val;
-    enhanced = enhanced * 255.0f;
-    enhanced.convertTo(frame, CV_8U);
+    });
 }
 
 static void ApplySmartObstacleRemoval(cv::Mat& frame) {
@@ -1249,9 +1413,12 @@ static void ApplyLivePerspectiveCrop(cv::Mat& frame) {
 
 // --- YOLOv11 Person Detection Helpers ---
 
-static cv::dnn::Net g_yolo11_net;
-static bool g_yolo11_initialized = false;
-static bool g_yolo11_failed = false;
+// All person detection goes through the shared PersonDetector, which owns
+// the network and serializes inference. Letterboxed input tensors are reused
+// across calls; the canvas only needs coarse lecturer boxes, so it runs a
+// smaller input.
+static YoloInputTensor g_canvas_yolo_input(PersonDetector::kCanvasInputSize);
+static YoloInputTensor g_filter_yolo_input(PersonDetector::kFullInputSize);
 
 // Background modeling for person removal
 static cv::Mat g_bg_model_float;
@@ -1260,95 +1427,22 @@ static cv::Mat g_bg_model_8u;
 // Helper function to get person mask for panorama stitching
 // Returns a mask where person regions are 255, background is 0
 cv::Mat GetWhiteboardPersonMask(const cv::Mat& frame) {
-    cv::Mat personMask = cv::Mat::zeros(frame.size(), CV_8UC1);
-    
-    if (g_yolo11_failed) return personMask;
-    
-    // Initialize YOLO if not done
-    if (!g_yolo11_initialized) {
-        try {
-            std::string modelPath = GetModelPath("yolo11n.onnx");
-            g_yolo11_net = cv::dnn::readNetFromONNX(modelPath);
-            g_yolo11_net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-            g_yolo11_net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-            g_yolo11_initialized = !g_yolo11_net.empty();
-        } catch (const cv::Exception& e) {
-            std::cerr << "Failed to load YOLOv11 model: " << e.what() << std::endl;
-            g_yolo11_failed = true;
-            return personMask;
-        } catch (...) {
-            std::cerr << "Failed to load YOLOv11 model (Unknown error)." << std::endl;
-            g_yolo11_failed = true;
-            return personMask;
-        }
-    }
+    // No mask at all rather than an empty one: a frame stitched without its
+    // lecturer masked would paint the lecturer into the canvas.
+    EnsurePersonDetectorStarted();
+    if (!PersonDetector::Instance().IsReady()) return cv::Mat();
 
-    if (!g_yolo11_initialized) return personMask;
+    cv::Mat personMask = cv::Mat::zeros(frame.size(), CV_8UC1);
 
     try {
-        const int input_w = 640;
-        const int input_h = 640;
-
-        cv::Mat blob = cv::dnn::blobFromImage(frame, 1.0 / 255.0, cv::Size(input_w, input_h), cv::Scalar(), true, false);
-        g_yolo11_net.setInput(blob);
-
-        std::vector<cv::Mat> outputs;
-        g_yolo11_net.forward(outputs, g_yolo11_net.getUnconnectedOutLayersNames());
-
-        if (outputs.empty()) return personMask;
-
-        cv::Mat output = outputs[0];
-        if (output.dims != 3) return personMask;
-
-        int dimensions = output.size[1];
-        int rows = output.size[2];
-
-        if (dimensions < 5) return personMask;
-
-        cv::Mat output2D = output.reshape(1, dimensions);
-        cv::Mat output2D_t;
-        cv::transpose(output2D, output2D_t);
-
-        float* data = (float*)output2D_t.data;
-        
-        std::vector<int> class_ids;
-        std::vector<float> confidences;
-        std::vector<cv::Rect> boxes;
-
-        float conf_threshold = 0.45f;
-        float nms_threshold = 0.5f;
-        
-        float x_factor = (float)frame.cols / (float)input_w;
-        float y_factor = (float)frame.rows / (float)input_h;
-
-        for (int i = 0; i < rows; ++i) {
-            float* row_ptr = data + i * dimensions;
-            float* scores_ptr = row_ptr + 4;
-            float person_score = scores_ptr[0]; // Person is class 0 in COCO
-
-            if (person_score > conf_threshold) {
-                float cx = row_ptr[0];
-                float cy = row_ptr[1];
-                float w = row_ptr[2];
-                float h = row_ptr[3];
-
-                int left = int((cx - 0.5 * w) * x_factor);
-                int top = int((cy - 0.5 * h) * y_factor);
-                int width = int(w * x_factor);
-                int height = int(h * y_factor);
-
-                boxes.push_back(cv::Rect(left, top, width, height));
-                confidences.push_back(person_score);
-                class_ids.push_back(0);
-            }
+        std::vector<PersonBox> persons;
+        if (!PersonDetector::Instance().Detect(g_canvas_yolo_input, frame, 0.45f, 0.5f, persons)) {
+            return personMask;
         }
 
-        std::vector<int> indices;
-        cv::dnn::NMSBoxes(boxes, confidences, conf_threshold, nms_threshold, indices);
-
         // Create person mask with expanded boxes
-        for (int idx : indices) {
-            cv::Rect box = boxes[idx];
+        for (const PersonBox& person : persons) {
+            const cv::Rect& box = person.box;
             // Expand box to ensure we cover person edges
             int pad = 20;
             cv::Rect padded_box;
@@ -1370,134 +1464,25 @@ cv::Mat GetWhiteboardPersonMask(const cv::Mat& frame) {
 }
 
 static void ApplyYOLO11Detection(cv::Mat& frame) {
-    if (g_yolo11_failed) return;
-    if (!g_yolo11_initialized) {
-        try {
-            std::string modelPath = GetModelPath("yolo11n.onnx");
-            g_yolo11_net = cv::dnn::readNetFromONNX(modelPath);
-            g_yolo11_net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-            g_yolo11_net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-            g_yolo11_initialized = !g_yolo11_net.empty();
-        } catch (const cv::Exception& e) {
-            std::cerr << "Failed to load YOLOv11 model: " << e.what() << std::endl;
-            g_yolo11_failed = true;
-            return;
-        } catch (...) {
-            std::cerr << "Failed to load YOLOv11 model (Unknown error)." << std::endl;
-            g_yolo11_failed = true;
-            return;
-        }
-    }
-
-    if (!g_yolo11_initialized) return;
-
     try {
-        // Ensure OpenCV uses all available threads
-        cv::setNumThreads(cv::getNumberOfCPUs());
-
-        // YOLOv11n standard input size is 640x640
-        const int input_w = 640;
-        const int input_h = 640;
-
-        auto start_preprocess = std::chrono::high_resolution_clock::now();
-
-        // Preprocessing: Resize and Normalize
-        cv::Mat blob = cv::dnn::blobFromImage(frame, 1.0 / 255.0, cv::Size(input_w, input_h), cv::Scalar(), true, false);
-        
-        g_yolo11_net.setInput(blob);
-
-        auto end_preprocess = std::chrono::high_resolution_clock::now();
-        
-        // Measure inference time
+        // YOLOv11n standard input size is 640x640 (letterboxed)
         auto start_inference = std::chrono::high_resolution_clock::now();
-
-        std::vector<cv::Mat> outputs;
-        g_yolo11_net.forward(outputs, g_yolo11_net.getUnconnectedOutLayersNames());
-
+        EnsurePersonDetectorStarted();
+        std::vector<PersonBox> persons;
+        if (!PersonDetector::Instance().Detect(g_filter_yolo_input, frame, 0.45f, 0.5f, persons)) {
+            return;
+        }
         auto end_inference = std::chrono::high_resolution_clock::now();
-        
-        long long duration_preprocess = std::chrono::duration_cast<std::chrono::milliseconds>(end_preprocess - start_preprocess).count();
+
         long long duration_inference = std::chrono::duration_cast<std::chrono::milliseconds>(end_inference - start_inference).count();
-        
+
         // Print FPS every 30 frames
         static int frame_count = 0;
         if (++frame_count % 30 == 0) {
             double fps = (duration_inference > 0) ? (1000.0 / duration_inference) : 0.0;
-            std::cout << "YOLOv11 Timing - Preprocess: " << duration_preprocess << "ms | Inference: " << duration_inference << "ms (~" << fps << " FPS)" << std::endl;
-        }
-
-        if (outputs.empty()) return;
-
-        // Output shape is typically [1, 84, 8400] for YOLOv11n (1 class + 4 box coords + ... wait, v11 might be different)
-        // YOLOv8/v11 output: [Batch, 4 + NumClasses, NumAnchors] -> [1, 4+80, 8400] usually.
-        // For Person only model or COCO? The user said "yolo11n.onnx", likely COCO (80 classes).
-        // So 4 box + 80 classes = 84 channels.
-        
-        cv::Mat output = outputs[0];
-        
-        // Check dimensions
-        if (output.dims != 3) {
-            // std::cerr << "Unexpected output dimensions: " << output.dims << std::endl;
-            return;
-        }
-
-        // int batch = output.size[0]; // Unused
-        int dimensions = output.size[1]; // 84 (cx, cy, w, h, class0, class1...)
-        int rows = output.size[2];       // 8400 (anchors)
-
-        if (dimensions < 5) return; // Need at least box + 1 class
-
-        // Transpose to [Batch, Rows, Dimensions] -> [1, 8400, 84] for easier iteration
-        // OpenCV output is [1, 84, 8400]. We want to iterate over 8400 anchors.
-        cv::Mat output2D = output.reshape(1, dimensions); // Reshape to 2D: [84, 8400]
-        cv::Mat output2D_t;
-        cv::transpose(output2D, output2D_t); // [8400, 84]
-
-        float* data = (float*)output2D_t.data;
-        
-        std::vector<int> class_ids;
-        std::vector<float> confidences;
-        std::vector<cv::Rect> boxes;
-
-        float conf_threshold = 0.45f;
-        float nms_threshold = 0.5f;
-        
-        float x_factor = (float)frame.cols / (float)input_w;
-        float y_factor = (float)frame.rows / (float)input_h;
-
-        for (int i = 0; i < rows; ++i) {
-            float* row_ptr = data + i * dimensions;
-            
-            // Find the class with the highest score
-            // First 4 elements are box coordinates (cx, cy, w, h)
-            // The rest are class scores.
-            float* scores_ptr = row_ptr + 4;
-            // int num_classes = dimensions - 4; // Unused
-            
-            // Optimization: We only care about Person (class 0)
-            // If the model is COCO, Person is index 0.
-            float person_score = scores_ptr[0]; 
-
-            if (person_score > conf_threshold) {
-                float cx = row_ptr[0];
-                float cy = row_ptr[1];
-                float w = row_ptr[2];
-                float h = row_ptr[3];
-
-                int left = int((cx - 0.5 * w) * x_factor);
-                int top = int((cy - 0.5 * h) * y_factor);
-                int width = int(w * x_factor);
-                int height = int(h * y_factor);
-
-                boxes.push_back(cv::Rect(left, top, width, height));
-                confidences.push_back(person_score);
-                class_ids.push_back(0);
-            }
+            std::cout << "YOLOv11 Timing - Preprocess + Inference: " << duration_inference << "ms (~" << fps << " FPS)" << std::endl;
         }
 
-        std::vector<int> indices;
-        cv::dnn::NMSBoxes(boxes, confidences, conf_threshold, nms_threshold, indices);
-
         // --- Person Removal Logic ---
         
         // 1. Initialize background model if needed or if size changed
@@ -1508,8 +1493,8 @@ static void ApplyYOLO11Detection(cv::Mat& frame) {
 
         // 2. Create a mask of all detected persons
         cv::Mat person_mask = cv::Mat::zeros(frame.size(), CV_8UC1);
-        for (int idx : indices) {
-            cv::Rect box = boxes[idx];
+        for (const PersonBox& person : persons) {
+            const cv::Rect& box = person.box;
             // Slightly expand the box to ensure we cover the person edges
             int pad = 10;
             cv::Rect padded_box = box;
@@ -1568,10 +1553,8 @@ static void ApplyYOLO11Detection(cv::Mat& frame) {
         g_bg_model_8u.copyTo(frame, final_mask);
     } catch (const cv::Exception& e) {
         std::cerr << "YOLO Inference Error: " << e.what() << std::endl;
-        g_yolo11_failed = true; 
     } catch (...) {
         std::cerr << "YOLO Inference Error (Unknown)" << std::endl;
-        g_yolo11_failed = true;
     }
 }
 
@@ -1624,7 +1607,7 @@ void ApplyFilterSequenceInternal(cv::Mat& bgr, int32_t* modes, int32_t count) {
                 auto it = g_filter_params.find(16);
                 if (it != g_filter_params.end()) dog_threshold = it->second;
             }
-            bgr = WhiteboardEnhance(bgr, dog_threshold);
+            bgr = WhiteboardEnhanceParallel(bgr, dog_threshold);
             MaybeLogFilterFrameTrace(mode, bgr);
         }
     }
@@ -1870,6 +1853,40 @@ extern "C" {
         if (g_native_camera) g_native_camera->GetFrameData(buffer, size);
     }
 
+    __declspec(dllexport) int32_t GetFilterPipelineStats(float* buffer, int32_t max_floats) {
+        if (!g_native_camera) return 0;
+        return g_native_camera->GetFilterPipelineStats(buffer, max_floats);
+    }
+
+    // backend: 0 OpenCV CPU, 1 OpenVINO CPU; precision: 0 FP32, 1 FP16, 2 INT8;
+    // threads: 0 = all cores. Reloads in the background, in the host and in the
+    // canvas helper.
+    __declspec(dllexport) void SetPersonDetectorConfig(int32_t backend, int32_t precision, int32_t threads) {
+        PersonDetectorConfig config;
+        config.backend = backend == 1 ? PersonDetectorBackend::kOpenVinoCpu
+                                      : PersonDetectorBackend::kOpenCvCpu;
+        config.precision = precision == 1 ? PersonDetectorPrecision::kFp16
+                         : precision == 2 ? PersonDetectorPrecision::kInt8
+                                          : PersonDetectorPrecision::kFp32;
+        config.threads = std::max(0, static_cast<int>(threads));
+        // Stored only until the host detector starts; it is not loaded here.
+        PersonDetector::Instance().Configure(config);
+        g_person_detector_backend.store(static_cast<int>(config.backend));
+        g_person_detector_precision.store(static_cast<int>(config.precision));
+        g_person_detector_threads.store(config.threads);
+        if (g_whiteboard_canvas) g_whiteboard_canvas->SyncRuntimeSettings();
+    }
+
+    // Reports the canvas helper's detector when the canvas runs out of process,
+    // otherwise the host's.
+    __declspec(dllexport) int32_t GetPersonDetectorStats(float* buffer, int32_t max_floats) {
+        if (g_whiteboard_canvas) {
+            const int written = g_whiteboard_canvas->GetPersonDetectorStats(buffer, max_floats);
+            if (written > 0) return written;
+        }
+        return PersonDetector::Instance().GetStats(buffer, max_floats);
+    }
+
     __declspec(dllexport) uint64_t GetDisplayFrameId() {
         if (g_native_camera) return g_native_camera->GetDisplayFrameId();
         return 0;
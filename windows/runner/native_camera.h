@@ -1,5 +1,8 @@
 #pragma once
 
+#include "filter_pipeline.h"
+#include "person_mask_tracker.h"
+
 #include <flutter/texture_registrar.h>
 #include <opencv2/opencv.hpp>
 #include <mutex>
@@ -41,6 +44,9 @@ public:
     // External frame input (for screen capture, etc.)
     void PushExternalFrame(const cv::Mat& frame);
 
+    // Live filter pipeline depth, queue occupancy and drops (FilterPipeline::GetStats).
+    int GetFilterPipelineStats(float* buffer, int max_floats) const;
+
 private:
     flutter::TextureRegistrar* texture_registrar_;
     int64_t texture_id_ = -1;
@@ -81,10 +87,29 @@ private:
     cv::Mat pending_frame_;
     std::atomic<bool> has_new_frame_ = false;
     void ProcessingThreadLoop();
+
+    // Live filters run staged on their own workers; finished frames come back
+    // in order through PublishDisplayFrame.
+    std::unique_ptr<FilterPipeline> filter_pipeline_;
+    void PublishDisplayFrame(const cv::Mat& frame_bgr, uint64_t seq);
+    // RefreshDisplayFrame publishes outside the pipeline; frames submitted
+    // before it (sequence below this) are dropped at the sink. Guarded by mutex_.
+    uint64_t display_refresh_seq_ = 0;
+
+    // Person mask for the local canvas, detected at g_yolo_fps on its own worker.
+    std::unique_ptr<PersonMaskTracker> person_tracker_;
+    // Resets it and the canvas helper's tracker, so no session reuses
+    // (and phase-shifts) another session's mask.
+    void ResetPersonMasks();
 };
 
 extern NativeCamera* g_native_camera;
 
 void InitGlobalNativeCamera(flutter::TextureRegistrar* texture_registrar);
 void ShutdownGlobalNativeCamera();
+std::string GetModelPath(const std::string& modelName);
+// Starts loading the host's person detector, once. Called when a host
+// consumer (PersonRemoval or an in-process canvas) is configured.
+void EnsurePersonDetectorStarted();
+// Empty while the detector is still loading; callers skip the frame.
 cv::Mat GetWhiteboardPersonMask(const cv::Mat& frame);
@@ -0,0 +1,200 @@
+#include "person_mask_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+PersonMaskTracker::PersonMaskTracker(DetectFn detect)
+    : detect_(std::move(detect)) {
+    worker_ = std::thread(&PersonMaskTracker::WorkerLoop, this);
+}
+
+PersonMaskTracker::~PersonMaskTracker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void PersonMaskTracker::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+        latest_ = Detection();
+    }
+    reset_pending_.store(true);
+}
+
+cv::Mat PersonMaskTracker::SmallGray(const cv::Mat& frame_bgr) const {
+    cv::Mat gray;
+    if (frame_bgr.channels() == 3) {
+        cv::cvtColor(frame_bgr, gray, cv::COLOR_BGR2GRAY);
+    } else if (frame_bgr.channels() == 4) {
+        cv::cvtColor(frame_bgr, gray, cv::COLOR_BGRA2GRAY);
+    } else {
+        gray = frame_bgr;
+    }
+    cv::Mat small = gray;
+    if (gray.cols > kMotionWidth) {
+        const int height = std::max(1, gray.rows * kMotionWidth / gray.cols);
+        cv::resize(gray, small, cv::Size(kMotionWidth, height), 0, 0, cv::INTER_AREA);
+    }
+    cv::Mat small_f;
+    small.convertTo(small_f, CV_32F);
+    return small_f;
+}
+
+void PersonMaskTracker::Schedule(const cv::Mat& frame_bgr, const cv::Mat& small_gray) {
+    // Caller holds mutex_. The frame is copied: the processing thread reuses it.
+    frame_bgr.copyTo(pending_frame_);
+    pending_small_ = small_gray;
+    pending_generation_ = generation_;
+    busy_ = true;
+    last_schedule_ = std::chrono::steady_clock::now();
+    cv_.notify_all();
+}
+
+cv::Mat PersonMaskTracker::Update(const cv::Mat& frame_bgr, float detect_fps, UpdateInfo* info) {
+    UpdateInfo local_info;
+    UpdateInfo& out = info ? *info : local_info;
+    out = UpdateInfo();
+    if (frame_bgr.empty()) return cv::Mat();
+
+    if (frame_bgr.size() != frame_size_) Reset();
+    if (reset_pending_.exchange(false)) {
+        frame_size_ = frame_bgr.size();
+        prev_small_.release();
+        consumed_serial_ = 0;
+    }
+
+    const cv::Mat small = SmallGray(frame_bgr);
+    const float fps = std::clamp(detect_fps, kMinDetectFps, kMaxDetectFps);
+    const auto interval = std::chrono::duration<double>(1.0 / fps);
+
+    Detection det;
+    bool busy = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Nothing to reuse yet for this frame size: have this frame detected
+        // and let the caller skip frames until the mask is in. Waiting here
+        // would hold up the caller's loop for a whole model load.
+        if (latest_.mask.empty()) {
+            if (!busy_ && !stop_) {
+                Schedule(frame_bgr, small);
+                out.scheduled = true;
+            }
+            return cv::Mat();
+        }
+        det = latest_;  // Mats in latest_ are replaced, never written in place
+        busy = busy_;
+    }
+
+    out.fresh = det.serial != consumed_serial_;
+    consumed_serial_ = det.serial;
+    if (out.fresh) out.inference_ms = det.inference_ms;
+
+    // Change energy near the last person box (whole frame when nobody was
+    // found, so someone walking in is picked up before the next cadence tick).
+    bool changed = false;
+    if (!prev_small_.empty() && prev_small_.size() == small.size()) {
+        const cv::Rect frame_rect(0, 0, small.cols, small.rows);
+        cv::Rect region = frame_rect;
+        if (det.small_box.area() > 0) {
+            const int pad = static_cast<int>(std::ceil(small.cols * kBoxPadFraction));
+            region = cv::Rect(det.small_box.x - pad, det.small_box.y - pad,
+                              det.small_box.width + 2 * pad,
+                              det.small_box.height + 2 * pad) & frame_rect;
+        }
+        if (region.area() > 0) {
+            cv::Mat diff;
+            cv::absdiff(small(region), prev_small_(region), diff);
+            const int changed_pixels = cv::countNonZero(diff > kChangedPixelThreshold);
+            changed = changed_pixels > kForceChangedFraction * region.area();
+        }
+    }
+    prev_small_ = small;
+
+    const auto now = std::chrono::steady_clock::now();
+    const bool due = now - last_schedule_ >= interval;
+    if (!busy && (due || changed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!busy_) {
+            Schedule(frame_bgr, small);
+            out.scheduled = true;
+            out.forced = !due;
+        }
+    }
+
+    // Shift the mask by the global motion since the frame it was computed on.
+    if (det.small_gray.size() == small.size()) {
+        double response = 0.0;
+        const cv::Point2d small_shift = cv::phaseCorrelate(det.small_gray, small, cv::noArray(), &response);
+        const double scale = static_cast<double>(frame_bgr.cols) / small.cols;
+        const cv::Point2f shift(static_cast<float>(small_shift.x * scale),
+                                static_cast<float>(small_shift.y * scale));
+        if (response >= kMinShiftResponse &&
+            (std::abs(shift.x) >= 0.5f || std::abs(shift.y) >= 0.5f)) {
+            const cv::Mat m = (cv::Mat_<double>(2, 3) << 1, 0, shift.x, 0, 1, shift.y);
+            cv::Mat shifted;
+            cv::warpAffine(det.mask, shifted, m, det.mask.size(), cv::INTER_NEAREST,
+                           cv::BORDER_CONSTANT, cv::Scalar(0));
+            out.shift = shift;
+            return shifted;
+        }
+    }
+    return det.mask.clone();
+}
+
+void PersonMaskTracker::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stop_ || !pending_frame_.empty(); });
+        if (stop_) return;
+
+        cv::Mat frame = std::move(pending_frame_);
+        cv::Mat small = std::move(pending_small_);
+        pending_frame_.release();
+        pending_small_.release();
+        const uint64_t generation = pending_generation_;
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        cv::Mat mask = detect_(frame);
+        const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        if (mask.empty()) {
+            // The model is still loading; the next Update schedules again.
+            lock.lock();
+            busy_ = false;
+            continue;
+        }
+        if (mask.size() != frame.size() || mask.type() != CV_8UC1) {
+            mask = cv::Mat::zeros(frame.size(), CV_8UC1);
+        }
+
+        cv::Rect small_box;
+        const cv::Rect box = cv::boundingRect(mask);
+        if (box.area() > 0) {
+            const double s = static_cast<double>(small.cols) / frame.cols;
+            const int x0 = static_cast<int>(std::floor(box.x * s));
+            const int y0 = static_cast<int>(std::floor(box.y * s));
+            const int x1 = static_cast<int>(std::ceil(box.br().x * s));
+            const int y1 = static_cast<int>(std::ceil(box.br().y * s));
+            small_box = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+        }
+
+        lock.lock();
+        busy_ = false;
+        if (generation == generation_) {
+            Detection det;
+            det.mask = mask;
+            det.small_gray = small;
+            det.small_box = small_box;
+            det.inference_ms = ms;
+            det.serial = latest_.serial + 1;
+            latest_ = det;
+        }
+        cv_.notify_all();
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+// ============================================================================
+// person_mask_tracker.h -- Rate-limited person mask for the whiteboard canvas
+//
+// Person detection (YOLOv11n) costs tens of milliseconds, far more than the
+// canvas needs: the lecturer moves slowly compared to the frame rate. The
+// tracker runs the detector on its own worker at most `detect_fps` times per
+// second and hands every frame the latest mask, shifted by a global motion
+// estimate (phase correlation on a small gray copy) from the frame the mask
+// was computed on. If the frame-to-frame difference inside or near the last
+// person box exceeds a threshold, a fresh detection is requested right away.
+// ============================================================================
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class PersonMaskTracker {
+public:
+    // Returns a CV_8UC1 mask (255 = person) the size of the BGR frame, or an
+    // empty Mat while no detection can run (model still loading).
+    using DetectFn = std::function<cv::Mat(const cv::Mat& frame_bgr)>;
+
+    struct UpdateInfo {
+        bool fresh = false;           // mask comes from a detection finished since the last call
+        bool forced = false;          // this call requested a detection because of motion
+        bool scheduled = false;       // this call handed a frame to the worker
+        double inference_ms = 0.0;    // duration of the detection behind a fresh mask
+        cv::Point2f shift;            // applied mask shift in full-frame pixels
+    };
+
+    explicit PersonMaskTracker(DetectFn detect);
+    ~PersonMaskTracker();
+
+    PersonMaskTracker(const PersonMaskTracker&) = delete;
+    PersonMaskTracker& operator=(const PersonMaskTracker&) = delete;
+
+    // Mask for `frame_bgr`. Never waits for the detector: while no mask exists
+    // yet (first frame, after a frame size change or Reset, model still
+    // loading) it schedules a detection and returns an empty Mat, and the
+    // caller skips the frame. Otherwise detection runs behind.
+    cv::Mat Update(const cv::Mat& frame_bgr, float detect_fps, UpdateInfo* info = nullptr);
+
+    // Drops the current mask; Updates return empty until a fresh detection.
+    // A mask survives anything the tracker cannot see, such as a camera
+    // restart at the same resolution, so owners call this on start, stop and
+    // source switch. Safe from any thread.
+    void Reset();
+
+private:
+    // Width of the gray copy used for motion and change estimates.
+    static constexpr int kMotionWidth = 160;
+    // Absolute gray difference that counts a small-frame pixel as changed.
+    static constexpr int kChangedPixelThreshold = 25;
+    // Share of changed pixels around the last box that forces a detection.
+    static constexpr double kForceChangedFraction = 0.04;
+    // Padding around the last person box, as a fraction of the frame width.
+    static constexpr float kBoxPadFraction = 0.08f;
+    // Below this phase-correlation response the shift estimate is ignored.
+    static constexpr double kMinShiftResponse = 0.15;
+    // Accepted detection rate range; g_yolo_fps is clamped into it.
+    static constexpr float kMinDetectFps = 0.1f;
+    static constexpr float kMaxDetectFps = 30.0f;
+
+    struct Detection {
+        cv::Mat mask;                 // full-frame CV_8UC1
+        cv::Mat small_gray;           // CV_32F gray of the frame it was run on
+        cv::Rect small_box;           // bounding box of the mask in small coords
+        double inference_ms = 0.0;
+        uint64_t serial = 0;
+    };
+
+    void WorkerLoop();
+    void Schedule(const cv::Mat& frame_bgr, const cv::Mat& small_gray);
+    cv::Mat SmallGray(const cv::Mat& frame_bgr) const;
+
+    DetectFn detect_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread worker_;
+    bool stop_ = false;
+    bool busy_ = false;               // a frame is pending or being detected
+    cv::Mat pending_frame_;
+    cv::Mat pending_small_;
+    uint64_t pending_generation_ = 0;
+    Detection latest_;                // guarded by mutex_
+    uint64_t generation_ = 0;         // bumped by Reset; stale detections are dropped
+
+    // Set by Reset; Update clears its own state below before the next frame.
+    std::atomic<bool> reset_pending_{false};
+
+    // Processing-thread state (Update only).
+    cv::Size frame_size_;
+    cv::Mat prev_small_;
+    uint64_t consumed_serial_ = 0;
+    std::chrono::steady_clock::time_point last_schedule_;
+};
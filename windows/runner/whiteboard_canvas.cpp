@@ -13,7 +13,6 @@
 
 #include "whiteboard_canvas.h"
 #include "whiteboard_canvas_process.h"
-#include "native_camera.h"
 #include "whiteboard_enhance.h"
 
 #if __has_include(<opencv2/shape.hpp>)
@@ -23,13 +22,16 @@
 #define KAPTCHI_HAS_OPENCV_SHAPE 0
 #endif
 
+#ifdef _WIN32
 #ifndef NOMINMAX
 #define NOMINMAX
 #endif
 #include <windows.h>
+#endif
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -49,6 +51,9 @@ std::atomic<float> g_canvas_zoom{1.0f};
 std::atomic<bool>  g_whiteboard_debug{false};
 std::atomic<bool>  g_duplicate_debug_mode{false};
 std::atomic<float> g_yolo_fps{2.0f};
+std::atomic<int>   g_person_detector_backend{0};
+std::atomic<int>   g_person_detector_precision{0};
+std::atomic<int>   g_person_detector_threads{0};
 std::atomic<float> g_canvas_enhance_threshold{4.0f};
 std::atomic<float> g_absence_score_seen_threshold{kAbsenceScoreSeenThreshold};
 
@@ -58,8 +63,20 @@ std::atomic<float> g_absence_score_seen_threshold{kAbsenceScoreSeenThreshold};
 
 namespace {
 
+static void LogCanvasError(const std::string& message) {
+#ifdef _WIN32
+    OutputDebugStringA((message + "\n").c_str());
+#else
+    std::cerr << message << std::endl;
+#endif
+}
+
 using SteadyClock = std::chrono::steady_clock;
 
+static double ElapsedMs(SteadyClock::time_point start, SteadyClock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
 static constexpr int kEnhancePadding = 10;
 static constexpr float kWhiteboardSideCropFraction = 0.03f;
 static constexpr float kShapeCompareMinBboxRatio = 0.8f;
@@ -84,24 +101,72 @@ enum DuplicateDebugReason : int {
     kDuplicateReasonShapeDifference = 1 << 3,
 };
 
+// Runs WhiteboardEnhance on the padded ROIs of the selected blobs (all blobs when
+// `selected` is null). Overlapping padded ROIs are merged so each frame region is
+// enhanced once; every blob then copies its bbox out of its region.
 static void EnhanceFrameBlobs(std::vector<FrameBlob>& blobs,
+                               const std::vector<char>* selected,
                                const cv::Mat& frame_bgr, float threshold) {
     if (threshold < 0.0f || frame_bgr.empty()) return;
-    for (auto& blob : blobs) {
+
+    struct Region { cv::Rect rect; std::vector<int> members; };
+    std::vector<Region> regions;
+    const cv::Rect frame_rect(0, 0, frame_bgr.cols, frame_bgr.rows);
+    for (int i = 0; i < (int)blobs.size(); i++) {
+        if (selected && !(*selected)[i]) continue;
+        const FrameBlob& blob = blobs[i];
         if (blob.color_pixels.empty()) continue;
-        int px0 = std::max(0, blob.bbox.x - kEnhancePadding);
-        int py0 = std::max(0, blob.bbox.y - kEnhancePadding);
-        int px1 = std::min(frame_bgr.cols, blob.bbox.x + blob.bbox.width  + kEnhancePadding);
-        int py1 = std::min(frame_bgr.rows, blob.bbox.y + blob.bbox.height + kEnhancePadding);
-        cv::Rect padded(px0, py0, px1 - px0, py1 - py0);
-        cv::Mat enhanced = WhiteboardEnhance(frame_bgr(padded), threshold);
-        int cx = blob.bbox.x - px0;
-        int cy = blob.bbox.y - py0;
-        blob.color_pixels =
-            enhanced(cv::Rect(cx, cy, blob.bbox.width, blob.bbox.height)).clone();
+        cv::Rect padded(blob.bbox.x - kEnhancePadding, blob.bbox.y - kEnhancePadding,
+                        blob.bbox.width + 2 * kEnhancePadding,
+                        blob.bbox.height + 2 * kEnhancePadding);
+        padded &= frame_rect;
+        if (padded.area() <= 0) continue;
+        regions.push_back({padded, {i}});
+    }
+
+    // Merge until no two regions overlap (a merged rect can reach new neighbours).
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t a = 0; a < regions.size(); a++) {
+            for (size_t b = a + 1; b < regions.size();) {
+                if ((regions[a].rect & regions[b].rect).area() <= 0) { b++; continue; }
+                regions[a].rect |= regions[b].rect;
+                regions[a].members.insert(regions[a].members.end(),
+                                          regions[b].members.begin(), regions[b].members.end());
+                regions.erase(regions.begin() + b);
+                merged = true;
+            }
+        }
+    }
+
+    for (const auto& region : regions) {
+        cv::Mat enhanced = WhiteboardEnhance(frame_bgr(region.rect), threshold);
+        for (int i : region.members) {
+            FrameBlob& blob = blobs[i];
+            cv::Rect local(blob.bbox.x - region.rect.x, blob.bbox.y - region.rect.y,
+                           blob.bbox.width, blob.bbox.height);
+            enhanced(local).copyTo(blob.color_pixels);
+            blob.color_enhanced = true;
+        }
     }
 }
 
+// Enhances the colour of a node captured in stroke mode, the first time raw
+// mode needs it. Only the node's own pixels are kept, so the kEnhancePadding
+// context is replicated from its border rather than read from the frame.
+static bool EnhanceNodeColor(DrawingNode& node, float threshold) {
+    if (!node.needs_enhance || threshold < 0.0f || node.color_pixels.empty()) return false;
+    cv::Mat padded;
+    cv::copyMakeBorder(node.color_pixels, padded, kEnhancePadding, kEnhancePadding,
+                       kEnhancePadding, kEnhancePadding, cv::BORDER_REPLICATE);
+    const cv::Rect inner(kEnhancePadding, kEnhancePadding,
+                         node.color_pixels.cols, node.color_pixels.rows);
+    node.color_pixels = WhiteboardEnhance(padded, threshold)(inner).clone();
+    node.needs_enhance = false;
+    node.content_revision++;
+    return true;
+}
+
 
 static cv::Point2f ComputeGravityCenter(const cv::Mat& mask) {
     if (mask.empty()) return {};
@@ -110,6 +175,31 @@ static cv::Point2f ComputeGravityCenter(const cv::Mat& mask) {
                        : cv::Point2f{};
 }
 
+// Bump allocator over one refcounted Mat. Each Take() is a continuous view into
+// the block, so a frame's component masks cost one allocation, and the block
+// lives as long as any FrameBlob still holds a view of it.
+class MatArena {
+public:
+    MatArena(size_t total_pixels, int type, bool zeroed) : type_(type) {
+        if (total_pixels == 0) return;
+        block_ = zeroed ? cv::Mat::zeros(1, (int)total_pixels, type)
+                        : cv::Mat(1, (int)total_pixels, type);
+    }
+
+    cv::Mat Take(const cv::Size& size) {
+        const int n = size.area();
+        if (n <= 0 || offset_ + n > block_.cols) return cv::Mat::zeros(size, type_);
+        cv::Mat view = block_.colRange(offset_, offset_ + n).reshape(0, size.height);
+        offset_ += n;
+        return view;
+    }
+
+private:
+    cv::Mat block_;
+    int     type_;
+    int     offset_ = 0;
+};
+
 static float ComputeScaleForLongEdge(const cv::Size& size, int max_long_edge) {
     if (size.width <= 0 || size.height <= 0 || max_long_edge <= 0) return 1.0f;
     int le = std::max(size.width, size.height);
@@ -181,8 +271,12 @@ static cv::Mat BuildShapeCompareMask(const cv::Mat& mask) {
     return smoothed;
 }
 
-static bool ComputeHuFromMask(const cv::Mat& mask, double hu[7]) {
+// smoothed_out, when given, receives the BuildShapeCompareMask result so the
+// caller can reuse it instead of blurring the mask again.
+static bool ComputeHuFromMask(const cv::Mat& mask, double hu[7],
+                              cv::Mat* smoothed_out = nullptr) {
     const cv::Mat smoothed = BuildShapeCompareMask(mask);
+    if (smoothed_out) *smoothed_out = smoothed;
     if (smoothed.empty() || cv::countNonZero(smoothed) <= 0) return false;
     const cv::Moments moments = cv::moments(smoothed, true);
     if (std::abs(moments.m00) <= 1e-6) return false;
@@ -190,29 +284,10 @@ static bool ComputeHuFromMask(const cv::Mat& mask, double hu[7]) {
     return true;
 }
 
-// Compute and cache hu_smooth (Hu from BuildShapeCompareMask) and hu_log (log-space features).
-// Call once after setting binary_mask and raw hu on a blob or node.
-static void PopulateHuCache(const cv::Mat& binary_mask,
-                             const double hu_raw[7],
-                             double hu_smooth_out[7],
-                             bool& hu_smooth_valid_out,
-                             float hu_log_out[7]) {
-    hu_smooth_valid_out = ComputeHuFromMask(binary_mask, hu_smooth_out);
-    const double* src = hu_smooth_valid_out ? hu_smooth_out : hu_raw;
-    const auto log_features = ComputeLogHuFeatures(src);
-    std::copy(log_features.begin(), log_features.end(), hu_log_out);
-}
-
-static std::vector<cv::Point> ExtractLargestContour(const cv::Mat& mask) {
-    std::vector<cv::Point> contour;
-    if (mask.empty() || mask.type() != CV_8UC1) return contour;
-
-    const cv::Mat smoothed = BuildShapeCompareMask(mask);
-    const cv::Mat& source = smoothed.empty() ? mask : smoothed;
-
+static std::vector<cv::Point> LargestContourOf(const cv::Mat& source) {
     std::vector<std::vector<cv::Point>> contours;
     cv::findContours(source.clone(), contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
-    if (contours.empty()) return contour;
+    if (contours.empty()) return {};
 
     size_t best_idx = 0;
     double best_area = -1.0;
@@ -226,6 +301,12 @@ static std::vector<cv::Point> ExtractLargestContour(const cv::Mat& mask) {
     return contours[best_idx];
 }
 
+static std::vector<cv::Point> ExtractLargestContour(const cv::Mat& mask) {
+    if (mask.empty() || mask.type() != CV_8UC1) return {};
+    const cv::Mat smoothed = BuildShapeCompareMask(mask);
+    return LargestContourOf(smoothed.empty() ? mask : smoothed);
+}
+
 static std::vector<cv::Point> SampleContourForShapeContext(
         const std::vector<cv::Point>& contour) {
     if (contour.size() <= kShapeContextSamplePointCount) return contour;
@@ -242,28 +323,54 @@ static std::vector<cv::Point> SampleContourForShapeContext(
     return sampled;
 }
 
-static std::vector<cv::Point> GetContourForShapeContext(
-        const std::vector<cv::Point>* contour,
-        const cv::Mat* mask) {
-    if (mask)
-        return SampleContourForShapeContext(ExtractLargestContour(*mask));
-    if (contour && contour->size() >= 3)
-        return SampleContourForShapeContext(*contour);
-    return {};
+// Compute and cache the shape-compare features of a blob or node: hu_smooth
+// (Hu from BuildShapeCompareMask), hu_log (log-space features) and the sampled
+// smooth-mask contour used by the shape-context term. Call once after setting
+// binary_mask and raw hu; TotalShapeCompare then never re-blurs the mask.
+static void PopulateHuCache(const cv::Mat& binary_mask,
+                             const double hu_raw[7],
+                             double hu_smooth_out[7],
+                             bool& hu_smooth_valid_out,
+                             float hu_log_out[7],
+                             std::vector<cv::Point>& shape_context_contour_out) {
+    hu_smooth_valid_out = false;
+    shape_context_contour_out.clear();
+    if (!binary_mask.empty() && binary_mask.type() == CV_8UC1) {
+        cv::Mat smoothed;
+        hu_smooth_valid_out = ComputeHuFromMask(binary_mask, hu_smooth_out, &smoothed);
+        shape_context_contour_out = SampleContourForShapeContext(
+            LargestContourOf(smoothed.empty() ? binary_mask : smoothed));
+    }
+    const double* src = hu_smooth_valid_out ? hu_smooth_out : hu_raw;
+    const auto log_features = ComputeLogHuFeatures(src);
+    std::copy(log_features.begin(), log_features.end(), hu_log_out);
+}
+
+// Cached samples when the caller has them; otherwise derive them from the mask
+// (or the raw contour) on the spot.
+static const std::vector<cv::Point>& GetContourForShapeContext(
+        const std::vector<cv::Point>* cached_contour,
+        const cv::Mat* mask,
+        std::vector<cv::Point>& scratch) {
+    if (cached_contour) return *cached_contour;
+    scratch.clear();
+    if (mask) scratch = SampleContourForShapeContext(ExtractLargestContour(*mask));
+    return scratch;
 }
 
 static bool ComputeDominantContourSimilarity(
-        const std::vector<cv::Point>* first_contour,
+        const std::vector<cv::Point>* first_sc_contour,
         const cv::Mat* first_mask,
-        const std::vector<cv::Point>* second_contour,
+        const std::vector<cv::Point>* second_sc_contour,
         const cv::Mat* second_mask,
         float& distance,
         float& similarity,
         bool& used_shape_context) {
-    const std::vector<cv::Point> first =
-        GetContourForShapeContext(first_contour, first_mask);
-    const std::vector<cv::Point> second =
-        GetContourForShapeContext(second_contour, second_mask);
+    std::vector<cv::Point> first_scratch, second_scratch;
+    const std::vector<cv::Point>& first =
+        GetContourForShapeContext(first_sc_contour, first_mask, first_scratch);
+    const std::vector<cv::Point>& second =
+        GetContourForShapeContext(second_sc_contour, second_mask, second_scratch);
     if (first.size() < 3 || second.size() < 3) return false;
 
 #if KAPTCHI_HAS_OPENCV_SHAPE
@@ -393,6 +500,10 @@ static const cv::Mat& GetRenderCacheForMode(const WhiteboardGroup& g, CanvasRend
     return m == CanvasRenderMode::kRaw ? g.raw_render_cache : g.stroke_render_cache;
 }
 
+static OverviewPyramid& GetOverviewPyramidForMode(WhiteboardGroup& g, CanvasRenderMode m) {
+    return m == CanvasRenderMode::kRaw ? g.raw_pyramid : g.stroke_pyramid;
+}
+
 static bool GetRenderBoundsForMode(const WhiteboardGroup& g, CanvasRenderMode m,
                                    int& mnx, int& mny, int& mxx, int& mxy) {
     if (m == CanvasRenderMode::kRaw) {
@@ -616,7 +727,7 @@ struct TotalShapeCompareResult {
 struct DuplicateCandidateView {
     cv::Rect bbox;
     const cv::Mat* mask = nullptr;
-    const std::vector<cv::Point>* contour = nullptr;
+    const std::vector<cv::Point>* shape_context_contour = nullptr;  // cached samples
     cv::Point2f centroid;
     const double* hu = nullptr;
     const double* hu_smooth = nullptr;  // nullable; avoids BuildShapeCompareMask in TotalShapeCompare
@@ -709,6 +820,7 @@ static bool ConvertNodeToGhost(WhiteboardGroup& group,
     bool changed = MarkDuplicateDebugInfo(node, partner_id, check);
     if (!was_ghost) {
         group.spatial_index.Remove(node.id, node.centroid_canvas);
+        group.shape_index.Remove(node.id, node.area);
         RemoveHardEdges(group, node.id);
         changed = true;
     }
@@ -725,6 +837,7 @@ static bool RemoveDuplicateGhostNodes(WhiteboardGroup& group) {
         auto it = group.nodes.find(nid);
         if (it == group.nodes.end()) continue;
         group.spatial_index.Remove(nid, it->second->centroid_canvas);
+        group.shape_index.Remove(nid, it->second->area);
         group.nodes.erase(it);
     }
     return !ghost_ids.empty();
@@ -740,6 +853,7 @@ static DrawingNode* AddNodeFromBlob(WhiteboardGroup& group,
     node->id = group.next_node_id++;
     node->binary_mask = blob.binary_mask.clone();
     if (!blob.color_pixels.empty()) node->color_pixels = blob.color_pixels.clone();
+    node->needs_enhance = !node->color_pixels.empty() && !blob.color_enhanced;
     node->bbox_canvas = canvas_bbox;
     node->centroid_canvas = canvas_centroid;
     node->contour = blob.contour;
@@ -747,6 +861,7 @@ static DrawingNode* AddNodeFromBlob(WhiteboardGroup& group,
     std::copy(blob.hu_smooth, blob.hu_smooth + 7, node->hu_smooth);
     node->hu_smooth_valid = blob.hu_smooth_valid;
     std::copy(blob.hu_log, blob.hu_log + 7, node->hu_log);
+    node->shape_context_contour = blob.shape_context_contour;
     node->area = blob.area;
     node->absence_score = kAbsenceScoreInitial;
     node->has_crossed_absence_seen_threshold =
@@ -758,6 +873,7 @@ static DrawingNode* AddNodeFromBlob(WhiteboardGroup& group,
     DrawingNode* raw_node = node.get();
     if (add_to_spatial_index) {
         group.spatial_index.Insert(nid, canvas_centroid);
+        group.shape_index.Insert(nid, node->area, node->hu_log, node->hu_smooth_valid);
     }
     group.nodes[nid] = std::move(node);
     return raw_node;
@@ -804,12 +920,12 @@ static TotalShapeCompareResult TotalShapeCompare(const cv::Rect& first_bbox,
                                                  const cv::Mat* first_mask,
                                                  const double* first_hu,
                                                  const double* first_hu_smooth,
-                                                 const std::vector<cv::Point>* first_contour,
+                                                 const std::vector<cv::Point>* first_sc_contour,
                                                  const cv::Rect& second_bbox,
                                                  const cv::Mat* second_mask,
                                                  const double* second_hu,
                                                  const double* second_hu_smooth,
-                                                 const std::vector<cv::Point>* second_contour) {
+                                                 const std::vector<cv::Point>* second_sc_contour) {
     TotalShapeCompareResult result;
     if (first_bbox.width <= 0 || first_bbox.height <= 0 ||
         second_bbox.width <= 0 || second_bbox.height <= 0) {
@@ -836,9 +952,9 @@ static TotalShapeCompareResult TotalShapeCompare(const cv::Rect& first_bbox,
     float weighted_difference = 0.0f;
     float total_weight = 0.0f;
     bool strong_component_match = false;
-    if (ComputeDominantContourSimilarity(first_contour,
+    if (ComputeDominantContourSimilarity(first_sc_contour,
                                          first_mask,
-                                         second_contour,
+                                         second_sc_contour,
                                          second_mask,
                                          result.shape_context_distance,
                                          result.shape_context_similarity,
@@ -935,9 +1051,9 @@ static DuplicateCheckResult EvaluateDuplicateCandidate(
         : 0.0f;
     result.same_creation_frame = first.created_frame == second.created_frame;
     result.shape_difference = TotalShapeCompare(
-        first.bbox,  first.mask,  first.hu,  first.hu_smooth,  first.contour,
+        first.bbox,  first.mask,  first.hu,  first.hu_smooth,  first.shape_context_contour,
         centroid_aligned_bbox,
-        second.mask, second.hu, second.hu_smooth, second.contour).difference;
+        second.mask, second.hu, second.hu_smooth, second.shape_context_contour).difference;
     if (result.positional_overlap > duplicate_pos_overlap_threshold)
         result.reason_mask |= kDuplicateReasonPositionalOverlap;
     if (result.centroid_iou > duplicate_centroid_iou_threshold)
@@ -957,18 +1073,25 @@ static void RefreshNodeFromBlob(WhiteboardGroup& group, DrawingNode& node,
                                 const cv::Point2f& canvas_centroid,
                                 const cv::Rect& canvas_bbox) {
     group.spatial_index.Remove(node.id, node.centroid_canvas);
+    group.shape_index.Remove(node.id, node.area);
     node.centroid_canvas = canvas_centroid;
     node.bbox_canvas     = canvas_bbox;
     node.binary_mask     = blob.binary_mask.clone();
-    if (!blob.color_pixels.empty()) node.color_pixels = blob.color_pixels.clone();
+    if (!blob.color_pixels.empty()) {
+        node.color_pixels = blob.color_pixels.clone();
+        node.needs_enhance = !blob.color_enhanced;
+    }
+    node.content_revision++;
     node.contour = blob.contour;
     std::copy(blob.hu, blob.hu + 7, node.hu);
     std::copy(blob.hu_smooth, blob.hu_smooth + 7, node.hu_smooth);
     node.hu_smooth_valid = blob.hu_smooth_valid;
     std::copy(blob.hu_log, blob.hu_log + 7, node.hu_log);
+    node.shape_context_contour = blob.shape_context_contour;
     node.area = blob.area;
     ClearDuplicateDebugInfo(node);
     group.spatial_index.Insert(node.id, canvas_centroid);
+    group.shape_index.Insert(node.id, node.area, node.hu_log, node.hu_smooth_valid);
 }
 
 static bool InsertOrMergeBlobNode(WhiteboardGroup& group,
@@ -989,7 +1112,7 @@ static bool InsertOrMergeBlobNode(WhiteboardGroup& group,
                                          merge_search_radius_px});
         const auto nearby = group.spatial_index.QueryRadius(canvas_centroid, search_r);
         const DuplicateCandidateView blob_candidate{
-            canvas_bbox, &blob.binary_mask, &blob.contour, canvas_centroid,
+            canvas_bbox, &blob.binary_mask, &blob.shape_context_contour, canvas_centroid,
             blob.hu, blob.hu_smooth_valid ? blob.hu_smooth : nullptr, current_frame};
         for (int nid : nearby) {
             if (group.user_deleted_ids.count(nid)) continue;
@@ -1003,7 +1126,7 @@ static bool InsertOrMergeBlobNode(WhiteboardGroup& group,
             // and cannot be a duplicate of it.
             if (existing.last_seen_frame == current_frame) continue;
             const DuplicateCandidateView existing_candidate{
-                existing.bbox_canvas, &existing.binary_mask, &existing.contour,
+                existing.bbox_canvas, &existing.binary_mask, &existing.shape_context_contour,
                 existing.centroid_canvas,
                 existing.hu, existing.hu_smooth_valid ? existing.hu_smooth : nullptr,
                 existing.created_frame};
@@ -1308,6 +1431,45 @@ static bool IsBetterSweepMergeCandidate(const SweepMergeCandidate& candidate,
     return candidate_second < best_second;
 }
 
+// Overlap pixel counts of two binary masks for every relative placement, in
+// one pass: out(oy + h2 - 1, ox + w2 - 1) is the number of pixels set in both
+// masks when the second mask's top-left sits at (ox, oy) in the first mask's
+// frame. Circular cross-correlation via the DFT, padded so nothing wraps; the
+// double-precision result is exact after rounding for any realistic mask size.
+static cv::Mat ComputeMaskOverlapSurface(const cv::Mat& first_mask,
+                                         const cv::Mat& second_mask) {
+    const int w1 = first_mask.cols, h1 = first_mask.rows;
+    const int w2 = second_mask.cols, h2 = second_mask.rows;
+    const int dft_w = cv::getOptimalDFTSize(w1 + w2 - 1);
+    const int dft_h = cv::getOptimalDFTSize(h1 + h2 - 1);
+
+    cv::Mat first_f = cv::Mat::zeros(dft_h, dft_w, CV_64F);
+    cv::Mat second_f = cv::Mat::zeros(dft_h, dft_w, CV_64F);
+    cv::Mat first_bits = first_mask != 0;
+    cv::Mat second_bits = second_mask != 0;
+    first_bits.convertTo(first_f(cv::Rect(0, 0, w1, h1)), CV_64F, 1.0 / 255.0);
+    second_bits.convertTo(second_f(cv::Rect(0, 0, w2, h2)), CV_64F, 1.0 / 255.0);
+
+    cv::Mat first_spec, second_spec, product, correlation;
+    cv::dft(first_f, first_spec, cv::DFT_COMPLEX_OUTPUT, h1);
+    cv::dft(second_f, second_spec, cv::DFT_COMPLEX_OUTPUT, h2);
+    cv::mulSpectrums(first_spec, second_spec, product, 0, /*conjB=*/true);
+    cv::dft(product, correlation, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+
+    // correlation(o mod (W, H)) = sum_p first(p + o) * second(p), which is the
+    // overlap with the second mask placed at o. Unwrap the negative offsets
+    // into a dense (h1+h2-1) x (w1+w2-1) grid.
+    cv::Mat surface(h1 + h2 - 1, w1 + w2 - 1, CV_32S);
+    for (int oy = -(h2 - 1); oy <= h1 - 1; oy++) {
+        const double* row = correlation.ptr<double>(oy >= 0 ? oy : dft_h + oy);
+        int* out = surface.ptr<int>(oy + h2 - 1);
+        for (int ox = -(w2 - 1); ox <= w1 - 1; ox++) {
+            out[ox + w2 - 1] = (int)std::lround(row[ox >= 0 ? ox : dft_w + ox]);
+        }
+    }
+    return surface;
+}
+
 static SlidingMaskIouResult ComputeBestSlidingMaskIou(const cv::Rect& first_bbox,
                                                       const cv::Mat& first_mask,
                                                       const cv::Rect& second_bbox,
@@ -1342,40 +1504,22 @@ static SlidingMaskIouResult ComputeBestSlidingMaskIou(const cv::Rect& first_bbox
     max_dy = std::min(max_dy, max_slide_px);
     if (min_dx > max_dx || min_dy > max_dy) return result;
 
+    // Every (dx, dy) in range keeps the boxes intersecting, so each one is a
+    // lookup into the overlap surface. Scan order and tie-breaks match the
+    // original per-offset sweep: best IoU, then overlap/min, then smallest move.
+    const cv::Mat surface = ComputeMaskOverlapSurface(first_mask, second_mask);
+    const int base_ox = second_bbox.x - first_bbox.x + second_mask.cols - 1;
+    const int base_oy = second_bbox.y - first_bbox.y + second_mask.rows - 1;
+    const int min_px = std::max(1, std::min(first_px, second_px));
+
     int best_move_dist2 = std::numeric_limits<int>::max();
     for (int dy = min_dy; dy <= max_dy; dy++) {
+        const int* overlap_row = surface.ptr<int>(base_oy + dy);
         for (int dx = min_dx; dx <= max_dx; dx++) {
-            const cv::Rect shifted_second(second_bbox.x + dx,
-                                          second_bbox.y + dy,
-                                          second_bbox.width,
-                                          second_bbox.height);
-            const cv::Rect isect = first_bbox & shifted_second;
-            if (isect.width <= 0 || isect.height <= 0) continue;
-
-            const cv::Rect first_local(isect.x - first_bbox.x,
-                                       isect.y - first_bbox.y,
-                                       isect.width,
-                                       isect.height);
-            const cv::Rect second_local(isect.x - shifted_second.x,
-                                        isect.y - shifted_second.y,
-                                        isect.width,
-                                        isect.height);
-            if (first_local.x < 0 || first_local.y < 0 ||
-                first_local.x + first_local.width > first_mask.cols ||
-                first_local.y + first_local.height > first_mask.rows ||
-                second_local.x < 0 || second_local.y < 0 ||
-                second_local.x + second_local.width > second_mask.cols ||
-                second_local.y + second_local.height > second_mask.rows) {
-                continue;
-            }
-
-            cv::Mat overlap;
-            cv::bitwise_and(first_mask(first_local), second_mask(second_local), overlap);
-            const int overlap_px = cv::countNonZero(overlap);
+            const int overlap_px = overlap_row[base_ox + dx];
             const int union_px = first_px + second_px - overlap_px;
             const float iou = (float)overlap_px / (float)std::max(1, union_px);
-            const float overlap_over_min =
-                (float)overlap_px / (float)std::max(1, std::min(first_px, second_px));
+            const float overlap_over_min = (float)overlap_px / (float)min_px;
             const int move_dist2 = dx * dx + dy * dy;
 
             const bool better = !result.valid ||
@@ -1497,7 +1641,8 @@ static bool BuildMergedBlobFromNodes(const DrawingNode& first,
         }
     }
     PopulateHuCache(merged_mask, merged_blob.hu,
-                    merged_blob.hu_smooth, merged_blob.hu_smooth_valid, merged_blob.hu_log);
+                    merged_blob.hu_smooth, merged_blob.hu_smooth_valid, merged_blob.hu_log,
+                    merged_blob.shape_context_contour);
     return true;
 }
 
@@ -1550,10 +1695,18 @@ static bool MergeNodePairIntoFreshNode(WhiteboardGroup& group,
     DrawingNode& second = *second_it->second;
     if (IsGhostNode(first) || IsGhostNode(second)) return false;
 
+    // Composite like with like: enhance the raw half if only one node still
+    // holds camera pixels, so the merged node is wholly enhanced or wholly raw.
+    if (first.needs_enhance != second.needs_enhance) {
+        const float threshold = g_canvas_enhance_threshold.load();
+        EnhanceNodeColor(first, threshold);
+        EnhanceNodeColor(second, threshold);
+    }
     FrameBlob merged_blob;
     if (!BuildMergedBlobFromNodes(first, second, second_dx, second_dy, merged_blob)) {
         return false;
     }
+    merged_blob.color_enhanced = !first.needs_enhance && !second.needs_enhance;
 
     DrawingNode* merged_node = AddNodeFromBlob(
         group,
@@ -1578,6 +1731,8 @@ static bool MergeNodePairIntoFreshNode(WhiteboardGroup& group,
     RemoveHardEdges(group, second_id);
     group.spatial_index.Remove(first_id, first.centroid_canvas);
     group.spatial_index.Remove(second_id, second.centroid_canvas);
+    group.shape_index.Remove(first_id, first.area);
+    group.shape_index.Remove(second_id, second.area);
     group.nodes.erase(first_id);
     group.nodes.erase(second_id);
     return true;
@@ -1782,6 +1937,7 @@ static bool SweepGraphDuplicates(WhiteboardGroup& group,
             auto remove_it = group.nodes.find(remove_id);
             if (remove_it == group.nodes.end()) continue;
             group.spatial_index.Remove(remove_id, remove_it->second->centroid_canvas);
+            group.shape_index.Remove(remove_id, remove_it->second->area);
             group.nodes.erase(remove_it);
         }
 
@@ -1792,7 +1948,47 @@ static bool SweepGraphDuplicates(WhiteboardGroup& group,
     return changed;
 }
 
-static bool RenderOverviewToFrame(const cv::Mat& cache, cv::Size vs, cv::Mat& out) {
+// Box-filters src(2 * dst_rect) into dst(dst_rect). INTER_AREA at an exact
+// factor of 2 averages aligned 2x2 blocks, so a partial update is bit-identical
+// to downsampling the whole level.
+static void DownsampleRegion(const cv::Mat& src, cv::Mat& dst, const cv::Rect& dst_rect) {
+    if (dst_rect.area() <= 0) return;
+    cv::Rect src_rect(dst_rect.x * 2, dst_rect.y * 2, dst_rect.width * 2, dst_rect.height * 2);
+    cv::Mat dst_roi = dst(dst_rect);
+    cv::resize(src(src_rect), dst_roi, dst_rect.size(), 0, 0, cv::INTER_AREA);
+}
+
+static void UpdateOverviewPyramid(const cv::Mat& cache, OverviewPyramid& pyr) {
+    if (!pyr.valid) {
+        pyr.levels.clear();
+        const cv::Mat* prev = &cache;
+        while (std::max(prev->cols, prev->rows) / 2 >= OverviewPyramid::kMinLevelSide &&
+               prev->cols >= 2 && prev->rows >= 2) {
+            pyr.levels.emplace_back(prev->rows / 2, prev->cols / 2, CV_8UC3);
+            cv::Mat& level = pyr.levels.back();
+            DownsampleRegion(*prev, level, cv::Rect(0, 0, level.cols, level.rows));
+            prev = &level;
+        }
+        pyr.valid = true;
+        pyr.dirty = cv::Rect();
+        return;
+    }
+
+    cv::Rect r = pyr.dirty & cv::Rect(0, 0, cache.cols, cache.rows);
+    const cv::Mat* prev = &cache;
+    for (auto& level : pyr.levels) {
+        if (r.area() <= 0) break;
+        const int x0 = r.x / 2, y0 = r.y / 2;
+        const int x1 = (r.x + r.width + 1) / 2, y1 = (r.y + r.height + 1) / 2;
+        r = cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect(0, 0, level.cols, level.rows);
+        DownsampleRegion(*prev, level, r);
+        prev = &level;
+    }
+    pyr.dirty = cv::Rect();
+}
+
+static bool RenderOverviewToFrame(const cv::Mat& cache, const OverviewPyramid& pyr,
+                                  cv::Size vs, cv::Mat& out) {
     if (cache.empty() || vs.width <= 0 || vs.height <= 0) return false;
     out = cv::Mat(vs.height, vs.width, CV_8UC3, cv::Scalar(255, 255, 255));
     float sa = (float)cache.cols / (float)std::max(1, cache.rows);
@@ -1800,31 +1996,138 @@ static bool RenderOverviewToFrame(const cv::Mat& cache, cv::Size vs, cv::Mat& ou
     int dw = vs.width, dh = vs.height;
     if (sa > da) dh = std::max(1, (int)std::round(dw / sa));
     else         dw = std::max(1, (int)std::round(dh * sa));
+    // Smallest pyramid level that still covers the output; the final INTER_AREA
+    // pass then touches at most ~4x the output pixels.
+    const cv::Mat* source = &cache;
+    for (const auto& level : pyr.levels) {
+        if (level.cols < dw || level.rows < dh) break;
+        source = &level;
+    }
     cv::Mat scaled;
-    cv::resize(cache, scaled, cv::Size(dw, dh), 0, 0, cv::INTER_AREA);
+    cv::resize(*source, scaled, cv::Size(dw, dh), 0, 0, cv::INTER_AREA);
     int ox = (vs.width - dw) / 2, oy = (vs.height - dh) / 2;
     scaled.copyTo(out(cv::Rect(ox, oy, dw, dh)));
     return true;
 }
 
-static bool CopyBgrFrameToRgbaBuffer(const cv::Mat& bgr, uint8_t* buf, int w, int h) {
-    if (bgr.empty() || !buf || w <= 0 || h <= 0) return false;
-    cv::Mat rgba; cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
-    cv::Mat view(h, w, CV_8UC4, buf);
-    rgba.copyTo(view);
-    return true;
-}
-
 } // namespace
 
+// Ranks with ComputeHuDistanceLog so the index and the matcher agree on the
+// distance they gate on.
+void ShapeDescriptorIndex::QueryTopK(double area, const float hu_log[7], bool hu_valid,
+                                     float min_area_ratio, float max_hu_distance, int k,
+                                     std::vector<int>& out) const {
+    std::vector<std::pair<float, int>> ranked;
+    std::vector<int> unranked;
+    auto consider = [&](const Entry& e) {
+        if (e.area > 0.0) {
+            const float ratio = (float)(area / e.area);
+            if (ratio < min_area_ratio || ratio > (1.0f / min_area_ratio)) return;
+        }
+        if (!hu_valid || !e.hu_valid) { unranked.push_back(e.id); return; }
+        const float d = ComputeHuDistanceLog(hu_log, e.hu_log);
+        if (d <= max_hu_distance) ranked.push_back({d, e.id});
+    };
+
+    if (area > 0.0 && min_area_ratio > 0.0f) {
+        // One spare bucket on each side absorbs float rounding at the edges.
+        const double span = std::log(1.0 / min_area_ratio);
+        const double la = std::log(area);
+        const int lo = (int)std::floor((la - span) / log_area_bucket_) - 1;
+        const int hi = (int)std::floor((la + span) / log_area_bucket_) + 1;
+        for (int b = lo; b <= hi; b++) {
+            auto it = buckets_.find(b);
+            if (it == buckets_.end()) continue;
+            for (const auto& e : it->second) consider(e);
+        }
+    } else {
+        for (const auto& [b, entries] : buckets_)
+            for (const auto& e : entries) consider(e);
+    }
+    for (const auto& e : unsized_) consider(e);
+
+    const size_t keep = std::min(ranked.size(), (size_t)std::max(k, 0));
+    std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end());
+    for (size_t i = 0; i < keep; i++) out.push_back(ranked[i].second);
+    out.insert(out.end(), unranked.begin(), unranked.end());
+}
+
+// The Gaussian window of adaptiveThreshold reaches kBinarizeBlockSize / 2 px, so a
+// band thresholded with that much halo on each side is bit-identical to the same
+// columns of a full-frame threshold (image edges replicate in both cases).
+const cv::Mat& WhiteboardCanvas::ThresholdChangedBands(const cv::Mat& small_gray,
+                                                      const cv::Rect& lecturer_rect,
+                                                      BinarizeRoiState& state) {
+    if (state.small_threshold.empty() || state.ref_small_gray.size() != small_gray.size()) {
+        cv::adaptiveThreshold(small_gray, state.small_threshold, 255,
+                              cv::ADAPTIVE_THRESH_GAUSSIAN_C,
+                              cv::THRESH_BINARY_INV, kBinarizeBlockSize, kBinarizeOffset);
+        small_gray.copyTo(state.ref_small_gray);
+        return state.small_threshold;
+    }
+
+    const int W = small_gray.cols, H = small_gray.rows;
+    cv::Rect lecturer_small;
+    if (lecturer_rect.width > 0 && lecturer_rect.height > 0) {
+        const int pad = std::max(1, (int)std::lround(W * kRoiBinarizeLecturerPadFraction));
+        lecturer_small = ExpandRectWithinFrame(
+            cv::Rect(lecturer_rect.x / 2, lecturer_rect.y / 2,
+                     (lecturer_rect.width + 1) / 2, (lecturer_rect.height + 1) / 2),
+            small_gray.size(), pad, pad);
+    }
+
+    cv::Mat changed;
+    cv::absdiff(small_gray, state.ref_small_gray, changed);
+    cv::threshold(changed, changed, kMotionPixelThreshold, 255, cv::THRESH_BINARY);
+
+    const int band_count = (W + kRoiBinarizeBandWidth - 1) / kRoiBinarizeBandWidth;
+    std::vector<char> dirty(band_count, 0);
+    for (int b = 0; b < band_count; b++) {
+        const int x0 = b * kRoiBinarizeBandWidth;
+        const int x1 = std::min(W, x0 + kRoiBinarizeBandWidth);
+        // Bands under the lecturer keep the result from the last clean view.
+        if (lecturer_small.width > 0 && lecturer_small.x <= x0 &&
+            lecturer_small.x + lecturer_small.width >= x1) continue;
+        if (cv::countNonZero(changed(cv::Rect(x0, 0, x1 - x0, H))) < kRoiBinarizeBandChangePixels)
+            continue;
+        dirty[b] = 1;
+    }
+
+    const int halo = kBinarizeBlockSize / 2;
+    for (int b = 0; b < band_count;) {
+        if (!dirty[b]) { b++; continue; }
+        int e = b;
+        while (e < band_count && dirty[e]) e++;
+        const int x0 = b * kRoiBinarizeBandWidth;
+        const int x1 = std::min(W, e * kRoiBinarizeBandWidth);
+        const int hx0 = std::max(0, x0 - halo), hx1 = std::min(W, x1 + halo);
+        cv::Mat run;
+        cv::adaptiveThreshold(small_gray(cv::Rect(hx0, 0, hx1 - hx0, H)), run, 255,
+                              cv::ADAPTIVE_THRESH_GAUSSIAN_C,
+                              cv::THRESH_BINARY_INV, kBinarizeBlockSize, kBinarizeOffset);
+        const cv::Rect band(x0, 0, x1 - x0, H);
+        run(cv::Rect(x0 - hx0, 0, x1 - x0, H)).copyTo(state.small_threshold(band));
+        small_gray(band).copyTo(state.ref_small_gray(band));
+        b = e;
+    }
+    return state.small_threshold;
+}
+
 cv::Mat WhiteboardCanvas::BuildBinaryMask(const cv::Mat& gray, const cv::Mat& no_update_mask,
+                                           const cv::Rect& lecturer_rect,
+                                           BinarizeRoiState* roi_state,
                                            int& stroke_pixel_count) {
     cv::Mat small_gray;
     cv::resize(gray, small_gray, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
     cv::Mat small_binary;
-    cv::adaptiveThreshold(small_gray, small_binary, 255,
-                          cv::ADAPTIVE_THRESH_GAUSSIAN_C,
-                          cv::THRESH_BINARY_INV, kBinarizeBlockSize, kBinarizeOffset);
+    if (kEnableRoiBinarization && roi_state) {
+        // Copy: the small-component filter below edits small_binary in place.
+        ThresholdChangedBands(small_gray, lecturer_rect, *roi_state).copyTo(small_binary);
+    } else {
+        cv::adaptiveThreshold(small_gray, small_binary, 255,
+                              cv::ADAPTIVE_THRESH_GAUSSIAN_C,
+                              cv::THRESH_BINARY_INV, kBinarizeBlockSize, kBinarizeOffset);
+    }
     {
         cv::Mat labels, stats, centroids;
         int n = cv::connectedComponentsWithStats(small_binary, labels, stats, centroids);
@@ -1847,10 +2150,12 @@ cv::Mat WhiteboardCanvas::BuildBinaryMask(const cv::Mat& gray, const cv::Mat& no
 //  SECTION 3: Constructor / Destructor
 // ============================================================================
 
-WhiteboardCanvas::WhiteboardCanvas() {
+WhiteboardCanvas::WhiteboardCanvas(CanvasExecutionMode mode) : execution_mode_(mode) {
     stop_worker_ = false;
     duplicate_debug_mode_ = g_duplicate_debug_mode.load();
 
+    if (execution_mode_ == CanvasExecutionMode::kInline) return;
+
     if (!IsWhiteboardCanvasHelperProcess()) {
         auto client = std::make_unique<WhiteboardCanvasHelperClient>();
         if (client && client->Start()) {
@@ -1882,7 +2187,10 @@ void WhiteboardCanvas::SyncRuntimeSettings() {
                                      g_duplicate_debug_mode.load(),
                                      g_absence_score_seen_threshold.load(),
                                      g_canvas_enhance_threshold.load(),
-                                     g_yolo_fps.load());
+                                     g_yolo_fps.load(),
+                                     g_person_detector_backend.load(),
+                                     g_person_detector_precision.load(),
+                                     g_person_detector_threads.load());
     }
 }
 
@@ -1944,20 +2252,88 @@ bool WhiteboardCanvas::IsDuplicateDebugMode() const {
 
 void WhiteboardCanvas::InvalidateRenderCaches() {
     std::lock_guard<std::mutex> lock(state_mutex_);
-    for (auto& g : groups_) { g->stroke_cache_dirty = true; g->raw_cache_dirty = true; }
+    for (auto& g : groups_) {
+        g->stroke_cache_dirty = true; g->raw_cache_dirty = true;
+        g->stroke_tiles.Clear();      g->raw_tiles.Clear();
+    }
     BumpCanvasVersion();
 }
 
 bool WhiteboardCanvas::EnsureRenderCacheReady(WhiteboardGroup& group,
                                                CanvasRenderMode mode) {
     if (mode == CanvasRenderMode::kRaw) {
-        if (group.raw_cache_dirty) { RebuildRawRenderCache(group); group.raw_cache_dirty = false; }
+        // Nodes captured in stroke mode are enhanced on the first raw render.
+        const float threshold = g_canvas_enhance_threshold.load();
+        for (auto& [_, node] : group.nodes)
+            if (EnhanceNodeColor(*node, threshold)) group.raw_cache_dirty = true;
+        if (group.raw_cache_dirty) { RefreshRenderCache(group, mode); group.raw_cache_dirty = false; }
     } else {
-        if (group.stroke_cache_dirty) { RebuildStrokeRenderCache(group); group.stroke_cache_dirty = false; }
+        if (group.stroke_cache_dirty) { RefreshRenderCache(group, mode); group.stroke_cache_dirty = false; }
     }
     return !GetRenderCacheForMode(group, mode).empty();
 }
 
+bool WhiteboardCanvas::RenderOverviewMemoized(WhiteboardGroup& group, int group_idx,
+                                              CanvasRenderMode mode, cv::Size view_size,
+                                              cv::Mat& out_frame) {
+    RenderOutputKey key;
+    key.version = GetCanvasVersion();
+    key.mode = mode;
+    key.group_idx = group_idx;
+    key.kind = RenderOutputKind::kOverview;
+    key.size = view_size;
+    if (LookupRenderOutput(key, out_frame)) return true;
+    if (!EnsureRenderCacheReady(group, mode)) return false;
+    const OverviewPyramid& pyramid = EnsureOverviewPyramid(group, mode);
+    cv::Mat rendered;
+    if (!RenderOverviewToFrame(GetRenderCacheForMode(group, mode), pyramid, view_size, rendered))
+        return false;
+    StoreRenderOutput(key, rendered);
+    out_frame = rendered;
+    return true;
+}
+
+bool WhiteboardCanvas::LookupRenderOutput(const RenderOutputKey& key, cv::Mat& out) {
+    for (size_t i = 0; i < render_output_memo_.size(); i++) {
+        if (!(render_output_memo_[i].first == key)) continue;
+        if (i > 0) std::rotate(render_output_memo_.begin(), render_output_memo_.begin() + i,
+                               render_output_memo_.begin() + i + 1);
+        out = render_output_memo_.front().second;
+        return true;
+    }
+    return false;
+}
+
+void WhiteboardCanvas::StoreRenderOutput(const RenderOutputKey& key, const cv::Mat& frame) {
+    render_output_memo_.erase(
+        std::remove_if(render_output_memo_.begin(), render_output_memo_.end(),
+                       [&](const std::pair<RenderOutputKey, cv::Mat>& e) {
+                           return e.first.version != key.version; }),
+        render_output_memo_.end());
+    const size_t frame_bytes = frame.total() * frame.elemSize();
+    if (frame_bytes > kRenderOutputMemoBytes / 2) return;
+    size_t total_bytes = frame_bytes;
+    for (const auto& e : render_output_memo_) total_bytes += e.second.total() * e.second.elemSize();
+    while (!render_output_memo_.empty() &&
+           ((int)render_output_memo_.size() >= kRenderOutputMemoSlots ||
+            total_bytes > kRenderOutputMemoBytes)) {
+        const cv::Mat& oldest = render_output_memo_.back().second;
+        total_bytes -= oldest.total() * oldest.elemSize();
+        render_output_memo_.pop_back();
+    }
+    render_output_memo_.insert(render_output_memo_.begin(), {key, frame});
+}
+
+const OverviewPyramid& WhiteboardCanvas::EnsureOverviewPyramid(WhiteboardGroup& group,
+                                                               CanvasRenderMode mode) {
+    OverviewPyramid& pyr = GetOverviewPyramidForMode(group, mode);
+    const uint64_t version = GetCanvasVersion();
+    if (pyr.valid && pyr.version == version && pyr.dirty.area() <= 0) return pyr;
+    UpdateOverviewPyramid(GetRenderCacheForMode(group, mode), pyr);
+    pyr.version = version;
+    return pyr;
+}
+
 // ============================================================================
 //  SECTION 4: Public API
 // ============================================================================
@@ -1971,17 +2347,70 @@ void WhiteboardCanvas::ProcessFrame(const cv::Mat& frame, const cv::Mat& person_
     }
     if (person_mask.empty() || person_mask.size() != frame.size() ||
         person_mask.type() != CV_8UC1) return;
+    if (execution_mode_ == CanvasExecutionMode::kInline) {
+        ProcessFrameSync(frame, person_mask);
+        return;
+    }
 
     CanvasWorkItem item;
     frame.copyTo(item.frame);
     person_mask.copyTo(item.person_mask);
+    QueueWorkItem(std::move(item));
+}
 
+void WhiteboardCanvas::ProcessSharedFrame(const cv::Mat& frame, const cv::Mat& person_mask,
+                                          std::shared_ptr<const void> owner) {
+    if (frame.empty()) return;
+    if (remote_process_ && helper_client_) {
+        SyncRuntimeSettings();
+        helper_client_->ProcessFrame(frame, person_mask);
+        return;
+    }
+    if (person_mask.empty() || person_mask.size() != frame.size() ||
+        person_mask.type() != CV_8UC1) return;
+    if (execution_mode_ == CanvasExecutionMode::kInline) {
+        ProcessFrameSync(frame, person_mask);
+        return;
+    }
+
+    CanvasWorkItem item;
+    item.frame = frame;
+    item.person_mask = person_mask;
+    item.owner = std::move(owner);
+    QueueWorkItem(std::move(item));
+}
+
+void WhiteboardCanvas::QueueWorkItem(CanvasWorkItem&& item) {
+    // Latest wins: a frame the worker has not started is dropped here, and
+    // with it whatever it borrowed.
     std::unique_lock<std::mutex> lock(queue_mutex_);
     pending_item_ = std::move(item);
     lock.unlock();
     queue_cv_.notify_one();
 }
 
+bool WhiteboardCanvas::ProcessFrameSync(const cv::Mat& frame, const cv::Mat& person_mask,
+                                        CanvasFrameStats* stats) {
+    if (execution_mode_ != CanvasExecutionMode::kInline) return false;
+    if (frame.empty() || frame.type() != CV_8UC3) return false;
+    if (person_mask.empty() || person_mask.size() != frame.size() ||
+        person_mask.type() != CV_8UC1) return false;
+
+    CanvasFrameStats local_stats;
+    CanvasFrameStats& out = stats ? *stats : local_stats;
+    out = CanvasFrameStats();
+    const auto start = SteadyClock::now();
+    ProcessFrameInternal(frame, person_mask, out);
+    out.total_ms = ElapsedMs(start, SteadyClock::now());
+    perf_ring_.Push(out);
+    if (frame_processed_callback_) frame_processed_callback_();
+    return true;
+}
+
+void WhiteboardCanvas::SetFrameProcessedCallback(std::function<void()> callback) {
+    frame_processed_callback_ = std::move(callback);
+}
+
 bool WhiteboardCanvas::GetViewport(float panX, float panY, float zoom,
                                     cv::Size viewSize, cv::Mat& out_frame) {
     if (remote_process_ && helper_client_)
@@ -1993,6 +2422,14 @@ bool WhiteboardCanvas::GetViewport(float panX, float panY, float zoom,
     if (idx < 0 || idx >= (int)groups_.size()) return false;
     auto& group = *groups_[idx];
     const CanvasRenderMode mode = GetRenderMode();
+    RenderOutputKey key;
+    key.version = GetCanvasVersion();
+    key.mode = mode;
+    key.group_idx = idx;
+    key.kind = RenderOutputKind::kViewport;
+    key.size = viewSize;
+    key.pan_x = panX; key.pan_y = panY; key.zoom = zoom;
+    if (LookupRenderOutput(key, out_frame)) return true;
     if (!EnsureRenderCacheReady(group, mode)) return false;
     const cv::Mat& cache = GetRenderCacheForMode(group, mode);
     zoom = std::max(1.0f, zoom);
@@ -2007,7 +2444,10 @@ bool WhiteboardCanvas::GetViewport(float panX, float panY, float zoom,
     cv::Rect roi((int)cx, (int)cy, (int)rw, (int)rh);
     if (roi.x + roi.width  > cw) roi.width  = cw - roi.x;
     if (roi.y + roi.height > ch) roi.height = ch - roi.y;
-    cv::resize(cache(roi), out_frame, viewSize, 0, 0, cv::INTER_LINEAR);
+    cv::Mat rendered;
+    cv::resize(cache(roi), rendered, viewSize, 0, 0, cv::INTER_LINEAR);
+    StoreRenderOutput(key, rendered);
+    out_frame = rendered;
     return true;
 }
 
@@ -2019,21 +2459,26 @@ bool WhiteboardCanvas::GetOverview(cv::Size viewSize, cv::Mat& out_frame) {
     if (idx < 0 || idx >= (int)groups_.size()) return false;
     auto& group = *groups_[idx];
     const CanvasRenderMode mode = GetRenderMode();
-    if (!EnsureRenderCacheReady(group, mode)) return false;
-    return RenderOverviewToFrame(GetRenderCacheForMode(group, mode), viewSize, out_frame);
+    return RenderOverviewMemoized(group, idx, mode, viewSize, out_frame);
 }
 
-bool WhiteboardCanvas::GetOverviewBlocking(cv::Size viewSize, cv::Mat& out_frame) {
+bool WhiteboardCanvas::GetOverviewBlocking(cv::Size viewSize, cv::Mat& out_frame,
+                                           int* rendered_group_idx) {
+    if (rendered_group_idx) *rendered_group_idx = -1;
     if (remote_process_ && helper_client_)
         return helper_client_->GetOverview(viewSize, out_frame);
     if (viewSize.width <= 0 || viewSize.height <= 0) return false;
     std::lock_guard<std::mutex> lock(state_mutex_);
     int idx = canvas_view_mode_.load() ? view_group_idx_ : active_group_idx_;
     if (idx < 0 || idx >= (int)groups_.size()) return false;
+    if (rendered_group_idx) *rendered_group_idx = idx;
     auto& group = *groups_[idx];
     const CanvasRenderMode mode = GetRenderMode();
-    if (!EnsureRenderCacheReady(group, mode)) return false;
-    return RenderOverviewToFrame(GetRenderCacheForMode(group, mode), viewSize, out_frame);
+    return RenderOverviewMemoized(group, idx, mode, viewSize, out_frame);
+}
+
+void WhiteboardCanvas::ResetPersonMask() {
+    if (remote_process_ && helper_client_) helper_client_->ResetPersonMask();
 }
 
 void WhiteboardCanvas::Reset() {
@@ -2048,9 +2493,11 @@ void WhiteboardCanvas::Reset() {
     }
     std::lock_guard<std::mutex> lock(state_mutex_);
     groups_.clear();
+    render_output_memo_.clear();
     active_group_idx_ = -1;
     view_group_idx_   = -1;
     prev_gray_ = cv::Mat();
+    binarize_roi_reset_.store(true);
     has_content_ = false;
     BumpCanvasVersion();
     frame_w_ = frame_h_ = 0;
@@ -2157,12 +2604,17 @@ void WhiteboardCanvas::WorkerLoop() {
             pending_item_.reset();
         }
         try {
-            ProcessFrameInternal(item.frame, item.person_mask);
+            CanvasFrameStats stats;
+            const auto start = SteadyClock::now();
+            ProcessFrameInternal(item.frame, item.person_mask, stats);
+            stats.total_ms = ElapsedMs(start, SteadyClock::now());
+            perf_ring_.Push(stats);
         } catch (const cv::Exception& e) {
-            OutputDebugStringA((std::string("[WhiteboardCanvas] CV: ") + e.what() + "\n").c_str());
+            LogCanvasError(std::string("[WhiteboardCanvas] CV: ") + e.what());
         } catch (...) {
-            OutputDebugStringA("[WhiteboardCanvas] Unknown exception\n");
+            LogCanvasError("[WhiteboardCanvas] Unknown exception");
         }
+        if (frame_processed_callback_) frame_processed_callback_();
     }
 }
 
@@ -2214,8 +2666,18 @@ bool WhiteboardCanvas::ApplyMotionGate(const cv::Mat& gray, float& motion_fracti
 // ============================================================================
 
 void WhiteboardCanvas::ProcessFrameInternal(const cv::Mat& uncut_frame,
-                                             const cv::Mat& person_mask) {
+                                             const cv::Mat& person_mask,
+                                             CanvasFrameStats& stats) {
     const int current_frame = processed_frame_id_++;
+    stats.frame_id = current_frame;
+
+    // Each call charges the time since the previous mark to `stage`.
+    auto stage_start = SteadyClock::now();
+    auto mark_stage = [&](CanvasStage stage) {
+        const auto now = SteadyClock::now();
+        stats.stage_ms[static_cast<int>(stage)] += ElapsedMs(stage_start, now);
+        stage_start = now;
+    };
 
     const cv::Rect roi = ComputeProcessingRoi(uncut_frame.size());
     if (roi.width <= 0 || roi.height <= 0) return;
@@ -2232,72 +2694,144 @@ void WhiteboardCanvas::ProcessFrameInternal(const cv::Mat& uncut_frame,
     cv::Mat reject_mask;
     if (kEnableFrameStrokeRejectFilter)
         reject_mask = BuildFrameStrokeRejectMask(frame.size(), lecturer_rect);
+    mark_stage(CanvasStage::kNoUpdateMask);
 
     // [1] Motion gate
     float mf = 0.0f; bool mth = false;
-    if (ApplyMotionGate(gray, mf, mth)) return;
+    const bool motion_skip = ApplyMotionGate(gray, mf, mth);
+    mark_stage(CanvasStage::kMotionGate);
+    if (motion_skip) return;
+    stats.accepted = true;
 
     // [2] Binarize
     int stroke_px = 0;
-    cv::Mat binary = BuildBinaryMask(gray, no_update_mask, stroke_px);
+    if (binarize_roi_reset_.exchange(false)) binarize_roi_state_.Clear();
+    cv::Mat binary = BuildBinaryMask(gray, no_update_mask, lecturer_rect,
+                                     &binarize_roi_state_, stroke_px);
+    mark_stage(CanvasStage::kBinarize);
 
     // [3] Extract blobs
     std::vector<FrameBlob> blobs = ExtractFrameBlobs(binary, frame);
-    EnhanceFrameBlobs(blobs, frame, g_canvas_enhance_threshold.load());
+    mark_stage(CanvasStage::kExtract);
 
     if (kEnableFrameStrokeRejectFilter && !reject_mask.empty())
         FilterBlobsForCanvas(blobs, reject_mask, kFrameStrokeRejectMinWidth);
+    stats.blob_count = (int)blobs.size();
+
+    // Colour enhancement runs only for blobs that become or refresh nodes, and
+    // outside state_mutex_: phase [4] matches and plans under the lock, the
+    // colour pass runs unlocked, and phase [5] re-takes the lock to apply the
+    // plan. Stroke mode skips it; those nodes keep raw pixels and needs_enhance
+    // until raw mode first renders them.
+    const float enhance_threshold = GetRenderMode() == CanvasRenderMode::kRaw
+        ? g_canvas_enhance_threshold.load() : -1.0f;
+    std::vector<char> enhanced(blobs.size(), 0);
+    auto enhance_blobs = [&](const std::vector<char>* wanted) {
+        std::vector<char> todo(blobs.size(), 0);
+        bool any = false;
+        for (size_t i = 0; i < blobs.size(); i++) {
+            if ((wanted && !(*wanted)[i]) || enhanced[i]) continue;
+            todo[i] = enhanced[i] = 1;
+            any = true;
+        }
+        if (any) EnhanceFrameBlobs(blobs, &todo, frame, enhance_threshold);
+    };
 
-    std::lock_guard<std::mutex> state_lock(state_mutex_);
+    enum class UpdatePath { kNone, kCreate, kSeed, kUpdate };
+    UpdatePath path = UpdatePath::kNone;
+    const WhiteboardGroup* planned_group = nullptr;
+    cv::Point2f frame_offset(0, 0);
+    GraphUpdatePlan plan;
+    mark_stage(CanvasStage::kEnhance);
 
-    auto recompute_has_content = [&]() {
-        for (const auto& gp : groups_) if (gp && !gp->nodes.empty()) { has_content_ = true; return; }
-        has_content_ = false;
-    };
+    // [4] Match blobs to graph (total-shape comparison, no camera state)
+    {
+        std::lock_guard<std::mutex> state_lock(state_mutex_);
+        if (frame_w_ == 0) { frame_w_ = frame.cols; frame_h_ = frame.rows; }
+
+        const bool has_active = active_group_idx_ >= 0 &&
+                                active_group_idx_ < (int)groups_.size();
+        int active_nodes = 0;
+        if (has_active) {
+            planned_group = groups_[active_group_idx_].get();
+            for (const auto& [_, node_ptr] : planned_group->nodes) {
+                if (!IsGhostNode(*node_ptr)) active_nodes++;
+            }
+        }
+        const bool graph_ready = has_active && active_nodes >= kStableGraphNodeThreshold;
 
-    if (frame_w_ == 0) { frame_w_ = frame.cols; frame_h_ = frame.rows; }
+        if (graph_ready && !blobs.empty()) {
+            auto& group = *groups_[active_group_idx_];
+            frame_offset = MatchBlobsToGraph(group, blobs, &stats);
+            for (const auto& blob : blobs)
+                if (blob.matched_node_id >= 0) stats.matched_count++;
+        }
 
-    const bool has_active = active_group_idx_ >= 0 &&
-                            active_group_idx_ < (int)groups_.size();
-    int active_nodes = 0;
-    if (has_active) {
-        for (const auto& [_, node_ptr] : groups_[active_group_idx_]->nodes) {
-            if (!IsGhostNode(*node_ptr)) active_nodes++;
+        if (!has_active) {
+            if (!mth && stroke_px >= kMinStrokePixelsForNewSC && !blobs.empty())
+                path = UpdatePath::kCreate;
+        } else if (!graph_ready) {
+            if (!mth && !blobs.empty()) path = UpdatePath::kSeed;
+        } else {
+            path = UpdatePath::kUpdate;
+            plan = PlanGraphUpdate(*groups_[active_group_idx_], blobs);
         }
     }
-    const bool graph_ready = has_active && active_nodes >= kStableGraphNodeThreshold;
+    mark_stage(CanvasStage::kMatch);
 
-    // [4] Match blobs to graph (total-shape comparison, no camera state)
-    cv::Point2f frame_offset(0, 0);
-    if (graph_ready && !blobs.empty()) {
-        auto& group = *groups_[active_group_idx_];
-        frame_offset = MatchBlobsToGraph(group, blobs);
+    if (path == UpdatePath::kUpdate) {
+        const std::vector<char> wanted = plan.ColorMask();
+        enhance_blobs(&wanted);
+    } else if (path != UpdatePath::kNone) {
+        enhance_blobs(nullptr);
     }
+    mark_stage(CanvasStage::kEnhance);
 
     // [5] Update graph or bootstrap
-    if (!has_active) {
-        if (!mth && stroke_px >= kMinStrokePixelsForNewSC && !blobs.empty()) {
-            CreateSubCanvas(frame, binary, blobs, current_frame);
-            recompute_has_content();
-        }
-    } else if (!graph_ready) {
-        auto& group = *groups_[active_group_idx_];
-        if (!mth && !blobs.empty()) {
-            SeedGroupFromFrameBlobs(group, blobs, current_frame);
-            recompute_has_content();
-        }
-    } else {
+    std::lock_guard<std::mutex> state_lock(state_mutex_);
+
+    // A reset, sub-canvas switch or removal while the lock was released
+    // invalidates the matches; drop this frame rather than apply them.
+    const bool has_active = active_group_idx_ >= 0 &&
+                            active_group_idx_ < (int)groups_.size();
+    if ((has_active ? groups_[active_group_idx_].get() : nullptr) != planned_group) {
+        mark_stage(CanvasStage::kUpdate);
+        return;
+    }
+
+    auto recompute_has_content = [&]() {
+        for (const auto& gp : groups_) if (gp && !gp->nodes.empty()) { has_content_ = true; return; }
+        has_content_ = false;
+    };
+
+    if (path == UpdatePath::kCreate) {
+        CreateSubCanvas(frame, binary, blobs, current_frame);
+        recompute_has_content();
+    } else if (path == UpdatePath::kSeed) {
+        SeedGroupFromFrameBlobs(*groups_[active_group_idx_], blobs, current_frame);
+        recompute_has_content();
+    } else if (path == UpdatePath::kUpdate) {
         auto& group = *groups_[active_group_idx_];
         const cv::Rect lecturer_canvas =
             TranslateFrameRectToCanvas(lecturer_rect, frame_offset);
-        if (UpdateGraph(group, blobs, current_frame, frame_offset, lecturer_canvas))
+        // Re-plan against the current graph: a node deleted or locked from the
+        // UI meanwhile drops out. Anything the plan newly needs is enhanced here.
+        plan = PlanGraphUpdate(group, blobs);
+        const std::vector<char> wanted = plan.ColorMask();
+        enhance_blobs(&wanted);
+        if (UpdateGraph(group, blobs, plan, current_frame, frame_offset, lecturer_canvas))
             recompute_has_content();
     }
 
     if (groups_.empty() && !mth && stroke_px >= kMinStrokePixelsForNewSC && !blobs.empty()) {
+        enhance_blobs(nullptr);
         CreateSubCanvas(frame, binary, blobs, current_frame);
         recompute_has_content();
     }
+
+    if (active_group_idx_ >= 0 && active_group_idx_ < (int)groups_.size())
+        stats.node_count = (int)groups_[active_group_idx_]->nodes.size();
+    mark_stage(CanvasStage::kUpdate);
 }
 
 // ============================================================================
@@ -2313,10 +2847,13 @@ std::vector<FrameBlob> WhiteboardCanvas::ExtractFrameBlobs(const cv::Mat& binary
     int nlabels = cv::connectedComponentsWithStats(binary, labels, stats, centroids);
     if (nlabels <= 1) return result;
 
-    struct SC { int label; cv::Rect bbox; cv::Point2f centroid; double area;
-                std::vector<cv::Point> contour; };
+    // Every filter that only needs the CC stats runs before any per-component work.
+    struct SC { int label; cv::Rect bbox; cv::Mat mask;
+                int64_t m00 = 0, m10 = 0, m01 = 0; };
     std::vector<SC> components;
     components.reserve(nlabels - 1);
+    std::vector<int> slot_of_label(nlabels, -1);
+    size_t arena_pixels = 0;
 
     for (int i = 1; i < nlabels; i++) {
         int area = stats.at<int>(i, cv::CC_STAT_AREA);
@@ -2326,52 +2863,80 @@ std::vector<FrameBlob> WhiteboardCanvas::ExtractFrameBlobs(const cv::Mat& binary
         int bw = std::min(stats.at<int>(i, cv::CC_STAT_WIDTH),  binary.cols - bx);
         int bh = std::min(stats.at<int>(i, cv::CC_STAT_HEIGHT), binary.rows - by);
         if (bw <= 0 || bh <= 0) continue;
-        cv::Rect bbox(bx, by, bw, bh);
-        cv::Mat cc_mask = (labels(bbox) == i);
-        cv::Point2f lc = ComputeGravityCenter(cc_mask);
-        cv::Point2f gc(lc.x + bx, lc.y + by);
-        std::vector<std::vector<cv::Point>> contours;
-        cv::findContours(cc_mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
-        if (contours.empty()) continue;
-        int best_ci = 0; double best_ca = 0;
-        for (int ci = 0; ci < (int)contours.size(); ci++) {
-            double ca = cv::contourArea(contours[ci]);
-            if (ca > best_ca) { best_ca = ca; best_ci = ci; }
-        }
-        components.push_back({i, bbox, gc, best_ca, contours[best_ci]});
-    }
-    if (components.empty()) return result;
-
-    for (const auto& component : components) {
-        cv::Rect g_bbox = component.bbox;
 
         // Skip very elongated blobs (whiteboard edge lines)
-        float le = (float)std::max(g_bbox.width, g_bbox.height);
-        float se = (float)std::min(g_bbox.width, g_bbox.height);
+        float le = (float)std::max(bw, bh);
+        float se = (float)std::min(bw, bh);
         if (se > 0 && le / se > kMaxAllowedRectangle) continue;
 
         // Skip blobs that span most of the frame (whiteboard edges / borders)
         if (frame_h_ > 0) {
             float max_dim = frame_h_ * kMaxBlobDimensionFraction;
-            if (g_bbox.width > max_dim || g_bbox.height > max_dim) continue;
+            if (bw > max_dim || bh > max_dim) continue;
         }
 
-        cv::Mat g_mask = cv::Mat::zeros(g_bbox.size(), CV_8UC1);
-        cv::Mat cc_mask = (labels(component.bbox) == component.label);
-        cc_mask.copyTo(g_mask, cc_mask);
+        slot_of_label[i] = (int)components.size();
+        SC sc;
+        sc.label = i;
+        sc.bbox = cv::Rect(bx, by, bw, bh);
+        components.push_back(sc);
+        arena_pixels += (size_t)bw * (size_t)bh;
+    }
+    if (components.empty()) return result;
+
+    // One allocation per frame for all tight masks (and one for colour patches).
+    MatArena mask_arena(arena_pixels, CV_8UC1, true);
+    for (auto& c : components) c.mask = mask_arena.Take(c.bbox.size());
+
+    // Single label scan: paint each tight mask and accumulate its binary moments.
+    for (int y = 0; y < labels.rows; y++) {
+        const int* lr = labels.ptr<int>(y);
+        for (int x = 0; x < labels.cols; x++) {
+            const int l = lr[x];
+            if (l <= 0) continue;
+            const int slot = slot_of_label[l];
+            if (slot < 0) continue;
+            SC& c = components[slot];
+            const int lx = x - c.bbox.x, ly = y - c.bbox.y;
+            c.mask.ptr<uint8_t>(ly)[lx] = 255;
+            c.m00++;
+            c.m10 += lx;
+            c.m01 += ly;
+        }
+    }
 
+    MatArena color_arena(frame_bgr.empty() ? 0 : arena_pixels, CV_8UC3, false);
+    result.reserve(components.size());
+    std::vector<std::vector<cv::Point>> contours;
+    for (auto& component : components) {
+        if (component.m00 <= 0) continue;
+        contours.clear();
+        cv::findContours(component.mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+        if (contours.empty()) continue;
+        int best_ci = 0; double best_ca = 0;
+        for (int ci = 0; ci < (int)contours.size(); ci++) {
+            double ca = cv::contourArea(contours[ci]);
+            if (ca > best_ca) { best_ca = ca; best_ci = ci; }
+        }
+
+        const cv::Rect g_bbox = component.bbox;
         FrameBlob blob;
         blob.bbox = g_bbox;
-        blob.binary_mask = g_mask;
-        cv::Point2f lc = ComputeGravityCenter(g_mask);
-        blob.centroid = lc + cv::Point2f((float)g_bbox.x, (float)g_bbox.y);
-        blob.contour = component.contour;
-        blob.area = component.area;
+        blob.binary_mask = component.mask;
+        blob.centroid = cv::Point2f(
+            (float)((double)component.m10 / (double)component.m00) + (float)g_bbox.x,
+            (float)((double)component.m01 / (double)component.m00) + (float)g_bbox.y);
+        blob.contour = std::move(contours[best_ci]);
+        blob.area = best_ca;
         cv::Moments m = cv::moments(blob.contour);
         cv::HuMoments(m, blob.hu);
         PopulateHuCache(blob.binary_mask, blob.hu,
-                        blob.hu_smooth, blob.hu_smooth_valid, blob.hu_log);
-        if (!frame_bgr.empty()) blob.color_pixels = frame_bgr(g_bbox).clone();
+                        blob.hu_smooth, blob.hu_smooth_valid, blob.hu_log,
+                        blob.shape_context_contour);
+        if (!frame_bgr.empty()) {
+            blob.color_pixels = color_arena.Take(g_bbox.size());
+            frame_bgr(g_bbox).copyTo(blob.color_pixels);
+        }
         result.push_back(std::move(blob));
     }
     return result;
@@ -2385,73 +2950,128 @@ std::vector<FrameBlob> WhiteboardCanvas::ExtractFrameBlobs(const cv::Mat& binary
 // Step 1: Global shape pass — rough offset via total-shape matching + median vote
 // ---------------------------------------------------------------------------
 cv::Point2f WhiteboardCanvas::GlobalShapePass(WhiteboardGroup& group,
-                                               const std::vector<FrameBlob>& blobs) {
+                                               const std::vector<FrameBlob>& blobs,
+                                               CanvasFrameStats* stats) {
     struct ShapeCandidate { cv::Point2f offset; float difference; };
-    std::vector<ShapeCandidate> offset_vectors;
 
-    for (const auto& blob : blobs) {
-        // Search ALL canvas nodes — blob is in frame space, canvas nodes can be
-        // anywhere, so spatial index queries around frame centroid won't work.
-        int best_node = -1;
-        float best_difference = kGlobalShapeMaxDifference;
-        cv::Point2f best_offset;
-
-        for (const auto& pair : group.nodes) {
-            const auto& node = *pair.second;
+    // Best TotalShapeCompare match among `ids`, as the node-minus-blob offset.
+    auto best_match = [&](const FrameBlob& blob, const std::vector<int>& ids,
+                          ShapeCandidate& best) {
+        bool found = false;
+        for (int nid : ids) {
+            auto nit = group.nodes.find(nid);
+            if (nit == group.nodes.end()) continue;
+            const auto& node = *nit->second;
             if (IsGhostNode(node)) continue;
 
-            // Area ratio filter
-            if (node.area > 0.0) {
-                float ratio = (float)(blob.area / node.area);
-                if (ratio < kAreaRatioMin || ratio > (1.0f / kAreaRatioMin)) continue;
-            }
-
-            // Fast Hu pre-filter (both sides must have smooth Hu for a fair comparison).
-            if (blob.hu_smooth_valid && node.hu_smooth_valid &&
-                ComputeHuDistanceLog(blob.hu_log, node.hu_log) > kHuPreFilterThreshold) continue;
-
             const cv::Rect aligned_node_bbox = AlignRectToCentroid(
                 node.bbox_canvas, node.centroid_canvas, blob.centroid);
             const TotalShapeCompareResult shape_compare = TotalShapeCompare(
                 blob.bbox,  &blob.binary_mask,  blob.hu,
-                blob.hu_smooth_valid  ? blob.hu_smooth  : nullptr, &blob.contour,
+                blob.hu_smooth_valid  ? blob.hu_smooth  : nullptr, &blob.shape_context_contour,
                 aligned_node_bbox,
                 &node.binary_mask, node.hu,
-                node.hu_smooth_valid  ? node.hu_smooth  : nullptr, &node.contour);
+                node.hu_smooth_valid  ? node.hu_smooth  : nullptr, &node.shape_context_contour);
             if (!shape_compare.valid) continue;
 
-            if (shape_compare.difference < best_difference) {
-                best_difference = shape_compare.difference;
-                best_node = node.id;
-                best_offset = node.centroid_canvas - blob.centroid;
+            if (shape_compare.difference < best.difference) {
+                best.difference = shape_compare.difference;
+                best.offset = node.centroid_canvas - blob.centroid;
+                found = true;
             }
         }
+        return found;
+    };
 
-        if (best_node >= 0) {
-            offset_vectors.push_back({best_offset, best_difference});
+    // Median vote for rough offset
+    auto median_offset = [](const std::vector<ShapeCandidate>& offset_vectors) {
+        if (offset_vectors.empty()) return cv::Point2f();
+        std::vector<float> dxs, dys;
+        dxs.reserve(offset_vectors.size());
+        dys.reserve(offset_vectors.size());
+        for (const auto& ov : offset_vectors) {
+            dxs.push_back(ov.offset.x);
+            dys.push_back(ov.offset.y);
         }
-    }
-
-    if (offset_vectors.empty()) return {};
+        std::sort(dxs.begin(), dxs.end());
+        std::sort(dys.begin(), dys.end());
+        return cv::Point2f(dxs[dxs.size() / 2], dys[dys.size() / 2]);
+    };
 
-    // Median vote for rough offset
-    std::vector<float> dxs, dys;
-    dxs.reserve(offset_vectors.size());
-    dys.reserve(offset_vectors.size());
-    for (const auto& ov : offset_vectors) {
-        dxs.push_back(ov.offset.x);
-        dys.push_back(ov.offset.y);
+    // Blobs are in frame space and canvas nodes can be anywhere, so the
+    // spatial index is useless here; the group's shape index ranks the nodes
+    // by descriptor and TotalShapeCompare runs on the nearest few. Only when
+    // none of those is a valid match does the blob try the rest.
+    std::vector<ShapeCandidate> offset_vectors;
+    std::vector<char> blob_matched(blobs.size(), 0);
+    std::vector<int> candidates, rest;
+    for (size_t b = 0; b < blobs.size(); b++) {
+        const FrameBlob& blob = blobs[b];
+        ShapeCandidate best{{}, kGlobalShapeMaxDifference};
+        candidates.clear();
+        group.shape_index.QueryTopK(blob.area, blob.hu_log, blob.hu_smooth_valid,
+                                    kAreaRatioMin, kHuPreFilterThreshold, kGlobalShapeTopK,
+                                    candidates);
+        bool found = best_match(blob, candidates, best);
+        if (!found) {
+            rest.clear();
+            group.shape_index.QueryTopK(blob.area, blob.hu_log, blob.hu_smooth_valid,
+                                        kAreaRatioMin, kHuPreFilterThreshold,
+                                        std::numeric_limits<int>::max(), rest);
+            std::sort(candidates.begin(), candidates.end());
+            rest.erase(std::remove_if(rest.begin(), rest.end(), [&](int id) {
+                return std::binary_search(candidates.begin(), candidates.end(), id);
+            }), rest.end());
+            found = best_match(blob, rest, best);
+        }
+        if (!found) continue;
+        blob_matched[b] = 1;
+        offset_vectors.push_back(best);
     }
-    std::sort(dxs.begin(), dxs.end());
-    std::sort(dys.begin(), dys.end());
-    return cv::Point2f(dxs[dxs.size() / 2], dys[dys.size() / 2]);
+    const cv::Point2f rough_offset = median_offset(offset_vectors);
+
+    // Verification: the exhaustive scan, every node through the same area and
+    // Hu gates straight from group.nodes, so a stale index shows up too.
+    if (stats && verify_global_shape_pass_.load()) {
+        std::vector<ShapeCandidate> exhaustive_vectors;
+        std::vector<int> gated;
+        size_t chosen = 0;
+        for (size_t b = 0; b < blobs.size(); b++) {
+            const FrameBlob& blob = blobs[b];
+            gated.clear();
+            for (const auto& [nid, node_ptr] : group.nodes) {
+                const DrawingNode& node = *node_ptr;
+                if (node.area > 0.0) {
+                    const float ratio = (float)(blob.area / node.area);
+                    if (ratio < kAreaRatioMin || ratio > (1.0f / kAreaRatioMin)) continue;
+                }
+                if (blob.hu_smooth_valid && node.hu_smooth_valid &&
+                    ComputeHuDistanceLog(blob.hu_log, node.hu_log) > kHuPreFilterThreshold)
+                    continue;
+                gated.push_back(nid);
+            }
+            ShapeCandidate best{{}, kGlobalShapeMaxDifference};
+            const bool found = best_match(blob, gated, best);
+            if (found) exhaustive_vectors.push_back(best);
+            const bool topk = blob_matched[b] != 0;
+            if (found != topk ||
+                (topk && offset_vectors[chosen].offset != best.offset))
+                stats->shape_check_mismatches++;
+            if (topk) chosen++;
+        }
+        stats->shape_check_blobs = (int)exhaustive_vectors.size();
+        stats->shape_check_offset_error =
+            (float)cv::norm(rough_offset - median_offset(exhaustive_vectors));
+    }
+    return rough_offset;
 }
 
 // ---------------------------------------------------------------------------
 // MatchBlobsToGraph — orchestrates all 3 steps
 // ---------------------------------------------------------------------------
 cv::Point2f WhiteboardCanvas::MatchBlobsToGraph(WhiteboardGroup& group,
-                                                  std::vector<FrameBlob>& blobs) {
+                                                  std::vector<FrameBlob>& blobs,
+                                                  CanvasFrameStats* stats) {
     if (blobs.empty() || group.nodes.empty()) return {};
 
     for (auto& b : blobs) { b.matched_node_id = -1; b.matched_offset = {}; }
@@ -2507,7 +3127,7 @@ cv::Point2f WhiteboardCanvas::MatchBlobsToGraph(WhiteboardGroup& group,
     // =====================================================================
     // Step 1: Global shape pass — rough offset
     // =====================================================================
-    cv::Point2f rough_offset = GlobalShapePass(group, blobs);
+    cv::Point2f rough_offset = GlobalShapePass(group, blobs, stats);
 
     // =====================================================================
     // Step 2: Shape matching — shift by rough offset, match with total-shape score,
@@ -2604,11 +3224,42 @@ void WhiteboardCanvas::RemoveNodeFromGraph(WhiteboardGroup& group, int node_id)
     if (it == group.nodes.end()) return;
     RemoveHardEdges(group, node_id);
     group.spatial_index.Remove(node_id, it->second->centroid_canvas);
+    group.shape_index.Remove(node_id, it->second->area);
     group.nodes.erase(it);
 }
 
+// Classifies each blob the way UpdateGraph consumes it: matched blobs refresh
+// their node unless it is user-locked (4a); once kMinMatchesForNewNode distinct
+// nodes matched, unmatched blobs inside the cropped frame are inserted or
+// merged (4c). UpdateGraph follows the plan rather than re-deriving it.
+GraphUpdatePlan WhiteboardCanvas::PlanGraphUpdate(
+        const WhiteboardGroup& group, const std::vector<FrameBlob>& blobs) const {
+    GraphUpdatePlan plan;
+    plan.roles.assign(blobs.size(), BlobUpdateRole::kNone);
+    std::unordered_set<int> seen_node_ids;
+    for (size_t i = 0; i < blobs.size(); i++) {
+        if (blobs[i].matched_node_id < 0) continue;
+        auto nit = group.nodes.find(blobs[i].matched_node_id);
+        if (nit == group.nodes.end()) continue;
+        seen_node_ids.insert(nit->first);
+        if (!nit->second->user_locked) plan.roles[i] = BlobUpdateRole::kRefresh;
+    }
+    plan.insert_pass = (int)seen_node_ids.size() >= kMinMatchesForNewNode;
+    if (!plan.insert_pass) return plan;
+
+    const cv::Rect cropped_frame = BuildCroppedFrameRect(frame_w_, frame_h_);
+    for (size_t i = 0; i < blobs.size(); i++) {
+        const FrameBlob& blob = blobs[i];
+        if (blob.matched_node_id >= 0) continue;
+        if (cropped_frame.contains(cv::Point((int)blob.centroid.x, (int)blob.centroid.y)))
+            plan.roles[i] = BlobUpdateRole::kInsert;
+    }
+    return plan;
+}
+
 bool WhiteboardCanvas::UpdateGraph(WhiteboardGroup& group,
                                     std::vector<FrameBlob>& blobs,
+                                    const GraphUpdatePlan& plan,
                                     int current_frame, cv::Point2f frame_offset,
                                     const cv::Rect& lecturer_canvas_rect) {
     bool graph_changed = false;
@@ -2622,7 +3273,8 @@ bool WhiteboardCanvas::UpdateGraph(WhiteboardGroup& group,
     std::unordered_set<int> seen_node_ids;
     std::vector<int> seen_node_list;
     std::unordered_map<int, cv::Point2f> node_deltas;  // id -> (dx, dy)
-    for (auto& blob : blobs) {
+    for (size_t bi = 0; bi < blobs.size(); bi++) {
+        FrameBlob& blob = blobs[bi];
         if (blob.matched_node_id < 0) continue;
         auto nit = group.nodes.find(blob.matched_node_id);
         if (nit == group.nodes.end()) continue;
@@ -2647,7 +3299,7 @@ bool WhiteboardCanvas::UpdateGraph(WhiteboardGroup& group,
 
         const cv::Point2f old_centroid = node.centroid_canvas;
 
-        if (!node.user_locked) {
+        if (plan.roles[bi] == BlobUpdateRole::kRefresh) {
             cv::Point2f blended_centroid(
                 node.centroid_canvas.x * (1.0f - kLocationAverageAlpha) +
                     canvas_centroid.x * kLocationAverageAlpha,
@@ -2770,15 +3422,12 @@ bool WhiteboardCanvas::UpdateGraph(WhiteboardGroup& group,
     }
 
     // --- 4c. Dedupe unmatched frame blobs, then add surviving ones as new nodes ---
-    const int matched_count = (int)seen_node_ids.size();
     std::vector<int> new_node_ids;
-    if (matched_count >= kMinMatchesForNewNode) {
-        for (auto& blob : blobs) {
-            if (blob.matched_node_id >= 0) continue;
-
-            // Skip blobs whose centroid falls outside the cropped frame region
-            if (!cropped_frame.contains(cv::Point((int)blob.centroid.x, (int)blob.centroid.y)))
-                continue;
+    if (plan.insert_pass) {
+        for (size_t bi = 0; bi < blobs.size(); bi++) {
+            // Unmatched blobs outside the cropped frame region were left out of the plan
+            if (plan.roles[bi] != BlobUpdateRole::kInsert) continue;
+            FrameBlob& blob = blobs[bi];
 
             const cv::Point2f canvas_centroid = blob.centroid + blob.matched_offset;
             const cv::Rect canvas_bbox(
@@ -2881,67 +3530,133 @@ void WhiteboardCanvas::UpdateGroupBounds(WhiteboardGroup& group) {
     }
 }
 
-void WhiteboardCanvas::RebuildStrokeRenderCache(WhiteboardGroup& group) {
-    if (group.nodes.empty()) { group.stroke_render_cache = cv::Mat(); return; }
-    int W = std::max(1, group.stroke_max_px_x - group.stroke_min_px_x);
-    int H = std::max(1, group.stroke_max_px_y - group.stroke_min_px_y);
-    cv::Mat canvas(H, W, CV_8UC3, cv::Scalar(255, 255, 255));
+void WhiteboardCanvas::RefreshRenderCache(WhiteboardGroup& group, CanvasRenderMode mode) {
+    const bool raw = mode == CanvasRenderMode::kRaw;
+    cv::Mat& cache = raw ? group.raw_render_cache : group.stroke_render_cache;
+    RenderTileCache& tiles = raw ? group.raw_tiles : group.stroke_tiles;
+    OverviewPyramid& pyramid = GetOverviewPyramidForMode(group, mode);
+    if (group.nodes.empty()) { cache = cv::Mat(); tiles.Clear(); pyramid.Invalidate(); return; }
+
+    int mnx, mny, mxx, mxy;
+    GetRenderBoundsForMode(group, mode, mnx, mny, mxx, mxy);
+    const int W = std::max(1, mxx - mnx);
+    const int H = std::max(1, mxy - mny);
+    const cv::Rect canvas_rect(mnx, mny, W, H);
+    // Stroke mode draws white strokes on black; raw mode pastes colour on white.
+    const cv::Scalar background = raw ? cv::Scalar(255, 255, 255) : cv::Scalar(0, 0, 0);
+
+    std::unordered_set<uint64_t> dirty;
+    auto mark_dirty = [&](const cv::Rect& r) {
+        RenderTileCache::ForEachTile(r & canvas_rect, [&](int tx, int ty) {
+            dirty.insert(RenderTileCache::TileKey(tx, ty));
+        });
+    };
 
-    std::vector<const DrawingNode*> sorted;
-    sorted.reserve(group.nodes.size());
+    // Bounds only ever grow, so keep the pixels of the previous cache and
+    // only composite the newly exposed border.
+    if (!tiles.valid || cache.empty()) {
+        tiles.Clear();
+        pyramid.Invalidate();
+        cache = cv::Mat(H, W, CV_8UC3, background);
+    } else if (cache.cols != W || cache.rows != H ||
+               tiles.origin != cv::Point(mnx, mny)) {
+        const cv::Rect old_rect(tiles.origin, cache.size());
+        cv::Mat grown(H, W, CV_8UC3, background);
+        const cv::Rect keep = old_rect & canvas_rect;
+        if (keep.area() > 0)
+            cache(keep - tiles.origin).copyTo(grown(keep - canvas_rect.tl()));
+        RenderTileCache::ForEachTile(canvas_rect, [&](int tx, int ty) {
+            const cv::Rect tile = RenderTileCache::TileRect(tx, ty) & canvas_rect;
+            if ((tile & keep) != tile) dirty.insert(RenderTileCache::TileKey(tx, ty));
+        });
+        cache = grown;
+        pyramid.Invalidate();
+    }
+    tiles.origin = cv::Point(mnx, mny);
+
+    auto eligible = [raw](const DrawingNode& node) {
+        return IsNodeVisibleInMainCanvas(node) && (!raw || !node.color_pixels.empty());
+    };
+
+    // Diff the graph against what was last composited.
+    std::vector<std::pair<int, cv::Rect>> removed;
+    for (const auto& entry : tiles.nodes) {
+        auto it = group.nodes.find(entry.first);
+        if (it == group.nodes.end() || !eligible(*it->second))
+            removed.emplace_back(entry.first, entry.second.bbox);
+    }
+    for (const auto& r : removed) {
+        mark_dirty(r.second);
+        tiles.RemoveNode(r.first, r.second);
+    }
     for (const auto& p : group.nodes) {
-        if (!IsNodeVisibleInMainCanvas(*p.second)) continue;
-        sorted.push_back(p.second.get());
-    }
-    std::sort(sorted.begin(), sorted.end(),
-              [](const DrawingNode* a, const DrawingNode* b) {
-                  return a->created_frame < b->created_frame; });
-
-    for (const auto* node : sorted) {
-        cv::Rect dst(node->bbox_canvas.x - group.stroke_min_px_x,
-                     node->bbox_canvas.y - group.stroke_min_px_y,
-                     node->bbox_canvas.width, node->bbox_canvas.height);
-        int cx0 = std::max(0, dst.x), cy0 = std::max(0, dst.y);
-        int cx1 = std::min(W, dst.x + dst.width), cy1 = std::min(H, dst.y + dst.height);
-        if (cx0 >= cx1 || cy0 >= cy1) continue;
-        int sx0 = cx0 - dst.x, sy0 = cy0 - dst.y, sw = cx1 - cx0, sh = cy1 - cy0;
-        if (sx0+sw > node->binary_mask.cols || sy0+sh > node->binary_mask.rows) continue;
-        canvas(cv::Rect(cx0, cy0, sw, sh)).setTo(cv::Scalar(0,0,0),
-            node->binary_mask(cv::Rect(sx0, sy0, sw, sh)));
-    }
-    cv::bitwise_not(canvas, canvas);
-    group.stroke_render_cache = canvas;
-}
-
-void WhiteboardCanvas::RebuildRawRenderCache(WhiteboardGroup& group) {
-    if (group.nodes.empty()) { group.raw_render_cache = cv::Mat(); return; }
-    int W = std::max(1, group.raw_max_px_x - group.raw_min_px_x);
-    int H = std::max(1, group.raw_max_px_y - group.raw_min_px_y);
-    cv::Mat canvas(H, W, CV_8UC3, cv::Scalar(255, 255, 255));
+        const DrawingNode& node = *p.second;
+        if (!eligible(node)) continue;
+        RenderedNodeState state;
+        state.bbox             = node.bbox_canvas;
+        state.created_frame    = node.created_frame;
+        state.content_revision = node.content_revision;
+        auto it = tiles.nodes.find(node.id);
+        if (it != tiles.nodes.end()) {
+            const RenderedNodeState& prev = it->second;
+            if (prev.bbox == state.bbox && prev.created_frame == state.created_frame &&
+                prev.content_revision == state.content_revision)
+                continue;
+            const cv::Rect prev_bbox = prev.bbox;
+            mark_dirty(prev_bbox);
+            tiles.RemoveNode(node.id, prev_bbox);
+        }
+        mark_dirty(state.bbox);
+        tiles.AddNode(node.id, state);
+    }
+    if (!tiles.valid) {
+        RenderTileCache::ForEachTile(canvas_rect, [&](int tx, int ty) {
+            dirty.insert(RenderTileCache::TileKey(tx, ty));
+        });
+        tiles.valid = true;
+    }
 
+    // Re-composite each dirty tile from the nodes that intersect it, oldest
+    // first so overlaps resolve exactly as a full redraw would.
     std::vector<const DrawingNode*> sorted;
-    sorted.reserve(group.nodes.size());
-    for (const auto& p : group.nodes)
-        if (IsNodeVisibleInMainCanvas(*p.second) && !p.second->color_pixels.empty())
-            sorted.push_back(p.second.get());
-    std::sort(sorted.begin(), sorted.end(),
-              [](const DrawingNode* a, const DrawingNode* b) {
-                  return a->created_frame < b->created_frame; });
-
-    for (const auto* node : sorted) {
-        cv::Rect dst(node->bbox_canvas.x - group.raw_min_px_x,
-                     node->bbox_canvas.y - group.raw_min_px_y,
-                     node->bbox_canvas.width, node->bbox_canvas.height);
-        int cx0 = std::max(0, dst.x), cy0 = std::max(0, dst.y);
-        int cx1 = std::min(W, dst.x + dst.width), cy1 = std::min(H, dst.y + dst.height);
-        if (cx0 >= cx1 || cy0 >= cy1) continue;
-        int sx0 = cx0 - dst.x, sy0 = cy0 - dst.y, sw = cx1 - cx0, sh = cy1 - cy0;
-        if (sx0+sw > node->binary_mask.cols  || sy0+sh > node->binary_mask.rows)  continue;
-        if (sx0+sw > node->color_pixels.cols || sy0+sh > node->color_pixels.rows) continue;
-        node->color_pixels(cv::Rect(sx0,sy0,sw,sh)).copyTo(
-            canvas(cv::Rect(cx0,cy0,sw,sh)), node->binary_mask(cv::Rect(sx0,sy0,sw,sh)));
-    }
-    group.raw_render_cache = canvas;
+    for (uint64_t key : dirty) {
+        const int tx = (int)(int32_t)(uint32_t)(key >> 32);
+        const int ty = (int)(int32_t)(uint32_t)(key & 0xffffffffu);
+        const cv::Rect tile = RenderTileCache::TileRect(tx, ty) & canvas_rect;
+        if (tile.area() <= 0) continue;
+        cv::Mat dst = cache(tile - canvas_rect.tl());
+        dst.setTo(background);
+        pyramid.MarkDirty(tile - canvas_rect.tl());
+
+        auto list = tiles.tile_nodes.find(key);
+        if (list == tiles.tile_nodes.end()) continue;
+        sorted.clear();
+        for (int id : list->second) {
+            auto it = group.nodes.find(id);
+            if (it != group.nodes.end()) sorted.push_back(it->second.get());
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const DrawingNode* a, const DrawingNode* b) {
+                      if (a->created_frame != b->created_frame)
+                          return a->created_frame < b->created_frame;
+                      return a->id < b->id; });
+
+        for (const auto* node : sorted) {
+            const cv::Rect clip = node->bbox_canvas & tile;
+            if (clip.area() <= 0) continue;
+            const cv::Rect src = clip - node->bbox_canvas.tl();
+            if (src.x + src.width > node->binary_mask.cols ||
+                src.y + src.height > node->binary_mask.rows) continue;
+            cv::Mat out = dst(clip - tile.tl());
+            if (raw) {
+                if (src.x + src.width > node->color_pixels.cols ||
+                    src.y + src.height > node->color_pixels.rows) continue;
+                node->color_pixels(src).copyTo(out, node->binary_mask(src));
+            } else {
+                out.setTo(cv::Scalar(255, 255, 255), node->binary_mask(src));
+            }
+        }
+    }
 }
 
 // ============================================================================
@@ -2953,6 +3668,7 @@ void WhiteboardCanvas::SeedGroupFromFrameBlobs(WhiteboardGroup& group,
                                                 int current_frame) {
     group.nodes.clear();
     group.spatial_index.Clear();
+    group.shape_index.Clear();
     group.hard_edges.clear();
     group.next_node_id = 0;
     std::vector<int> new_node_ids;
@@ -2994,7 +3710,8 @@ void WhiteboardCanvas::CreateSubCanvas(const cv::Mat& frame_bgr, const cv::Mat&
 
     if (blobs.empty()) {
         blobs = ExtractFrameBlobs(binary, frame_bgr);
-        EnhanceFrameBlobs(blobs, frame_bgr, g_canvas_enhance_threshold.load());
+        if (GetRenderMode() == CanvasRenderMode::kRaw)
+            EnhanceFrameBlobs(blobs, nullptr, frame_bgr, g_canvas_enhance_threshold.load());
     }
     SeedGroupFromFrameBlobs(*group, blobs, current_frame);
 
@@ -3009,6 +3726,10 @@ void WhiteboardCanvas::CreateSubCanvas(const cv::Mat& frame_bgr, const cv::Mat&
 //  SECTION 13: Graph node access methods
 // ============================================================================
 
+void WhiteboardCanvas::RefreshGraphExport() {
+    if (remote_process_ && helper_client_) helper_client_->RefreshGraphExport();
+}
+
 int WhiteboardCanvas::GetGraphNodeCount() const {
     if (remote_process_ && helper_client_) return helper_client_->GetGraphNodeCount();
     std::lock_guard<std::mutex> lock(state_mutex_);
@@ -3071,10 +3792,10 @@ bool WhiteboardCanvas::CompareGraphNodes(int id_a, int id_b, float* result) cons
     const DrawingNode& b = *itB->second;
 
     const DuplicateCandidateView first_candidate{
-        a.bbox_canvas, &a.binary_mask, &a.contour, a.centroid_canvas,
+        a.bbox_canvas, &a.binary_mask, &a.shape_context_contour, a.centroid_canvas,
         a.hu, a.hu_smooth_valid ? a.hu_smooth : nullptr, a.created_frame};
     const DuplicateCandidateView second_candidate{
-        b.bbox_canvas, &b.binary_mask, &b.contour, b.centroid_canvas,
+        b.bbox_canvas, &b.binary_mask, &b.shape_context_contour, b.centroid_canvas,
         b.hu, b.hu_smooth_valid ? b.hu_smooth : nullptr, b.created_frame};
     const DuplicateCheckResult duplicate_check = EvaluateDuplicateCandidate(
         first_candidate,
@@ -3090,10 +3811,10 @@ bool WhiteboardCanvas::CompareGraphNodes(int id_a, int id_b, float* result) cons
         b.bbox_canvas, b.centroid_canvas, a.centroid_canvas);
     const TotalShapeCompareResult shape_compare = TotalShapeCompare(
         a.bbox_canvas, &a.binary_mask, a.hu,
-        a.hu_smooth_valid ? a.hu_smooth : nullptr, &a.contour,
+        a.hu_smooth_valid ? a.hu_smooth : nullptr, &a.shape_context_contour,
         aligned_b,
         &b.binary_mask, b.hu,
-        b.hu_smooth_valid ? b.hu_smooth : nullptr, &b.contour);
+        b.hu_smooth_valid ? b.hu_smooth : nullptr, &b.shape_context_contour);
     result[0] = shape_compare.difference;
 
     cv::Point2f diff = a.centroid_canvas - b.centroid_canvas;
@@ -3240,6 +3961,27 @@ int WhiteboardCanvas::GetGraphNodeMasks(uint8_t* buffer, int max_bytes) const {
     return offset;
 }
 
+int WhiteboardCanvas::GetPerfSnapshot(float* buffer, int max_floats) const {
+    if (!buffer || max_floats < kCanvasPerfSnapshotFloats) return 0;
+    if (remote_process_ && helper_client_) return helper_client_->GetPerfSnapshot(buffer, max_floats);
+    std::vector<CanvasFrameStats> frames;
+    frames.reserve(CanvasPerfRing::kCapacity);
+    perf_ring_.CopyRecent(frames);
+    return BuildCanvasPerfSnapshot(frames, buffer, max_floats);
+}
+
+int WhiteboardCanvas::GetFrameRingStats(float* buffer, int max_floats) const {
+    // The in-process worker has no ring; frames go straight to its queue.
+    if (!remote_process_ || !helper_client_) return 0;
+    return helper_client_->GetFrameRingStats(buffer, max_floats);
+}
+
+int WhiteboardCanvas::GetPersonDetectorStats(float* buffer, int max_floats) const {
+    // In-process, the canvas shares the host's detector; the caller reads that.
+    if (!remote_process_ || !helper_client_) return 0;
+    return helper_client_->GetPersonDetectorStats(buffer, max_floats);
+}
+
 bool WhiteboardCanvas::MoveGraphNode(int node_id, float new_cx, float new_cy) {
     std::lock_guard<std::mutex> lock(state_mutex_);
     int gi = canvas_view_mode_.load() ? view_group_idx_ : active_group_idx_;
@@ -3344,6 +4086,7 @@ int WhiteboardCanvas::LockAllGraphNodes() {
     if (gi < 0 || gi >= (int)groups_.size()) return 0;
     int count = 0;
     for (auto& p : groups_[gi]->nodes) { p.second->user_locked = true; count++; }
+    if (count > 0) graph_log_stale_ = true;  // locking keeps the canvas version
     return count;
 }
 
@@ -3368,231 +4111,49 @@ int WhiteboardCanvas::GetGraphNodeContours(float* buffer, int max_floats) const
     return CopyGraphContoursToBuffer(*groups_[gi], buffer, max_floats);
 }
 
-// ============================================================================
-//  SECTION 14: FFI exports
-// ============================================================================
-
-void SetPanoramaEnabled(bool enabled) {
-    if (enabled) {
-        if (!g_whiteboard_canvas) {
-            g_whiteboard_canvas = new WhiteboardCanvas();
-        } else {
-            g_whiteboard_canvas->SetCanvasViewMode(false);
-            g_whiteboard_canvas->Reset();
+int WhiteboardCanvas::GetGraphChanges(int since_version, float* buffer, int max_floats) const {
+    if (!buffer || max_floats <= 0) return 0;
+    if (remote_process_ && helper_client_)
+        return helper_client_->GetGraphChanges(since_version, buffer, max_floats);
+    std::lock_guard<std::mutex> log_lock(graph_log_mutex_);
+    {
+        std::vector<float> nodes;
+        std::vector<int> edges;
+        std::vector<float> contours;
+        int node_count = 0, edge_count = 0, contour_floats = 0;
+        int bounds[4] = {0, 0, 0, 0};
+        bool bounds_valid = false;
+        bool changed = false;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            int gi = canvas_view_mode_.load() ? view_group_idx_ : active_group_idx_;
+            if (gi < 0) gi = active_group_idx_;
+            if (gi >= (int)groups_.size()) gi = -1;
+            const uint64_t version = GetCanvasVersion();
+            changed = graph_log_stale_.exchange(false) || version != graph_log_canvas_version_ ||
+                      gi != graph_log_group_idx_;
+            graph_log_canvas_version_ = version;
+            graph_log_group_idx_ = gi;
+            if (changed && gi >= 0) {
+                const WhiteboardGroup& group = *groups_[gi];
+                int edge_slots = 0;
+                for (const auto& entry : group.hard_edges) edge_slots += (int)entry.second.size();
+                for (const auto& p : group.nodes) contour_floats += 2 + (int)p.second->contour.size() * 2;
+                nodes.resize(group.nodes.size() * kGraphChangeNodeFloats);
+                edges.resize(edge_slots * 2);
+                contours.resize(contour_floats);
+                node_count = CopyGraphNodesToBuffer(group, nodes.data(), (int)group.nodes.size());
+                edge_count = CopyGraphHardEdgesToBuffer(group, edges.data(), edge_slots);
+                contour_floats = CopyGraphContoursToBuffer(group, contours.data(), contour_floats);
+                bounds_valid = CopyGraphBoundsToBuffer(group, bounds);
+            }
         }
-        g_whiteboard_canvas->SyncRuntimeSettings();
-        g_whiteboard_enabled.store(true);
-    } else {
-        g_whiteboard_enabled.store(false);
-        if (g_whiteboard_canvas) {
-            g_whiteboard_canvas->SetCanvasViewMode(false);
-            g_whiteboard_canvas->Reset();
+        // Diffing runs outside state_mutex_ so the worker is not held up.
+        if (changed) {
+            graph_log_.Update(nodes.data(), node_count, edges.data(), edge_count,
+                              contours.data(), contour_floats,
+                              bounds_valid ? bounds : nullptr);
         }
     }
-    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
-}
-
-void ResetPanorama() {
-    if (g_whiteboard_canvas) g_whiteboard_canvas->Reset();
-    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
-}
-
-void SetPanoramaViewport(float panX, float panY, float zoom) {
-    g_canvas_pan_x.store(panX); g_canvas_pan_y.store(panY); g_canvas_zoom.store(zoom);
-    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
-}
-
-void GetPanoramaCanvasSize(int* width, int* height) {
-    if (g_whiteboard_canvas) {
-        cv::Size s = g_whiteboard_canvas->GetCanvasSize();
-        if (width)  *width  = s.width;
-        if (height) *height = s.height;
-    } else {
-        if (width)  *width  = 1920;
-        if (height) *height = 1080;
-    }
-}
-
-bool IsPanoramaEnabled() { return g_whiteboard_enabled.load(); }
-
-void SetCanvasViewMode(bool mode) {
-    if (g_whiteboard_canvas) g_whiteboard_canvas->SetCanvasViewMode(mode);
-    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
-}
-
-bool IsCanvasViewMode() {
-    return g_whiteboard_canvas && g_whiteboard_canvas->IsCanvasViewMode();
-}
-
-void SetCanvasRenderMode(int mode) {
-    if (g_whiteboard_canvas) {
-        g_whiteboard_canvas->SetRenderMode(
-            mode == static_cast<int>(CanvasRenderMode::kRaw)
-                ? CanvasRenderMode::kRaw : CanvasRenderMode::kStroke);
-    }
-    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
-}
-
-int64_t GetCanvasTextureId() {
-    return g_native_camera ? g_native_camera->GetTextureId() : -1;
-}
-
-bool GetCanvasOverviewRgba(uint8_t* buffer, int width, int height) {
-    if (!g_whiteboard_canvas || !buffer || width <= 0 || height <= 0) return false;
-    cv::Mat overview;
-    if (!g_whiteboard_canvas->GetOverviewBlocking(cv::Size(width, height), overview)) return false;
-    return CopyBgrFrameToRgbaBuffer(overview, buffer, width, height);
-}
-
-bool GetCanvasOverviewJpeg(uint8_t* buffer, int max_bytes, int* out_size, int quality, int max_dim) {
-    if (!g_whiteboard_canvas || !buffer || !out_size || max_bytes <= 0) return false;
-    
-    cv::Size native_size = g_whiteboard_canvas->GetCanvasSize();
-    if (native_size.width <= 0 || native_size.height <= 0) return false;
-    
-    float scale = 1.0f;
-    if (max_dim > 0 && (native_size.width > max_dim || native_size.height > max_dim)) {
-        scale = static_cast<float>(max_dim) / std::max(native_size.width, native_size.height);
-    }
-    cv::Size view_size(
-        std::max(1, static_cast<int>(native_size.width * scale)),
-        std::max(1, static_cast<int>(native_size.height * scale))
-    );
-
-    cv::Mat overview;
-    if (!g_whiteboard_canvas->GetOverviewBlocking(view_size, overview)) return false;
-    
-    std::vector<uchar> buf;
-    std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, quality};
-    bool success = cv::imencode(".jpg", overview, buf, params);
-    
-    if (!success || buf.size() > static_cast<size_t>(max_bytes)) {
-        *out_size = 0;
-        return false;
-    }
-    
-    std::memcpy(buffer, buf.data(), buf.size());
-    *out_size = static_cast<int>(buf.size());
-    return true;
-}
-
-bool GetCanvasViewportRgba(uint8_t* buffer, int width, int height,
-                            float panX, float panY, float zoom) {
-    if (!g_whiteboard_canvas || !buffer || width <= 0 || height <= 0) return false;
-    cv::Mat viewport;
-    if (!g_whiteboard_canvas->GetViewport(panX, panY, zoom,
-                                           cv::Size(width, height), viewport)) return false;
-    return CopyBgrFrameToRgbaBuffer(viewport, buffer, width, height);
-}
-
-void SetWhiteboardDebug(bool enabled) {
-    g_whiteboard_debug.store(enabled);
-    if (g_whiteboard_canvas) g_whiteboard_canvas->SyncRuntimeSettings();
-}
-
-void SetDuplicateDebugMode(bool enabled) {
-    g_duplicate_debug_mode.store(enabled);
-    if (g_whiteboard_canvas) g_whiteboard_canvas->SetDuplicateDebugMode(enabled);
-}
-
-bool GetDuplicateDebugMode() {
-    return g_duplicate_debug_mode.load();
-}
-
-void SetCanvasEnhanceThreshold(float threshold) {
-    g_canvas_enhance_threshold.store(threshold);
-    if (g_whiteboard_canvas) g_whiteboard_canvas->SyncRuntimeSettings();
-}
-
-void SetAbsenceScoreSeenThreshold(float threshold) {
-    g_absence_score_seen_threshold.store(threshold);
-    if (g_whiteboard_canvas) g_whiteboard_canvas->RefreshSeenThresholdVisibility();
-}
-
-float GetAbsenceScoreSeenThreshold() {
-    return g_absence_score_seen_threshold.load();
-}
-
-int GetSubCanvasCount() {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetSubCanvasCount() : 0;
-}
-int GetActiveSubCanvasIndex() {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetActiveSubCanvasIndex() : -1;
-}
-void SetActiveSubCanvas(int idx) {
-    if (g_whiteboard_canvas) g_whiteboard_canvas->SetActiveSubCanvas(idx);
-}
-int GetSortedSubCanvasIndex(int pos) {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetSortedSubCanvasIndex(pos) : -1;
-}
-int GetSortedPosition(int idx) {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetSortedPosition(idx) : -1;
-}
-
-int GetGraphNodeCount() {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphNodeCount() : 0;
-}
-int GetGraphNodes(float* buffer, int max_nodes) {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphNodes(buffer, max_nodes) : 0;
-}
-int GetGraphHardEdges(int* buffer, int max_edges) {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphHardEdges(buffer, max_edges) : 0;
-}
-int GetGraphNodeNeighbors(int node_id, int* neighbors, int max_neighbors) {
-    return g_whiteboard_canvas
-        ? g_whiteboard_canvas->GetGraphNodeNeighbors(node_id, neighbors, max_neighbors) : 0;
-}
-bool CompareGraphNodes(int id_a, int id_b, float* result) {
-    return g_whiteboard_canvas && g_whiteboard_canvas->CompareGraphNodes(id_a, id_b, result);
-}
-bool CompareGraphNodesAtOffset(int id_a, int id_b, float dx, float dy, float* result) {
-    return g_whiteboard_canvas &&
-        g_whiteboard_canvas->CompareGraphNodesAtOffset(id_a, id_b, dx, dy, result);
-}
-int GetGraphNodeMasks(uint8_t* buffer, int max_bytes) {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphNodeMasks(buffer, max_bytes) : 0;
-}
-bool MoveGraphNode(int node_id, float new_cx, float new_cy) {
-    return g_whiteboard_canvas && g_whiteboard_canvas->MoveGraphNode(node_id, new_cx, new_cy);
-}
-bool DeleteGraphNode(int node_id) {
-    return g_whiteboard_canvas && g_whiteboard_canvas->DeleteGraphNode(node_id);
-}
-bool ApplyUserEdits(const int* delete_ids, int delete_count,
-                    const float* moves, int move_count) {
-    return g_whiteboard_canvas &&
-        g_whiteboard_canvas->ApplyUserEdits(delete_ids, delete_count, moves, move_count);
-}
-int LockAllGraphNodes() {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->LockAllGraphNodes() : 0;
-}
-bool GetGraphCanvasBounds(int* bounds) {
-    return g_whiteboard_canvas && g_whiteboard_canvas->GetGraphCanvasBounds(bounds);
-}
-int GetGraphNodeContours(float* buffer, int max_floats) {
-    return g_whiteboard_canvas
-        ? g_whiteboard_canvas->GetGraphNodeContours(buffer, max_floats) : 0;
-}
-
-// Debug snapshot stubs
-bool CaptureGraphDebugSnapshot(int /*slot*/) { return false; }
-int  GetGraphSnapshotNodeCount(int /*slot*/) { return 0; }
-int  GetGraphSnapshotNodes(int /*slot*/, float* /*buf*/, int /*max*/) { return 0; }
-bool GetGraphSnapshotCanvasBounds(int /*slot*/, int* /*bounds*/) { return false; }
-int  GetGraphSnapshotNodeContours(int /*slot*/, float* /*buf*/, int /*max*/) { return 0; }
-bool CompareGraphSnapshotNodes(int, int, int, int, float*) { return false; }
-bool CombineGraphDebugSnapshots(int, int, int, int) { return false; }
-bool CopyGraphDebugSnapshot(int, int) { return false; }
-
-uint64_t GetCanvasVersion() {
-    return g_whiteboard_canvas ? g_whiteboard_canvas->GetCanvasVersion() : 0;
-}
-
-bool GetCanvasFullResRgba(uint8_t* buffer, int max_w, int max_h, int* out_w, int* out_h) {
-    if (!g_whiteboard_canvas || !buffer || max_w <= 0 || max_h <= 0) return false;
-    cv::Mat overview;
-    if (!g_whiteboard_canvas->GetOverviewBlocking(cv::Size(max_w, max_h), overview)) return false;
-    if (out_w) *out_w = overview.cols;
-    if (out_h) *out_h = overview.rows;
-    return CopyBgrFrameToRgbaBuffer(overview, buffer, overview.cols, overview.rows);
+    return graph_log_.Read(since_version, buffer, max_floats);
 }
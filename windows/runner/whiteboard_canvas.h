@@ -12,11 +12,19 @@
 //   Camera thread  -> ProcessFrame()  (queues work, non-blocking)
 //   Worker thread  -> ProcessFrameInternal
 //   UI thread      -> GetViewport()   (mutex, never stalls camera)
+//
+// This header and whiteboard_canvas.cpp are platform-neutral (OpenCV only) and
+// build as the whiteboard_canvas_core static library. The Win32 helper process
+// lives in whiteboard_canvas_process.cpp and the Dart FFI surface in
+// whiteboard_canvas_ffi.cpp; both are linked only into the Windows runner.
 // ============================================================================
 
 #include <opencv2/opencv.hpp>
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -26,6 +34,9 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "whiteboard_canvas_perf.h"
+#include "whiteboard_graph_changes.h"
+
 class WhiteboardCanvasHelperClient;
 
 enum class CanvasRenderMode : int {
@@ -33,6 +44,15 @@ enum class CanvasRenderMode : int {
     kRaw = 1,
 };
 
+// How a WhiteboardCanvas schedules ProcessFrameInternal.
+//   kAuto   -- helper process when available, otherwise the worker thread
+//   kInline -- no worker and no helper; the caller drives ProcessFrameSync()
+//              (offline replay, benchmarks)
+enum class CanvasExecutionMode : int {
+    kAuto = 0,
+    kInline = 1,
+};
+
 enum class AlignmentScoreMode : int {
     kIoU = 0,
     kChamfer = 1,
@@ -60,11 +80,19 @@ struct DrawingNode {
     bool   hu_smooth_valid = false;
     // log10-space hu_smooth features for fast O(7) pre-filtering before full shape compare.
     float  hu_log[7] = {};
+    // Smooth-mask contour resampled for the shape-context term of TotalShapeCompare.
+    std::vector<cv::Point> shape_context_contour;
     double area = 0.0;
     float  absence_score = kAbsenceScoreInitial;
     bool   has_crossed_absence_seen_threshold = false;
     int    last_seen_frame = 0;
     int    created_frame   = 0;
+    // Bumped whenever binary_mask / color_pixels are replaced in place, so the
+    // tiled render caches can tell a refreshed node from an unchanged one.
+    int    content_revision = 0;
+    // color_pixels are still raw camera pixels (captured in stroke mode); they
+    // are enhanced the first time raw mode renders this node.
+    bool   needs_enhance   = false;
     bool   user_locked     = false;
     int    match_count     = 0;
     bool   duplicate_debug_marked = false;
@@ -84,16 +112,44 @@ struct FrameBlob {
     cv::Point2f  centroid;
     cv::Mat      binary_mask;    // CV_8UC1
     cv::Mat      color_pixels;   // CV_8UC3
+    bool         color_enhanced = false;  // color_pixels went through WhiteboardEnhance
     std::vector<cv::Point> contour;
     double       hu[7] = {};
     double       hu_smooth[7] = {};   // Hu from BuildShapeCompareMask; cached for TotalShapeCompare
     bool         hu_smooth_valid = false;
     float        hu_log[7] = {};      // log-space hu_smooth for fast pre-filtering
+    std::vector<cv::Point> shape_context_contour;  // resampled smooth-mask contour
     double       area  = 0.0;
     int          matched_node_id = -1;
     cv::Point2f  matched_offset{0, 0};
 };
 
+// ---------------------------------------------------------------------------
+// GraphUpdatePlan -- What UpdateGraph will do with each frame blob
+//
+// Built by PlanGraphUpdate from the graph state and then followed by
+// UpdateGraph, so the colour pass and the graph update cannot disagree on
+// which blobs end up in nodes.
+// ---------------------------------------------------------------------------
+enum class BlobUpdateRole : uint8_t {
+    kNone,     // dropped, or matched to a locked node
+    kRefresh,  // matched; refreshes an unlocked node (4a)
+    kInsert,   // unmatched, inside the cropped frame; inserted or merged (4c)
+};
+
+struct GraphUpdatePlan {
+    std::vector<BlobUpdateRole> roles;  // one per blob
+    bool insert_pass = false;           // enough nodes matched for 4c to run
+
+    // Blobs whose colour pixels are copied into the graph.
+    std::vector<char> ColorMask() const {
+        std::vector<char> mask(roles.size(), 0);
+        for (size_t i = 0; i < roles.size(); i++)
+            mask[i] = roles[i] != BlobUpdateRole::kNone;
+        return mask;
+    }
+};
+
 // ---------------------------------------------------------------------------
 // SpatialIndex -- Grid-based spatial hash for fast proximity queries
 // ---------------------------------------------------------------------------
@@ -154,6 +210,176 @@ private:
     }
 };
 
+// ---------------------------------------------------------------------------
+// ShapeDescriptorIndex -- Area-bucketed lookup over cached hu_log descriptors
+//
+// Buckets nodes by log(area) so an area-ratio query only touches the buckets
+// that can satisfy it, then ranks the survivors by log-space Hu distance. Used
+// by the global shape pass, where blobs are in frame space and a positional
+// query is impossible. Each WhiteboardGroup keeps one next to its spatial
+// index, holding the same (non-ghost) nodes.
+// ---------------------------------------------------------------------------
+class ShapeDescriptorIndex {
+public:
+    explicit ShapeDescriptorIndex(float log_area_bucket = 0.1f)
+        : log_area_bucket_(log_area_bucket) {}
+
+    void Insert(int id, double area, const float hu_log[7], bool hu_valid) {
+        Entry e;
+        e.id = id;
+        e.area = area;
+        e.hu_valid = hu_valid;
+        std::copy(hu_log, hu_log + 7, e.hu_log);
+        if (area > 0.0) buckets_[BucketOf(area)].push_back(e);
+        else unsized_.push_back(e);  // the area gate never rejects these
+    }
+
+    // `area` must be the value the entry was inserted with; unknown ids are ignored.
+    void Remove(int id, double area) {
+        auto erase_id = [id](std::vector<Entry>& v) {
+            v.erase(std::remove_if(v.begin(), v.end(),
+                                   [id](const Entry& e) { return e.id == id; }),
+                    v.end());
+        };
+        if (area <= 0.0) { erase_id(unsized_); return; }
+        auto it = buckets_.find(BucketOf(area));
+        if (it == buckets_.end()) return;
+        erase_id(it->second);
+        if (it->second.empty()) buckets_.erase(it);
+    }
+
+    void Clear() { buckets_.clear(); unsized_.clear(); }
+
+    // Appends candidate ids for a query shape, nearest Hu first.
+    //   - area ratio query/node must lie in [min_area_ratio, 1/min_area_ratio]
+    //     (nodes without area always pass);
+    //   - when both sides have a valid hu_log, entries farther than
+    //     max_hu_distance are dropped and at most k of the rest are kept;
+    //   - entries whose Hu is not comparable are always returned after those.
+    void QueryTopK(double area, const float hu_log[7], bool hu_valid,
+                   float min_area_ratio, float max_hu_distance, int k,
+                   std::vector<int>& out) const;
+
+private:
+    struct Entry {
+        int    id = -1;
+        double area = 0.0;
+        float  hu_log[7] = {};
+        bool   hu_valid = false;
+    };
+
+    float log_area_bucket_;
+    std::unordered_map<int, std::vector<Entry>> buckets_;
+    std::vector<Entry> unsized_;
+
+    int BucketOf(double area) const {
+        return (int)std::floor(std::log(area) / log_area_bucket_);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// RenderTileCache -- Bookkeeping for incremental render-cache compositing
+//
+// The render cache stays one contiguous Mat, but it is addressed as a grid of
+// kRenderTileSize tiles in absolute canvas coordinates. Each tile keeps the ids
+// of the nodes whose bbox intersects it, and `nodes` remembers what was last
+// composited for every node. A refresh diffs the graph against `nodes` and
+// re-composites only the tiles touched by added, removed, moved or refreshed
+// nodes, instead of redrawing the whole canvas.
+// ---------------------------------------------------------------------------
+struct RenderedNodeState {
+    cv::Rect bbox;
+    int      created_frame    = 0;
+    int      content_revision = 0;
+};
+
+struct RenderTileCache {
+    static constexpr int kRenderTileSize = 256;
+
+    bool      valid = false;   // false forces a full recomposite on next refresh
+    cv::Point origin;          // canvas coords of render cache pixel (0,0)
+    std::unordered_map<int, RenderedNodeState>     nodes;
+    std::unordered_map<uint64_t, std::vector<int>> tile_nodes;
+
+    void Clear() {
+        valid = false;
+        nodes.clear();
+        tile_nodes.clear();
+    }
+
+    static uint64_t TileKey(int tx, int ty) {
+        return ((uint64_t)(uint32_t)tx << 32) | (uint32_t)ty;
+    }
+
+    // Calls fn(tx, ty) for every tile overlapped by the canvas-space rect.
+    template <typename Fn>
+    static void ForEachTile(const cv::Rect& r, Fn&& fn) {
+        if (r.width <= 0 || r.height <= 0) return;
+        const int tx0 = FloorDiv(r.x), tx1 = FloorDiv(r.x + r.width - 1);
+        const int ty0 = FloorDiv(r.y), ty1 = FloorDiv(r.y + r.height - 1);
+        for (int ty = ty0; ty <= ty1; ty++)
+            for (int tx = tx0; tx <= tx1; tx++)
+                fn(tx, ty);
+    }
+
+    static cv::Rect TileRect(int tx, int ty) {
+        return cv::Rect(tx * kRenderTileSize, ty * kRenderTileSize,
+                        kRenderTileSize, kRenderTileSize);
+    }
+
+    void AddNode(int id, const RenderedNodeState& state) {
+        nodes[id] = state;
+        ForEachTile(state.bbox, [&](int tx, int ty) {
+            tile_nodes[TileKey(tx, ty)].push_back(id);
+        });
+    }
+
+    void RemoveNode(int id, const cv::Rect& bbox) {
+        nodes.erase(id);
+        ForEachTile(bbox, [&](int tx, int ty) {
+            auto it = tile_nodes.find(TileKey(tx, ty));
+            if (it == tile_nodes.end()) return;
+            auto& ids = it->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty()) tile_nodes.erase(it);
+        });
+    }
+
+private:
+    static int FloorDiv(int v) {
+        return v >= 0 ? v / kRenderTileSize : -((-v + kRenderTileSize - 1) / kRenderTileSize);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// OverviewPyramid -- Half-resolution chain of a render cache for overviews
+//
+// levels[0] is the render cache box-filtered by 2, each further level halves
+// again. Every level is exactly half of the even-cropped level above it, so a
+// dirty rect can be propagated down without drifting from a full rebuild.
+// Overview requests resample from the smallest level that still covers the
+// requested size instead of INTER_AREA-ing the whole canvas each call.
+// ---------------------------------------------------------------------------
+struct OverviewPyramid {
+    static constexpr int kMinLevelSide = 64;
+
+    std::vector<cv::Mat> levels;
+    cv::Rect dirty;              // render-cache pixels changed since last sync
+    bool     valid   = false;
+    uint64_t version = 0;        // canvas version the levels were synced at
+
+    void Invalidate() {
+        valid = false;
+        levels.clear();
+        dirty = cv::Rect();
+    }
+
+    void MarkDirty(const cv::Rect& r) {
+        if (r.area() <= 0) return;
+        dirty = dirty.area() > 0 ? (dirty | r) : r;
+    }
+};
+
 // ---------------------------------------------------------------------------
 // WhiteboardGroup -- One continuous lecture session
 // ---------------------------------------------------------------------------
@@ -161,6 +387,7 @@ struct WhiteboardGroup {
 std::unordered_map<int, std::unique_ptr<DrawingNode>> nodes;
     int next_node_id = 0;
     SpatialIndex spatial_index{200};
+    ShapeDescriptorIndex shape_index;
 
     int stroke_min_px_x = 0, stroke_min_px_y = 0;
     int stroke_max_px_x = 512, stroke_max_px_y = 512;
@@ -172,6 +399,10 @@ std::unordered_map<int, std::unique_ptr<DrawingNode>> nodes;
     bool    stroke_cache_dirty = true;
     cv::Mat raw_render_cache;
     bool    raw_cache_dirty    = true;
+    RenderTileCache stroke_tiles;
+    RenderTileCache raw_tiles;
+    OverviewPyramid stroke_pyramid;
+    OverviewPyramid raw_pyramid;
 
     std::unordered_set<int> user_deleted_ids;
 
@@ -187,6 +418,40 @@ std::unordered_map<int, std::unique_ptr<DrawingNode>> nodes;
 struct CanvasWorkItem {
     cv::Mat frame;
     cv::Mat person_mask;
+    std::shared_ptr<const void> owner;  // keeps borrowed pixels alive (helper ring slots)
+};
+
+// ---------------------------------------------------------------------------
+// BinarizeRoiState -- Half-res threshold cache for ROI-aware binarization
+// ---------------------------------------------------------------------------
+struct BinarizeRoiState {
+    cv::Mat ref_small_gray;    // half-res gray each band was last thresholded from
+    cv::Mat small_threshold;   // adaptive threshold result, CV_8UC1, same size
+
+    void Clear() {
+        ref_small_gray.release();
+        small_threshold.release();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// RenderOutputKey -- Everything a GetOverview / GetViewport result depends on
+// ---------------------------------------------------------------------------
+enum class RenderOutputKind { kOverview = 0, kViewport = 1 };
+
+struct RenderOutputKey {
+    uint64_t         version   = 0;
+    CanvasRenderMode mode      = CanvasRenderMode::kStroke;
+    int              group_idx = -1;
+    RenderOutputKind kind      = RenderOutputKind::kOverview;
+    cv::Size         size;
+    float            pan_x = 0.0f, pan_y = 0.0f, zoom = 0.0f;   // viewport only
+
+    bool operator==(const RenderOutputKey& o) const {
+        return version == o.version && mode == o.mode && group_idx == o.group_idx &&
+               kind == o.kind && size == o.size &&
+               pan_x == o.pan_x && pan_y == o.pan_y && zoom == o.zoom;
+    }
 };
 
 // ---------------------------------------------------------------------------
@@ -194,20 +459,41 @@ struct CanvasWorkItem {
 // ---------------------------------------------------------------------------
 class WhiteboardCanvas {
 public:
-    WhiteboardCanvas();
+    explicit WhiteboardCanvas(CanvasExecutionMode mode = CanvasExecutionMode::kAuto);
     ~WhiteboardCanvas();
 
     // --- Frame scheduling ---
     void ProcessFrame(const cv::Mat& frame, const cv::Mat& person_mask);
+    // Like ProcessFrame, but queues the Mats without copying them. The caller
+    // must not write to their pixels afterwards; `owner` is released once the
+    // canvas is done with them, for memory the Mats do not own themselves.
+    void ProcessSharedFrame(const cv::Mat& frame, const cv::Mat& person_mask,
+                            std::shared_ptr<const void> owner = nullptr);
+    // Runs the pipeline on the calling thread (kInline canvases only).
+    // Returns false when the canvas is not inline or the input is invalid.
+    bool ProcessFrameSync(const cv::Mat& frame, const cv::Mat& person_mask,
+                          CanvasFrameStats* stats = nullptr);
+    // Called on the processing thread after each frame, processed or gated.
+    // Set it before the first frame is queued.
+    void SetFrameProcessedCallback(std::function<void()> callback);
 
     // --- Viewport rendering ---
+    // Results are memoized per canvas version: repeated identical requests get
+    // a Mat sharing the same buffer (very large outputs are not memoized).
+    // Callers must treat out_frame as read-only (clone before drawing into it).
     bool GetViewport(float panX, float panY, float zoom,
                      cv::Size viewSize, cv::Mat& out_frame);
     bool GetOverview(cv::Size viewSize, cv::Mat& out_frame);
-    bool GetOverviewBlocking(cv::Size viewSize, cv::Mat& out_frame);
+    // rendered_group_idx, when given, receives the sub-canvas actually drawn
+    // (view_group_idx_ in canvas view mode); -1 when served by the helper.
+    bool GetOverviewBlocking(cv::Size viewSize, cv::Mat& out_frame,
+                             int* rendered_group_idx = nullptr);
 
     // --- State control ---
     void Reset();
+    // Out of process, drops the helper's person mask (camera start, stop or
+    // switch). In process the owner resets its own tracker.
+    void ResetPersonMask();
     bool HasContent() const;
     bool IsCanvasViewMode() const;
     void SetCanvasViewMode(bool mode);
@@ -232,6 +518,9 @@ public:
     int  GetSortedPosition(int idx) const;
 
     // --- Graph node access (for edit screen) ---
+    // Out of process, brings the helper's graph export up to date; the getters
+    // below read that export. Call once per refresh. No-op in process.
+    void RefreshGraphExport();
     int  GetGraphNodeCount() const;
     int  GetGraphNodes(float* buffer, int max_nodes) const;
     int  GetGraphHardEdges(int* buffer, int max_edges) const;
@@ -247,6 +536,23 @@ public:
     int  LockAllGraphNodes();
     bool GetGraphCanvasBounds(int* bounds) const;
     int  GetGraphNodeContours(float* buffer, int max_floats) const;
+    // Graph changes after `since_version` (layout in whiteboard_graph_changes.h).
+    // The full getters above remain the snapshot to start or resync from.
+    int  GetGraphChanges(int since_version, float* buffer, int max_floats) const;
+
+    // --- Worker stage timings (see whiteboard_canvas_perf.h for the layout) ---
+    int  GetPerfSnapshot(float* buffer, int max_floats) const;
+
+    // --- Helper-process frame ring counters (whiteboard_canvas_process.h) ---
+    int  GetFrameRingStats(float* buffer, int max_floats) const;
+
+    // --- Helper-process person detector stats (yolo_person_detector.h layout) ---
+    int  GetPersonDetectorStats(float* buffer, int max_floats) const;
+
+    // --- Verification ---
+    // Makes the global shape pass also run the exhaustive scan and report how
+    // far its top-k result is from it in CanvasFrameStats (benchmarks only).
+    void SetVerifyGlobalShapePass(bool enabled) { verify_global_shape_pass_.store(enabled); }
 
 private:
     // -----------------------------------------------------------------------
@@ -290,6 +596,17 @@ private:
     // Morphological dilation kernel size (NxN). Larger = wider strokes and more connected blobs.
     // Raise to join nearby strokes into one blob. Lower to keep strokes thin and separate.
     static const int       kDilationKernelSize           = 11;
+    // ROI-aware binarization: the adaptive threshold is recomputed only in vertical bands that
+    // changed since they were last thresholded and are not under the lecturer's padded box;
+    // other bands reuse their previous result. Disable to threshold the full frame every time.
+    static constexpr bool  kEnableRoiBinarization        = true;
+    // Band width (px) at half resolution. Narrower = finer reuse, more halo overhead per band.
+    static const int       kRoiBinarizeBandWidth         = 64;
+    // A band is re-thresholded once at least this many half-res pixels differ from the gray it
+    // was last thresholded from by more than kMotionPixelThreshold. Higher = ignore more noise.
+    static const int       kRoiBinarizeBandChangePixels  = 16;
+    // Padding around the lecturer's bounding box, as a fraction of the frame width.
+    static constexpr float kRoiBinarizeLecturerPadFraction = 0.02f;
 
     // --- Blob extraction ---
     // Connected components smaller than this (px²) are discarded as noise.
@@ -331,6 +648,12 @@ private:
     static constexpr float kFinalShapeMatchSearchRadius  = 30.0f;
     // Minimum number of inlier matches required before new strokes are added to the graph.
     static const int       kMinMatchesForNewNode         = 5;
+    // Global shape pass: TotalShapeCompare runs only on the k candidates nearest in
+    // log-space Hu (after the area and Hu gates); a blob with no valid match among
+    // them falls back to the remaining candidates. Raise if the rough offset drifts
+    // on canvases with many look-alike strokes (canvas_replay_bench
+    // --verify-shape-pass compares it with the exhaustive scan).
+    static const int       kGlobalShapeTopK              = 12;
     // Fast Hu pre-filter: skip TotalShapeCompare if log-space Hu L2 distance exceeds this.
     // Only applied when BOTH sides have a valid hu_smooth (same smoothing basis).
     // Use a generous value — Hu distances for the same mark from different viewpoints
@@ -418,8 +741,10 @@ private:
     std::condition_variable queue_cv_;
     std::optional<CanvasWorkItem> pending_item_;
     std::atomic<bool>       stop_worker_{false};
+    std::function<void()>   frame_processed_callback_;
     std::unique_ptr<WhiteboardCanvasHelperClient> helper_client_;
     bool                    remote_process_ = false;
+    CanvasExecutionMode     execution_mode_ = CanvasExecutionMode::kAuto;
     bool                    duplicate_debug_mode_ = false;
 
     mutable std::mutex state_mutex_;
@@ -430,6 +755,13 @@ private:
     cv::Mat prev_gray_;
     bool motion_gate_locked_ = false;
 
+    // Per-band adaptive threshold reused across accepted frames (ROI binarization).
+    // Owned by the processing thread; Reset() only raises the flag.
+    BinarizeRoiState  binarize_roi_state_;
+    std::atomic<bool> binarize_roi_reset_{false};
+
+    std::atomic<bool> verify_global_shape_pass_{false};
+
     // -----------------------------------------------------------------------
     // Atomic flags
     // -----------------------------------------------------------------------
@@ -444,29 +776,68 @@ private:
 
     int processed_frame_id_ = 0;
 
+    // Stage timings of the most recent frames (written by the worker only).
+    CanvasPerfRing perf_ring_;
+
+    // Recent viewport/overview outputs, most recent first. Guarded by
+    // state_mutex_; entries from older canvas versions are dropped on insert.
+    // Bounded by bytes as well as slots: the oldest entries are evicted until
+    // the total fits, and outputs over half the budget (full-resolution
+    // exports) are returned without being memoized.
+    static constexpr int    kRenderOutputMemoSlots = 6;
+    static constexpr size_t kRenderOutputMemoBytes = size_t(32) << 20;
+    std::vector<std::pair<RenderOutputKey, cv::Mat>> render_output_memo_;
+    bool LookupRenderOutput(const RenderOutputKey& key, cv::Mat& out);
+    bool RenderOverviewMemoized(WhiteboardGroup& group, int group_idx, CanvasRenderMode mode,
+                                cv::Size view_size, cv::Mat& out_frame);
+    void StoreRenderOutput(const RenderOutputKey& key, const cv::Mat& frame);
+
+    // Change log behind GetGraphChanges, fed from a full export of the shown
+    // group whenever the canvas version or the group changed since the last
+    // export. graph_log_mutex_ is taken before state_mutex_.
+    mutable std::mutex        graph_log_mutex_;
+    mutable GraphChangeLog    graph_log_;
+    mutable uint64_t          graph_log_canvas_version_ = 0;
+    mutable int               graph_log_group_idx_ = -1;
+    mutable std::atomic<bool> graph_log_stale_{true};   // edits that keep the version
+
+    void QueueWorkItem(CanvasWorkItem&& item);
+
     // -----------------------------------------------------------------------
     // Internal methods (run on worker_thread_)
     // -----------------------------------------------------------------------
     void WorkerLoop();
     bool EnsureRenderCacheReady(WhiteboardGroup& group, CanvasRenderMode render_mode);
-    void ProcessFrameInternal(const cv::Mat& uncut_frame, const cv::Mat& person_mask);
+    const OverviewPyramid& EnsureOverviewPyramid(WhiteboardGroup& group,
+                                                 CanvasRenderMode render_mode);
+    void ProcessFrameInternal(const cv::Mat& uncut_frame, const cv::Mat& person_mask,
+                              CanvasFrameStats& stats);
     bool ApplyMotionGate(const cv::Mat& gray, float& motion_fraction, bool& motion_too_high);
 
     static cv::Mat BuildBinaryMask(const cv::Mat& gray, const cv::Mat& no_update_mask,
+                                    const cv::Rect& lecturer_rect,
+                                    BinarizeRoiState* roi_state,
                                     int& stroke_pixel_count);
+    static const cv::Mat& ThresholdChangedBands(const cv::Mat& small_gray,
+                                                const cv::Rect& lecturer_rect,
+                                                BinarizeRoiState& state);
     std::vector<FrameBlob> ExtractFrameBlobs(const cv::Mat& binary,
                                               const cv::Mat& frame_bgr) const;
     cv::Point2f GlobalShapePass(WhiteboardGroup& group,
-                                const std::vector<FrameBlob>& blobs);
+                                const std::vector<FrameBlob>& blobs,
+                                CanvasFrameStats* stats = nullptr);
     cv::Point2f MatchBlobsToGraph(WhiteboardGroup& group,
-                                   std::vector<FrameBlob>& blobs);
+                                   std::vector<FrameBlob>& blobs,
+                                   CanvasFrameStats* stats = nullptr);
+    GraphUpdatePlan PlanGraphUpdate(const WhiteboardGroup& group,
+                                    const std::vector<FrameBlob>& blobs) const;
     bool UpdateGraph(WhiteboardGroup& group, std::vector<FrameBlob>& blobs,
+                     const GraphUpdatePlan& plan,
                      int current_frame, cv::Point2f frame_offset,
                      const cv::Rect& lecturer_canvas_rect = cv::Rect());
 
     static void RemoveNodeFromGraph(WhiteboardGroup& group, int node_id);
-    void RebuildStrokeRenderCache(WhiteboardGroup& group);
-    void RebuildRawRenderCache(WhiteboardGroup& group);
+    void RefreshRenderCache(WhiteboardGroup& group, CanvasRenderMode mode);
     void CreateSubCanvas(const cv::Mat& frame_bgr, const cv::Mat& binary,
                          std::vector<FrameBlob>& blobs, int current_frame);
     void SeedGroupFromFrameBlobs(WhiteboardGroup& group,
@@ -486,75 +857,10 @@ extern std::atomic<float> g_canvas_zoom;
 extern std::atomic<bool>  g_whiteboard_debug;
 extern std::atomic<bool>  g_duplicate_debug_mode;
 extern std::atomic<float> g_yolo_fps;
+// Person detector config (PersonDetectorConfig enum values; threads 0 = all
+// cores). Forwarded to the helper process, which runs the canvas detector.
+extern std::atomic<int>   g_person_detector_backend;
+extern std::atomic<int>   g_person_detector_precision;
+extern std::atomic<int>   g_person_detector_threads;
 extern std::atomic<float> g_canvas_enhance_threshold;
 extern std::atomic<float> g_absence_score_seen_threshold;
-
-// ---------------------------------------------------------------------------
-// FFI exports
-// ---------------------------------------------------------------------------
-extern "C" {
-    __declspec(dllexport) void    SetPanoramaEnabled(bool enabled);
-    __declspec(dllexport) void    ResetPanorama();
-    __declspec(dllexport) void    SetPanoramaViewport(float panX, float panY, float zoom);
-    __declspec(dllexport) void    GetPanoramaCanvasSize(int* width, int* height);
-    __declspec(dllexport) bool    IsPanoramaEnabled();
-
-    __declspec(dllexport) void    SetCanvasViewMode(bool mode);
-    __declspec(dllexport) bool    IsCanvasViewMode();
-    __declspec(dllexport) void    SetCanvasRenderMode(int mode);
-    __declspec(dllexport) int64_t GetCanvasTextureId();
-    __declspec(dllexport) bool    GetCanvasOverviewRgba(uint8_t* buffer, int width, int height);
-    __declspec(dllexport) bool    GetCanvasOverviewJpeg(uint8_t* buffer, int max_bytes, int* out_size, int quality, int max_dim);
-    __declspec(dllexport) bool    GetCanvasViewportRgba(uint8_t* buffer, int width, int height,
-                                                         float panX, float panY, float zoom);
-
-    __declspec(dllexport) int     GetSubCanvasCount();
-    __declspec(dllexport) int     GetActiveSubCanvasIndex();
-    __declspec(dllexport) void    SetActiveSubCanvas(int idx);
-    __declspec(dllexport) int     GetSortedSubCanvasIndex(int pos);
-    __declspec(dllexport) int     GetSortedPosition(int idx);
-
-    __declspec(dllexport) void    SetWhiteboardDebug(bool enabled);
-    __declspec(dllexport) void    SetDuplicateDebugMode(bool enabled);
-    __declspec(dllexport) bool    GetDuplicateDebugMode();
-    __declspec(dllexport) void    SetCanvasEnhanceThreshold(float threshold);
-    __declspec(dllexport) void    SetAbsenceScoreSeenThreshold(float threshold);
-    __declspec(dllexport) float   GetAbsenceScoreSeenThreshold();
-
-    // Graph node access
-    __declspec(dllexport) int     GetGraphNodeCount();
-    __declspec(dllexport) int     GetGraphNodes(float* buffer, int max_nodes);
-    __declspec(dllexport) int     GetGraphHardEdges(int* buffer, int max_edges);
-    __declspec(dllexport) int     GetGraphNodeNeighbors(int node_id, int* neighbors,
-                                                         int max_neighbors);
-    __declspec(dllexport) bool    CompareGraphNodes(int id_a, int id_b, float* result);
-    __declspec(dllexport) bool    CompareGraphNodesAtOffset(int id_a, int id_b,
-                                                             float dx, float dy, float* result);
-    __declspec(dllexport) int     GetGraphNodeMasks(uint8_t* buffer, int max_bytes);
-    __declspec(dllexport) bool    MoveGraphNode(int node_id, float new_cx, float new_cy);
-    __declspec(dllexport) bool    DeleteGraphNode(int node_id);
-    __declspec(dllexport) bool    ApplyUserEdits(const int* delete_ids, int delete_count,
-                                                  const float* moves, int move_count);
-    __declspec(dllexport) int     LockAllGraphNodes();
-    __declspec(dllexport) bool    GetGraphCanvasBounds(int* bounds);
-    __declspec(dllexport) int     GetGraphNodeContours(float* buffer, int max_floats);
-
-    // Debug snapshots (stubs)
-    __declspec(dllexport) bool    CaptureGraphDebugSnapshot(int slot);
-    __declspec(dllexport) int     GetGraphSnapshotNodeCount(int slot);
-    __declspec(dllexport) int     GetGraphSnapshotNodes(int slot, float* buffer, int max_nodes);
-    __declspec(dllexport) bool    GetGraphSnapshotCanvasBounds(int slot, int* bounds);
-    __declspec(dllexport) int     GetGraphSnapshotNodeContours(int slot, float* buffer,
-                                                                int max_floats);
-    __declspec(dllexport) bool    CompareGraphSnapshotNodes(int slot_a, int id_a,
-                                                             int slot_b, int id_b,
-                                                             float* result);
-    __declspec(dllexport) bool    CombineGraphDebugSnapshots(int slot_a, int anchor_id_a,
-                                                              int slot_b, int anchor_id_b);
-    __declspec(dllexport) bool    CopyGraphDebugSnapshot(int source_slot, int target_slot);
-
-    // Canvas version + full-res export
-    __declspec(dllexport) uint64_t GetCanvasVersion();
-    __declspec(dllexport) bool     GetCanvasFullResRgba(uint8_t* buffer, int max_w, int max_h,
-                                                         int* out_w, int* out_h);
-}
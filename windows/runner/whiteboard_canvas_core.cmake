@@ -0,0 +1,41 @@
+# whiteboard_canvas_core -- platform-neutral whiteboard canvas stitcher.
+#
+# Binarize -> blobs -> match -> graph update -> render, OpenCV only. Included by
+# runner/CMakeLists.txt for the Windows app and by bench/CMakeLists.txt for
+# headless builds (Linux profiling, replay benchmarks).
+#
+# OpenCV is resolved by the includer: the runner uses OPENCV_ROOT and links
+# opencv_world into the executable; headless builds call find_package(OpenCV)
+# first and the libraries are propagated from here.
+
+set(WHITEBOARD_CANVAS_CORE_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+add_library(whiteboard_canvas_core STATIC
+  "${WHITEBOARD_CANVAS_CORE_DIR}/whiteboard_canvas.cpp"
+  "${WHITEBOARD_CANVAS_CORE_DIR}/whiteboard_canvas_perf.cpp"
+  "${WHITEBOARD_CANVAS_CORE_DIR}/whiteboard_enhance.cpp"
+  "${WHITEBOARD_CANVAS_CORE_DIR}/whiteboard_graph_changes.cpp"
+)
+
+# The Win32 helper-process client is linked into the runner alongside this
+# library; everywhere else the canvas always runs in-process.
+if(NOT WIN32)
+  target_sources(whiteboard_canvas_core PRIVATE
+    "${WHITEBOARD_CANVAS_CORE_DIR}/whiteboard_canvas_process_stub.cpp"
+  )
+endif()
+
+target_include_directories(whiteboard_canvas_core PUBLIC "${WHITEBOARD_CANVAS_CORE_DIR}")
+target_compile_features(whiteboard_canvas_core PUBLIC cxx_std_17)
+
+if(OpenCV_FOUND)
+  target_include_directories(whiteboard_canvas_core PUBLIC ${OpenCV_INCLUDE_DIRS})
+  target_link_libraries(whiteboard_canvas_core PUBLIC ${OpenCV_LIBS})
+endif()
+
+find_package(Threads REQUIRED)
+target_link_libraries(whiteboard_canvas_core PUBLIC Threads::Threads)
+
+if(WIN32)
+  target_compile_definitions(whiteboard_canvas_core PRIVATE "NOMINMAX")
+endif()
@@ -0,0 +1,327 @@
+// ============================================================================
+// whiteboard_canvas_ffi.cpp -- Dart FFI exports for the whiteboard canvas
+//
+// Kept out of whiteboard_canvas.cpp so the canvas core stays platform-neutral:
+// these wrappers depend on NativeCamera (display refresh) and __declspec.
+// ============================================================================
+
+#include "whiteboard_canvas_ffi.h"
+#include "whiteboard_canvas.h"
+#include "native_camera.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+static bool CopyBgrFrameToRgbaBuffer(const cv::Mat& bgr, uint8_t* buf, int w, int h) {
+    if (bgr.empty() || !buf || w <= 0 || h <= 0) return false;
+    cv::Mat rgba; cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
+    cv::Mat view(h, w, CV_8UC4, buf);
+    rgba.copyTo(view);
+    return true;
+}
+
+// Last encoded overview JPEG. Live-share polling asks for the same overview
+// at the same quality many times per canvas version; re-encoding is skipped
+// while the key matches. Not used with the helper process, whose canvas
+// version is not mirrored into this process.
+struct OverviewJpegMemo {
+    std::mutex         mutex;
+    bool               valid = false;
+    uint64_t           version = 0;
+    CanvasRenderMode   mode = CanvasRenderMode::kStroke;
+    int                sub_canvas = -1;
+    cv::Size           size;
+    int                quality = 0;
+    std::vector<uchar> bytes;
+};
+
+OverviewJpegMemo g_overview_jpeg_memo;
+
+static bool CopyJpegToBuffer(const std::vector<uchar>& jpeg, uint8_t* buffer,
+                             int max_bytes, int* out_size) {
+    if (jpeg.empty() || jpeg.size() > static_cast<size_t>(max_bytes)) {
+        *out_size = 0;
+        return false;
+    }
+    std::memcpy(buffer, jpeg.data(), jpeg.size());
+    *out_size = static_cast<int>(jpeg.size());
+    return true;
+}
+
+}  // namespace
+
+void SetPanoramaEnabled(bool enabled) {
+    if (enabled) {
+        if (!g_whiteboard_canvas) {
+            g_whiteboard_canvas = new WhiteboardCanvas();
+            // In process the canvas uses the host's detector; load it now,
+            // not on the first frame.
+            if (!g_whiteboard_canvas->IsRemoteProcess()) EnsurePersonDetectorStarted();
+        } else {
+            g_whiteboard_canvas->SetCanvasViewMode(false);
+            g_whiteboard_canvas->Reset();
+        }
+        g_whiteboard_canvas->SyncRuntimeSettings();
+        g_whiteboard_enabled.store(true);
+    } else {
+        g_whiteboard_enabled.store(false);
+        if (g_whiteboard_canvas) {
+            g_whiteboard_canvas->SetCanvasViewMode(false);
+            g_whiteboard_canvas->Reset();
+        }
+    }
+    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
+}
+
+void ResetPanorama() {
+    if (g_whiteboard_canvas) g_whiteboard_canvas->Reset();
+    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
+}
+
+void SetPanoramaViewport(float panX, float panY, float zoom) {
+    g_canvas_pan_x.store(panX); g_canvas_pan_y.store(panY); g_canvas_zoom.store(zoom);
+    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
+}
+
+void GetPanoramaCanvasSize(int* width, int* height) {
+    if (g_whiteboard_canvas) {
+        cv::Size s = g_whiteboard_canvas->GetCanvasSize();
+        if (width)  *width  = s.width;
+        if (height) *height = s.height;
+    } else {
+        if (width)  *width  = 1920;
+        if (height) *height = 1080;
+    }
+}
+
+bool IsPanoramaEnabled() { return g_whiteboard_enabled.load(); }
+
+void SetCanvasViewMode(bool mode) {
+    if (g_whiteboard_canvas) g_whiteboard_canvas->SetCanvasViewMode(mode);
+    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
+}
+
+bool IsCanvasViewMode() {
+    return g_whiteboard_canvas && g_whiteboard_canvas->IsCanvasViewMode();
+}
+
+void SetCanvasRenderMode(int mode) {
+    if (g_whiteboard_canvas) {
+        g_whiteboard_canvas->SetRenderMode(
+            mode == static_cast<int>(CanvasRenderMode::kRaw)
+                ? CanvasRenderMode::kRaw : CanvasRenderMode::kStroke);
+    }
+    if (g_native_camera) g_native_camera->RefreshDisplayFrame();
+}
+
+int64_t GetCanvasTextureId() {
+    return g_native_camera ? g_native_camera->GetTextureId() : -1;
+}
+
+bool GetCanvasOverviewRgba(uint8_t* buffer, int width, int height) {
+    if (!g_whiteboard_canvas || !buffer || width <= 0 || height <= 0) return false;
+    cv::Mat overview;
+    if (!g_whiteboard_canvas->GetOverviewBlocking(cv::Size(width, height), overview)) return false;
+    return CopyBgrFrameToRgbaBuffer(overview, buffer, width, height);
+}
+
+bool GetCanvasOverviewJpeg(uint8_t* buffer, int max_bytes, int* out_size, int quality, int max_dim) {
+    if (!g_whiteboard_canvas || !buffer || !out_size || max_bytes <= 0) return false;
+    
+    cv::Size native_size = g_whiteboard_canvas->GetCanvasSize();
+    if (native_size.width <= 0 || native_size.height <= 0) return false;
+    
+    float scale = 1.0f;
+    if (max_dim > 0 && (native_size.width > max_dim || native_size.height > max_dim)) {
+        scale = static_cast<float>(max_dim) / std::max(native_size.width, native_size.height);
+    }
+    cv::Size view_size(
+        std::max(1, static_cast<int>(native_size.width * scale)),
+        std::max(1, static_cast<int>(native_size.height * scale))
+    );
+
+    // Read the key before rendering: if the canvas changes meanwhile the entry
+    // is stored under the older version and simply misses next time. The
+    // sub-canvas is the rendered one (view_group_idx_ in canvas view mode), and
+    // the store uses what GetOverviewBlocking actually drew, so a view switch
+    // mid-render cannot file one group's JPEG under another.
+    const bool memoize = !g_whiteboard_canvas->IsRemoteProcess();
+    const uint64_t version = g_whiteboard_canvas->GetCanvasVersion();
+    const CanvasRenderMode mode = g_whiteboard_canvas->GetRenderMode();
+    const int sub_canvas = g_whiteboard_canvas->GetActiveSubCanvasIndex();
+    auto& memo = g_overview_jpeg_memo;
+    if (memoize) {
+        std::lock_guard<std::mutex> lock(memo.mutex);
+        if (memo.valid && memo.version == version && memo.mode == mode &&
+            memo.sub_canvas == sub_canvas && memo.size == view_size &&
+            memo.quality == quality) {
+            return CopyJpegToBuffer(memo.bytes, buffer, max_bytes, out_size);
+        }
+    }
+
+    // Render and encode outside the memo lock so concurrent callers are not
+    // serialized behind a full overview render.
+    cv::Mat overview;
+    int rendered_group = -1;
+    if (!g_whiteboard_canvas->GetOverviewBlocking(view_size, overview, &rendered_group)) return false;
+    
+    std::vector<uchar> buf;
+    std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, quality};
+    if (!cv::imencode(".jpg", overview, buf, params)) {
+        *out_size = 0;
+        return false;
+    }
+    if (memoize && rendered_group >= 0) {
+        std::lock_guard<std::mutex> lock(memo.mutex);
+        memo.valid = true;
+        memo.version = version;
+        memo.mode = mode;
+        memo.sub_canvas = rendered_group;
+        memo.size = view_size;
+        memo.quality = quality;
+        memo.bytes = buf;
+    }
+    return CopyJpegToBuffer(buf, buffer, max_bytes, out_size);
+}
+
+bool GetCanvasViewportRgba(uint8_t* buffer, int width, int height,
+                            float panX, float panY, float zoom) {
+    if (!g_whiteboard_canvas || !buffer || width <= 0 || height <= 0) return false;
+    cv::Mat viewport;
+    if (!g_whiteboard_canvas->GetViewport(panX, panY, zoom,
+                                           cv::Size(width, height), viewport)) return false;
+    return CopyBgrFrameToRgbaBuffer(viewport, buffer, width, height);
+}
+
+void SetWhiteboardDebug(bool enabled) {
+    g_whiteboard_debug.store(enabled);
+    if (g_whiteboard_canvas) g_whiteboard_canvas->SyncRuntimeSettings();
+}
+
+void SetDuplicateDebugMode(bool enabled) {
+    g_duplicate_debug_mode.store(enabled);
+    if (g_whiteboard_canvas) g_whiteboard_canvas->SetDuplicateDebugMode(enabled);
+}
+
+bool GetDuplicateDebugMode() {
+    return g_duplicate_debug_mode.load();
+}
+
+void SetCanvasEnhanceThreshold(float threshold) {
+    g_canvas_enhance_threshold.store(threshold);
+    if (g_whiteboard_canvas) g_whiteboard_canvas->SyncRuntimeSettings();
+}
+
+void SetAbsenceScoreSeenThreshold(float threshold) {
+    g_absence_score_seen_threshold.store(threshold);
+    if (g_whiteboard_canvas) g_whiteboard_canvas->RefreshSeenThresholdVisibility();
+}
+
+float GetAbsenceScoreSeenThreshold() {
+    return g_absence_score_seen_threshold.load();
+}
+
+int GetSubCanvasCount() {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetSubCanvasCount() : 0;
+}
+int GetActiveSubCanvasIndex() {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetActiveSubCanvasIndex() : -1;
+}
+void SetActiveSubCanvas(int idx) {
+    if (g_whiteboard_canvas) g_whiteboard_canvas->SetActiveSubCanvas(idx);
+}
+int GetSortedSubCanvasIndex(int pos) {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetSortedSubCanvasIndex(pos) : -1;
+}
+int GetSortedPosition(int idx) {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetSortedPosition(idx) : -1;
+}
+
+void RefreshGraphExport() {
+    if (g_whiteboard_canvas) g_whiteboard_canvas->RefreshGraphExport();
+}
+int GetGraphNodeCount() {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphNodeCount() : 0;
+}
+int GetGraphNodes(float* buffer, int max_nodes) {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphNodes(buffer, max_nodes) : 0;
+}
+int GetGraphHardEdges(int* buffer, int max_edges) {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphHardEdges(buffer, max_edges) : 0;
+}
+int GetGraphNodeNeighbors(int node_id, int* neighbors, int max_neighbors) {
+    return g_whiteboard_canvas
+        ? g_whiteboard_canvas->GetGraphNodeNeighbors(node_id, neighbors, max_neighbors) : 0;
+}
+bool CompareGraphNodes(int id_a, int id_b, float* result) {
+    return g_whiteboard_canvas && g_whiteboard_canvas->CompareGraphNodes(id_a, id_b, result);
+}
+bool CompareGraphNodesAtOffset(int id_a, int id_b, float dx, float dy, float* result) {
+    return g_whiteboard_canvas &&
+        g_whiteboard_canvas->CompareGraphNodesAtOffset(id_a, id_b, dx, dy, result);
+}
+int GetGraphNodeMasks(uint8_t* buffer, int max_bytes) {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetGraphNodeMasks(buffer, max_bytes) : 0;
+}
+bool MoveGraphNode(int node_id, float new_cx, float new_cy) {
+    return g_whiteboard_canvas && g_whiteboard_canvas->MoveGraphNode(node_id, new_cx, new_cy);
+}
+bool DeleteGraphNode(int node_id) {
+    return g_whiteboard_canvas && g_whiteboard_canvas->DeleteGraphNode(node_id);
+}
+bool ApplyUserEdits(const int* delete_ids, int delete_count,
+                    const float* moves, int move_count) {
+    return g_whiteboard_canvas &&
+        g_whiteboard_canvas->ApplyUserEdits(delete_ids, delete_count, moves, move_count);
+}
+int LockAllGraphNodes() {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->LockAllGraphNodes() : 0;
+}
+bool GetGraphCanvasBounds(int* bounds) {
+    return g_whiteboard_canvas && g_whiteboard_canvas->GetGraphCanvasBounds(bounds);
+}
+int GetGraphNodeContours(float* buffer, int max_floats) {
+    return g_whiteboard_canvas
+        ? g_whiteboard_canvas->GetGraphNodeContours(buffer, max_floats) : 0;
+}
+int GetGraphChanges(int since_version, float* buffer, int max_floats) {
+    return g_whiteboard_canvas
+        ? g_whiteboard_canvas->GetGraphChanges(since_version, buffer, max_floats) : 0;
+}
+
+int GetCanvasPerfSnapshot(float* buffer, int max_floats) {
+    return g_whiteboard_canvas
+        ? g_whiteboard_canvas->GetPerfSnapshot(buffer, max_floats) : 0;
+}
+
+int GetCanvasFrameRingStats(float* buffer, int max_floats) {
+    return g_whiteboard_canvas
+        ? g_whiteboard_canvas->GetFrameRingStats(buffer, max_floats) : 0;
+}
+
+// Debug snapshot stubs
+bool CaptureGraphDebugSnapshot(int /*slot*/) { return false; }
+int  GetGraphSnapshotNodeCount(int /*slot*/) { return 0; }
+int  GetGraphSnapshotNodes(int /*slot*/, float* /*buf*/, int /*max*/) { return 0; }
+bool GetGraphSnapshotCanvasBounds(int /*slot*/, int* /*bounds*/) { return false; }
+int  GetGraphSnapshotNodeContours(int /*slot*/, float* /*buf*/, int /*max*/) { return 0; }
+bool CompareGraphSnapshotNodes(int, int, int, int, float*) { return false; }
+bool CombineGraphDebugSnapshots(int, int, int, int) { return false; }
+bool CopyGraphDebugSnapshot(int, int) { return false; }
+
+uint64_t GetCanvasVersion() {
+    return g_whiteboard_canvas ? g_whiteboard_canvas->GetCanvasVersion() : 0;
+}
+
+bool GetCanvasFullResRgba(uint8_t* buffer, int max_w, int max_h, int* out_w, int* out_h) {
+    if (!g_whiteboard_canvas || !buffer || max_w <= 0 || max_h <= 0) return false;
+    cv::Mat overview;
+    if (!g_whiteboard_canvas->GetOverviewBlocking(cv::Size(max_w, max_h), overview)) return false;
+    if (out_w) *out_w = overview.cols;
+    if (out_h) *out_h = overview.rows;
+    return CopyBgrFrameToRgbaBuffer(overview, buffer, overview.cols, overview.rows);
+}
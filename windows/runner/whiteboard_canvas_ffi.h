@@ -0,0 +1,90 @@
+#pragma once
+// ============================================================================
+// whiteboard_canvas_ffi.h -- Dart FFI surface of the whiteboard canvas
+//
+// Thin wrappers around g_whiteboard_canvas, defined in whiteboard_canvas_ffi.cpp.
+// Windows-runner only: the exports are compiled straight into the executable so
+// the linker never drops them from the whiteboard_canvas_core static library.
+// ============================================================================
+
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// FFI exports
+// ---------------------------------------------------------------------------
+extern "C" {
+    __declspec(dllexport) void    SetPanoramaEnabled(bool enabled);
+    __declspec(dllexport) void    ResetPanorama();
+    __declspec(dllexport) void    SetPanoramaViewport(float panX, float panY, float zoom);
+    __declspec(dllexport) void    GetPanoramaCanvasSize(int* width, int* height);
+    __declspec(dllexport) bool    IsPanoramaEnabled();
+
+    __declspec(dllexport) void    SetCanvasViewMode(bool mode);
+    __declspec(dllexport) bool    IsCanvasViewMode();
+    __declspec(dllexport) void    SetCanvasRenderMode(int mode);
+    __declspec(dllexport) int64_t GetCanvasTextureId();
+    __declspec(dllexport) bool    GetCanvasOverviewRgba(uint8_t* buffer, int width, int height);
+    __declspec(dllexport) bool    GetCanvasOverviewJpeg(uint8_t* buffer, int max_bytes, int* out_size, int quality, int max_dim);
+    __declspec(dllexport) bool    GetCanvasViewportRgba(uint8_t* buffer, int width, int height,
+                                                         float panX, float panY, float zoom);
+
+    __declspec(dllexport) int     GetSubCanvasCount();
+    __declspec(dllexport) int     GetActiveSubCanvasIndex();
+    __declspec(dllexport) void    SetActiveSubCanvas(int idx);
+    __declspec(dllexport) int     GetSortedSubCanvasIndex(int pos);
+    __declspec(dllexport) int     GetSortedPosition(int idx);
+
+    __declspec(dllexport) void    SetWhiteboardDebug(bool enabled);
+    __declspec(dllexport) void    SetDuplicateDebugMode(bool enabled);
+    __declspec(dllexport) bool    GetDuplicateDebugMode();
+    __declspec(dllexport) void    SetCanvasEnhanceThreshold(float threshold);
+    __declspec(dllexport) void    SetAbsenceScoreSeenThreshold(float threshold);
+    __declspec(dllexport) float   GetAbsenceScoreSeenThreshold();
+
+    // Graph node access. RefreshGraphExport once per refresh, then the getters.
+    __declspec(dllexport) void    RefreshGraphExport();
+    __declspec(dllexport) int     GetGraphNodeCount();
+    __declspec(dllexport) int     GetGraphNodes(float* buffer, int max_nodes);
+    __declspec(dllexport) int     GetGraphHardEdges(int* buffer, int max_edges);
+    __declspec(dllexport) int     GetGraphNodeNeighbors(int node_id, int* neighbors,
+                                                         int max_neighbors);
+    __declspec(dllexport) bool    CompareGraphNodes(int id_a, int id_b, float* result);
+    __declspec(dllexport) bool    CompareGraphNodesAtOffset(int id_a, int id_b,
+                                                             float dx, float dy, float* result);
+    __declspec(dllexport) int     GetGraphNodeMasks(uint8_t* buffer, int max_bytes);
+    __declspec(dllexport) bool    MoveGraphNode(int node_id, float new_cx, float new_cy);
+    __declspec(dllexport) bool    DeleteGraphNode(int node_id);
+    __declspec(dllexport) bool    ApplyUserEdits(const int* delete_ids, int delete_count,
+                                                  const float* moves, int move_count);
+    __declspec(dllexport) int     LockAllGraphNodes();
+    __declspec(dllexport) bool    GetGraphCanvasBounds(int* bounds);
+    __declspec(dllexport) int     GetGraphNodeContours(float* buffer, int max_floats);
+    // Incremental graph sync; layout in whiteboard_graph_changes.h
+    __declspec(dllexport) int     GetGraphChanges(int since_version, float* buffer,
+                                                   int max_floats);
+
+    // Worker stage timings; layout in whiteboard_canvas_perf.h
+    __declspec(dllexport) int     GetCanvasPerfSnapshot(float* buffer, int max_floats);
+
+    // Helper-process frame ring counters; layout in whiteboard_canvas_process.h
+    __declspec(dllexport) int     GetCanvasFrameRingStats(float* buffer, int max_floats);
+
+    // Debug snapshots (stubs)
+    __declspec(dllexport) bool    CaptureGraphDebugSnapshot(int slot);
+    __declspec(dllexport) int     GetGraphSnapshotNodeCount(int slot);
+    __declspec(dllexport) int     GetGraphSnapshotNodes(int slot, float* buffer, int max_nodes);
+    __declspec(dllexport) bool    GetGraphSnapshotCanvasBounds(int slot, int* bounds);
+    __declspec(dllexport) int     GetGraphSnapshotNodeContours(int slot, float* buffer,
+                                                                int max_floats);
+    __declspec(dllexport) bool    CompareGraphSnapshotNodes(int slot_a, int id_a,
+                                                             int slot_b, int id_b,
+                                                             float* result);
+    __declspec(dllexport) bool    CombineGraphDebugSnapshots(int slot_a, int anchor_id_a,
+                                                              int slot_b, int anchor_id_b);
+    __declspec(dllexport) bool    CopyGraphDebugSnapshot(int source_slot, int target_slot);
+
+    // Canvas version + full-res export
+    __declspec(dllexport) uint64_t GetCanvasVersion();
+    __declspec(dllexport) bool     GetCanvasFullResRgba(uint8_t* buffer, int max_w, int max_h,
+                                                         int* out_w, int* out_h);
+}
@@ -0,0 +1,122 @@
+#include "whiteboard_canvas_perf.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Upper bin edges in ms; the last bin catches everything above 512 ms.
+constexpr float kBinUpperEdgesMs[kCanvasPerfBinCount] = {
+    0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f, 128.0f, 256.0f, 512.0f,
+    std::numeric_limits<float>::infinity(),
+};
+
+// Nearest-rank percentile of an ascending vector; p in [0, 100].
+double PercentileSorted(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+void WriteRow(std::vector<double>& samples, float* row) {
+    std::fill(row, row + kCanvasPerfRowFloats, 0.0f);
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    row[0] = static_cast<float>(sum / static_cast<double>(samples.size()));
+    row[1] = static_cast<float>(PercentileSorted(samples, 50.0));
+    row[2] = static_cast<float>(PercentileSorted(samples, 90.0));
+    row[3] = static_cast<float>(PercentileSorted(samples, 99.0));
+    row[4] = static_cast<float>(samples.back());
+
+    float* bins = row + kCanvasPerfRowStats;
+    int bin = 0;
+    for (double s : samples) {  // ascending, so the bin index only moves forward
+        while (bin < kCanvasPerfBinCount - 1 && s > kBinUpperEdgesMs[bin]) bin++;
+        bins[bin] += 1.0f;
+    }
+}
+
+}  // namespace
+
+void CanvasPerfRing::Push(const CanvasFrameStats& stats) {
+    const uint64_t n = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[n % kCapacity];
+
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &stats, sizeof(CanvasFrameStats));
+
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++)
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    head_.store(n + 1, std::memory_order_release);
+}
+
+int CanvasPerfRing::CopyRecent(std::vector<CanvasFrameStats>& out) const {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t first = head > static_cast<uint64_t>(kCapacity) ? head - kCapacity : 0;
+    int copied = 0;
+    for (uint64_t n = first; n < head; n++) {
+        const Slot& slot = slots_[n % kCapacity];
+        const uint64_t expected = 2 * n + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) continue;
+
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; i++)
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != expected) continue;  // overwritten
+
+        CanvasFrameStats stats;
+        std::memcpy(&stats, words, sizeof(CanvasFrameStats));
+        out.push_back(stats);
+        copied++;
+    }
+    return copied;
+}
+
+int BuildCanvasPerfSnapshot(const std::vector<CanvasFrameStats>& frames,
+                            float* buffer, int max_floats) {
+    if (!buffer || max_floats < kCanvasPerfSnapshotFloats) return 0;
+    std::fill(buffer, buffer + kCanvasPerfSnapshotFloats, 0.0f);
+
+    const int gate_stage = static_cast<int>(CanvasStage::kMotionGate);
+    std::vector<double> rows[kCanvasPerfRowCount];
+    int accepted = 0;
+    double blob_sum = 0.0, matched_sum = 0.0;
+    for (const auto& f : frames) {
+        for (int s = 0; s <= gate_stage; s++) rows[s].push_back(f.stage_ms[s]);
+        rows[kCanvasStageCount].push_back(f.total_ms);
+        if (!f.accepted) continue;
+        accepted++;
+        blob_sum += f.blob_count;
+        matched_sum += f.matched_count;
+        for (int s = gate_stage + 1; s < kCanvasStageCount; s++) rows[s].push_back(f.stage_ms[s]);
+    }
+
+    buffer[0] = static_cast<float>(kCanvasPerfLayoutVersion);
+    buffer[1] = static_cast<float>(frames.size());
+    buffer[2] = static_cast<float>(accepted);
+    buffer[3] = static_cast<float>(kCanvasPerfRowCount);
+    buffer[4] = static_cast<float>(kCanvasPerfBinCount);
+    if (accepted > 0) {
+        buffer[5] = static_cast<float>(blob_sum / accepted);
+        buffer[6] = static_cast<float>(matched_sum / accepted);
+    }
+    if (!frames.empty()) buffer[7] = static_cast<float>(frames.back().node_count);
+
+    float* edges = buffer + kCanvasPerfHeaderFloats;
+    std::copy(std::begin(kBinUpperEdgesMs), std::end(kBinUpperEdgesMs), edges);
+
+    float* row = edges + kCanvasPerfBinCount;
+    for (int r = 0; r < kCanvasPerfRowCount; r++, row += kCanvasPerfRowFloats)
+        WriteRow(rows[r], row);
+    return kCanvasPerfSnapshotFloats;
+}
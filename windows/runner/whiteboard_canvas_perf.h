@@ -0,0 +1,97 @@
+#pragma once
+// ============================================================================
+// whiteboard_canvas_perf.h -- Per-frame stage timings for the canvas worker
+//
+// ProcessFrameInternal fills one CanvasFrameStats per frame. The worker pushes
+// it into a CanvasPerfRing (single producer, lock-free readers) and the debug
+// screen pulls a fixed-layout float snapshot through GetCanvasPerfSnapshot.
+// ============================================================================
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Stages of ProcessFrameInternal, in execution order.
+enum class CanvasStage : int {
+    kNoUpdateMask = 0,   // crop, gray, person/no-update mask, reject mask
+    kMotionGate,
+    kBinarize,
+    kExtract,
+    kEnhance,            // EnhanceFrameBlobs + FilterBlobsForCanvas
+    kMatch,              // MatchBlobsToGraph (includes state lock wait)
+    kUpdate,             // UpdateGraph / seed / create, incl. duplicate sweep
+    kCount,
+};
+static constexpr int kCanvasStageCount = static_cast<int>(CanvasStage::kCount);
+
+// Per-frame timings and counters filled by ProcessFrameInternal.
+// Stages that did not run (motion-gated frames) keep 0 ms.
+struct CanvasFrameStats {
+    int    frame_id = -1;
+    bool   accepted = false;           // passed ROI + motion gate
+    double stage_ms[kCanvasStageCount] = {};
+    double total_ms = 0.0;
+    int    blob_count = 0;             // blobs after canvas filtering
+    int    matched_count = 0;          // blobs with matched_node_id >= 0
+    int    node_count = 0;             // nodes in the active group afterwards
+    // Filled only with WhiteboardCanvas::SetVerifyGlobalShapePass(true):
+    int    shape_check_blobs = 0;      // blobs matched by the exhaustive global scan
+    int    shape_check_mismatches = 0; // ... whose top-k offset differs from it
+    float  shape_check_offset_error = 0.0f;  // px between the two rough offsets
+};
+
+// ---------------------------------------------------------------------------
+// Snapshot layout (floats) written by BuildCanvasPerfSnapshot:
+//
+//   [0] layout version            [4] histogram bin count B
+//   [1] frames in window          [5] mean blobs per accepted frame
+//   [2] accepted frames           [6] mean matched blobs per accepted frame
+//   [3] row count R               [7] node count after the newest frame
+//   [8 .. 8+B)   bin upper edges in ms (last = +inf)
+//   then R rows: mean, p50, p90, p99, max, B bin counts
+//
+// Rows are the kCanvasStageCount stages followed by the frame total. Stages up
+// to the motion gate (and the total) cover every frame; later stages only
+// accepted frames, so gated frames do not drag their percentiles toward 0.
+// ---------------------------------------------------------------------------
+static constexpr int kCanvasPerfLayoutVersion = 1;
+static constexpr int kCanvasPerfHeaderFloats  = 8;
+static constexpr int kCanvasPerfBinCount      = 12;
+static constexpr int kCanvasPerfRowStats      = 5;
+static constexpr int kCanvasPerfRowCount      = kCanvasStageCount + 1;
+static constexpr int kCanvasPerfRowFloats     = kCanvasPerfRowStats + kCanvasPerfBinCount;
+static constexpr int kCanvasPerfSnapshotFloats =
+    kCanvasPerfHeaderFloats + kCanvasPerfBinCount + kCanvasPerfRowCount * kCanvasPerfRowFloats;
+
+// Fixed-capacity ring of the most recent frames. One writer (the canvas worker)
+// and any number of readers; each slot is a seqlock, so readers never block the
+// worker and simply skip a slot that is being overwritten.
+class CanvasPerfRing {
+public:
+    static constexpr int kCapacity = 256;
+
+    void Push(const CanvasFrameStats& stats);
+    // Appends the readable frames, oldest first. Returns the number appended.
+    int CopyRecent(std::vector<CanvasFrameStats>& out) const;
+    uint64_t PushedCount() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    static_assert(std::is_trivially_copyable<CanvasFrameStats>::value,
+                  "CanvasFrameStats is copied word-wise through the ring");
+    static constexpr size_t kWords = (sizeof(CanvasFrameStats) + 7) / 8;
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};  // odd while written, 2*(n+1) once frame n is stored
+        std::atomic<uint64_t> words[kWords] = {};
+    };
+
+    Slot slots_[kCapacity];
+    std::atomic<uint64_t> head_{0};
+};
+
+// Writes the snapshot described above. Returns kCanvasPerfSnapshotFloats, or
+// 0 when max_floats is too small.
+int BuildCanvasPerfSnapshot(const std::vector<CanvasFrameStats>& frames,
+                            float* buffer, int max_floats);
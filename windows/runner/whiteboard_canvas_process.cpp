@@ -2,6 +2,7 @@
 
 #include "native_camera.h"
 #include "whiteboard_canvas.h"
+#include "yolo_person_detector.h"
 
 #include <windows.h>
 
@@ -9,30 +10,31 @@
 #include <atomic>
 #include <cmath>
 #include <chrono>
+#include <climits>
+#include <cstddef>
 #include <cstring>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
 namespace {
 
-constexpr uint32_t kSharedMagic = 0x57424950;  // 'WBIP'
+constexpr uint32_t kSharedMagic = 0x57424950;   // 'WBIP'
+constexpr uint32_t kChannelMagic = 0x5742434E;  // 'WBCN'
+constexpr LONG kChannelLayoutVersion = 2;
 constexpr int kMaxFrameWidth = 3840;
 constexpr int kMaxFrameHeight = 2160;
-constexpr size_t kMaxFrameBytes =
-    static_cast<size_t>(kMaxFrameWidth) * static_cast<size_t>(kMaxFrameHeight) * 3;
-constexpr size_t kMaxMaskBytes =
-    static_cast<size_t>(kMaxFrameWidth) * static_cast<size_t>(kMaxFrameHeight);
 constexpr int kMaxOverviewWidth = 4096;
 constexpr int kMaxOverviewHeight = 4096;
-constexpr size_t kMaxOverviewBytes =
-    static_cast<size_t>(kMaxOverviewWidth) * static_cast<size_t>(kMaxOverviewHeight) * 3;
-constexpr DWORD kFrameSubmitLockTimeoutMs = 8;
-constexpr DWORD kImageReadLockTimeoutMs = 25;
+constexpr int kFrameRingSlots = 4;
+constexpr auto kFrameRingLogInterval = std::chrono::seconds(10);
+constexpr DWORD kImageReadTimeoutMs = 25;
 constexpr DWORD kStateReadLockTimeoutMs = 8;
 constexpr DWORD kHelperStartTimeoutMs = 5000;
-constexpr DWORD kHelperLoopWaitMs = 15;
+constexpr DWORD kGraphExportTimeoutMs = 500;
 constexpr int kNoSubCanvasRequest = -1;
 constexpr int kDefaultCanvasWidth = 1920;
 constexpr int kDefaultCanvasHeight = 1080;
@@ -43,6 +45,7 @@ constexpr int kMaxGraphEdges = 16384;
 constexpr int kGraphEdgeStride = 2;
 constexpr int kMaxGraphEdgeInts = kMaxGraphEdges * kGraphEdgeStride;
 constexpr int kMaxGraphContourFloats = 500000;
+constexpr int kMaxGraphChangeFloats = 1 << 20;     // one change set, 4 MB
 constexpr DWORD kGraphCompareTimeoutMs = 2000;
 constexpr int kGraphCompareResultFloats = 19;
 constexpr int kMaxEditDeletes = 256;
@@ -50,9 +53,42 @@ constexpr int kMaxEditMoves = 256;
 constexpr DWORD kEditCommandTimeoutMs = 2000;
 constexpr int kMaxMaskDataBytes = 20 * 1024 * 1024;  // 20 MB for node RGBA masks
 constexpr DWORD kMaskRequestTimeoutMs = 3000;
+
+// Why the client woke the helper; OR-ed into SharedState::wake_reasons before
+// the wake event is set. The helper takes them all at once and does only the
+// work they name.
+constexpr LONG kWakeFrame = 1 << 0;       // a frame was published to the ring
+constexpr LONG kWakeViewport = 1 << 1;    // viewport requested (pan, zoom, size)
+constexpr LONG kWakeOverview = 1 << 2;    // overview requested
+constexpr LONG kWakeGraph = 1 << 3;       // graph export, changes, compare or mask request
+constexpr LONG kWakeEdit = 1 << 4;        // user edit or lock command
+constexpr LONG kWakeSettings = 1 << 5;    // settings, modes, reset, sub-canvas, shutdown
+constexpr LONG kWakeFrameDone = 1 << 6;   // helper-internal: the canvas finished a frame
 bool g_is_helper_process = false;
 std::string g_helper_session_id;
 
+// ---------------------------------------------------------------------------
+// IPC layout
+//
+// The helper and the client share one small control block plus five data
+// channels, each its own named mapping:
+//
+//   control   settings, commands, small results     named mutex, both write
+//   frames    frame ring (client -> helper)         lock-free, per-slot seq
+//   outputs   viewport + overview (helper -> client) channel seqlock
+//   graph     graph debug export (helper -> client)  channel seqlock
+//   changes   graph change set (helper -> client)    channel seqlock
+//   response  node mask blob (helper -> client)      channel seqlock
+//
+// Data channels are created by their writer, sized to what they currently
+// carry (the negotiated frame size, the requested viewport/overview, the graph
+// and mask payloads), and replaced by a new generation when that no longer
+// fits. The writer publishes the generation in the control block; readers
+// reopen by name when it changes. A channel's `seq` is odd while its writer
+// updates the payload, so readers copy without any lock and retry or drop the
+// copy when it moved. The frame channel instead versions each ring slot.
+// ---------------------------------------------------------------------------
+
 #pragma pack(push, 1)
 struct SharedState {
     uint32_t magic = kSharedMagic;
@@ -64,6 +100,7 @@ struct SharedState {
     LONG whiteboard_debug = 0;
     LONG duplicate_debug_mode = 0;
     LONG reset_requested = 0;
+    LONG person_mask_reset_requested = 0;   // the host's camera session restarted
     LONG pending_active_subcanvas = kNoSubCanvasRequest;
     float pan_x = 0.5f;
     float pan_y = 0.5f;
@@ -71,6 +108,9 @@ struct SharedState {
     float absence_score_seen_threshold = kAbsenceScoreSeenThreshold;
     float enhance_threshold = 5.0f;
     float yolo_fps = 2.0f;
+    LONG person_detector_backend = 0;     // PersonDetectorConfig, enum values
+    LONG person_detector_precision = 0;
+    LONG person_detector_threads = 0;
     LONG viewport_req_width = 0;
     LONG viewport_req_height = 0;
     LONG overview_req_width = 0;
@@ -80,37 +120,16 @@ struct SharedState {
     LONG canvas_height = kDefaultCanvasHeight;
     LONG subcanvas_count = 0;
     LONG active_subcanvas = -1;
-    LONG frame_available = 0;
-    LONG frame_width = 0;
-    LONG frame_height = 0;
-    LONG mask_width = 0;
-    LONG mask_height = 0;
-    LONG viewport_width = 0;
-    LONG viewport_height = 0;
-    LONG overview_width = 0;
-    LONG overview_height = 0;
-    LONG graph_node_count = 0;
-    LONG graph_node_floats_written = 0;
-    LONG graph_edge_count = 0;
-    LONG graph_contour_floats_written = 0;
-    LONG graph_bounds_x = 0;
-    LONG graph_bounds_y = 0;
-    LONG graph_bounds_w = 0;
-    LONG graph_bounds_h = 0;
-    LONG graph_bounds_valid = 0;
     LONG graph_compare_request_id = 0;
     LONG graph_compare_node_a = -1;
     LONG graph_compare_node_b = -1;
     LONG graph_compare_result_ready = 0;
     LONG graph_compare_result_ok = 0;
     LONG graph_compare_result_id = 0;
-    unsigned char frame_bgr[kMaxFrameBytes];
-    unsigned char person_mask[kMaxMaskBytes];
-    unsigned char viewport_bgr[kMaxFrameBytes];
-    unsigned char overview_bgr[kMaxOverviewBytes];
-    float graph_nodes[kMaxGraphNodeFloats];
-    int graph_edges[kMaxGraphEdgeInts];
-    float graph_contours[kMaxGraphContourFloats];
+    LONG perf_snapshot_floats = 0;
+    float perf_snapshot[kCanvasPerfSnapshotFloats];
+    LONG person_detector_stats_floats = 0;
+    float person_detector_stats[kPersonDetectorStatsFloats];
     float graph_compare_result[kGraphCompareResultFloats];
 
     // User edit commands (client -> helper)
@@ -124,15 +143,137 @@ struct SharedState {
     LONG edit_result_ok = 0;
     LONG edit_result_id = 0;
 
-    // Mask data request/response (client -> helper -> client)
+    // Mask data request/response (client -> helper -> client); the data
+    // itself goes through the response channel.
     LONG mask_request_id = 0;
     LONG mask_result_ready = 0;
     LONG mask_result_id = 0;
-    LONG mask_result_bytes = 0;
-    unsigned char mask_data[kMaxMaskDataBytes];
+
+    // Graph export request/response; the export goes through the graph channel.
+    LONG graph_export_request_id = 0;
+    LONG graph_export_result_id = 0;
+    LONG graph_export_current = 0;      // the export matches the canvas as published
+
+    // Graph change request/response: the changes after `since`, at most
+    // `max_floats` of them, go through the changes channel.
+    LONG graph_changes_request_id = 0;
+    LONG graph_changes_since = 0;
+    LONG graph_changes_max_floats = 0;
+    LONG graph_changes_result_id = 0;
+
+    // kWake* bits set by the client since the helper last woke. Accessed only
+    // through InterlockedOr/InterlockedExchange.
+    LONG wake_reasons = 0;
+
+    // Published data channel generations (0 = none yet). Written with
+    // InterlockedExchange by the channel's writer, read with ReadAcquire.
+    LONG frame_channel_generation = 0;
+    LONG output_channel_generation = 0;
+    LONG graph_channel_generation = 0;
+    LONG changes_channel_generation = 0;
+    LONG response_channel_generation = 0;
+
+    // Frame ring counters; they outlive frame channel generations.
+    // Accessed only through Interlocked*/ReadAcquire.
+    LONG ring_submitted = 0;            // client: frames published
+    LONG ring_overwritten = 0;          // client: published over a frame the helper never took
+    LONG ring_consumed = 0;             // helper: frames taken
+    LONG ring_discarded = 0;            // helper: claimed slot was incomplete (should stay 0)
+    LONG ring_last_consumed_seq = 0;    // helper: seq of the last frame taken
+};
+
+// Start of every data channel mapping; the payload follows at 32 bytes.
+struct ChannelHeader {
+    uint32_t magic;
+    LONG layout_version;
+    LONG generation;
+    LONG seq;                           // odd while the writer updates the payload
+    LONG payload_bytes;
+    LONG reserved[3];
+};
+
+// Frame channel payload: this header, then kFrameRingSlots slots of
+// `slot_bytes`, each a FrameSlotHeader followed by the BGR frame and the
+// person mask at the channel's fixed frame size.
+//
+// Single producer (ProcessFrame) and single consumer (helper loop): the
+// client writes into a slot that is neither its last published one nor held
+// by the helper, then publishes it as the newest. The helper claims the
+// newest slot and hands it to its canvas worker in place; the slot stays
+// held until the worker is done with it. Older unread frames are simply
+// overwritten.
+//
+// The helper holds at most three slots (one being processed, one queued and
+// one just claimed), so with four slots the client always finds one.
+struct FrameRingHeader {
+    LONG latest_slot;                   // newest complete, untaken slot; -1 = none
+    LONG reader_slots;                  // bit i set while the helper holds slot i
+    LONG frame_width;
+    LONG frame_height;
+    LONG slot_bytes;
+    LONG reserved[3];
+};
+
+// `seq` is odd while the client writes the slot and 2 * frame id once the
+// frame is complete.
+struct FrameSlotHeader {
+    LONG seq;
+    LONG has_mask;
+    LONG reserved[6];
+};
+
+// Output channel payload: this header, the viewport at
+// kOutputsHeaderBytes, the overview at `overview_offset`.
+struct OutputsHeader {
+    LONG viewport_width;                // 0 = no viewport
+    LONG viewport_height;
+    LONG overview_width;                // 0 = no overview
+    LONG overview_height;
+    LONG overview_offset;
+    LONG reserved[3];
+};
+
+// Graph channel payload: this header, then node floats, edge ints and
+// contour floats back to back.
+struct GraphExportHeader {
+    LONG node_count;
+    LONG node_floats;
+    LONG edge_count;
+    LONG contour_floats;
+    LONG bounds_valid;
+    LONG bounds[4];
+    LONG reserved[7];
+};
+
+// Changes channel payload: this header, then `floats` floats in the
+// GraphChangeLog::Read layout.
+struct GraphChangesHeader {
+    LONG request_id;
+    LONG floats;
+    LONG reserved[6];
+};
+
+// Response channel payload: this header, then `bytes` of node mask data.
+struct MaskResponseHeader {
+    LONG request_id;
+    LONG bytes;
+    LONG reserved[6];
 };
 #pragma pack(pop)
 
+// Interlocked access needs naturally aligned LONGs; the packed layouts keep
+// every field a multiple of 4 bytes, and channel payloads start 32-aligned.
+static_assert(offsetof(SharedState, wake_reasons) % sizeof(LONG) == 0 &&
+              offsetof(SharedState, frame_channel_generation) % sizeof(LONG) == 0 &&
+              offsetof(SharedState, ring_submitted) % sizeof(LONG) == 0,
+              "control words must be LONG-aligned");
+static_assert(sizeof(ChannelHeader) == 32 && sizeof(FrameRingHeader) == 32 &&
+              sizeof(FrameSlotHeader) == 32 && sizeof(OutputsHeader) == 32 &&
+              sizeof(GraphExportHeader) == 64 && sizeof(GraphChangesHeader) == 32 &&
+              sizeof(MaskResponseHeader) == 32,
+              "channel headers keep their payloads aligned");
+constexpr size_t kOutputsHeaderBytes = sizeof(OutputsHeader);
+
 struct HelperStateSnapshot {
     bool shutdown = false;
     bool enabled = false;
@@ -141,6 +282,7 @@ struct HelperStateSnapshot {
     bool debug_enabled = false;
     bool duplicate_debug_enabled = false;
     bool reset_requested = false;
+    bool person_mask_reset_requested = false;
     int requested_active_subcanvas = kNoSubCanvasRequest;
     float pan_x = 0.5f;
     float pan_y = 0.5f;
@@ -148,11 +290,9 @@ struct HelperStateSnapshot {
     float absence_score_seen_threshold = kAbsenceScoreSeenThreshold;
     float enhance_threshold = 5.0f;
     float yolo_fps = 2.0f;
+    PersonDetectorConfig person_detector;
     cv::Size viewport_size;
     cv::Size overview_size;
-    cv::Mat frame;
-    cv::Mat person_mask;
-    bool has_new_frame = false;
     int graph_compare_request_id = 0;
     int graph_compare_node_a = -1;
     int graph_compare_node_b = -1;
@@ -163,6 +303,10 @@ struct HelperStateSnapshot {
     int edit_delete_ids[kMaxEditDeletes] = {};
     float edit_moves[kMaxEditMoves * 3] = {};
     int mask_request_id = 0;
+    int graph_export_request_id = 0;
+    int graph_changes_request_id = 0;
+    int graph_changes_since = 0;
+    int graph_changes_max_floats = 0;
 };
 
 std::wstring Utf16FromUtf8(const std::string& utf8) {
@@ -193,6 +337,29 @@ bool IsValidOverviewSize(int width, int height) {
     return width > 0 && height > 0 && width <= kMaxOverviewWidth && height <= kMaxOverviewHeight;
 }
 
+// True when both Mats view the same pixels (a memoized render came back).
+bool IsSameImage(const cv::Mat& a, const cv::Mat& b) {
+    return a.data == b.data && a.size() == b.size() && a.type() == b.type();
+}
+
+PersonDetectorConfig PersonDetectorConfigFromShared(const SharedState& shared) {
+    PersonDetectorConfig config;
+    config.backend = shared.person_detector_backend == static_cast<LONG>(PersonDetectorBackend::kOpenVinoCpu)
+        ? PersonDetectorBackend::kOpenVinoCpu : PersonDetectorBackend::kOpenCvCpu;
+    config.precision =
+        shared.person_detector_precision == static_cast<LONG>(PersonDetectorPrecision::kFp16)
+            ? PersonDetectorPrecision::kFp16
+        : shared.person_detector_precision == static_cast<LONG>(PersonDetectorPrecision::kInt8)
+            ? PersonDetectorPrecision::kInt8
+            : PersonDetectorPrecision::kFp32;
+    config.threads = std::max(0, static_cast<int>(shared.person_detector_threads));
+    return config;
+}
+
+bool SamePersonDetectorConfig(const PersonDetectorConfig& a, const PersonDetectorConfig& b) {
+    return a.backend == b.backend && a.precision == b.precision && a.threads == b.threads;
+}
+
 size_t FrameBytesForSize(int width, int height) {
     return static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
 }
@@ -239,6 +406,206 @@ private:
     HANDLE handle_ = nullptr;
 };
 
+std::wstring MakeChannelName(const std::wstring& prefix, const std::wstring& session_id,
+                             LONG generation) {
+    return prefix + session_id + L"_" + std::to_wstring(generation);
+}
+
+size_t AlignChannelBytes(size_t bytes) {
+    return (bytes + 63) & ~static_cast<size_t>(63);
+}
+
+// Slot stride of a frame channel carrying width x height frames.
+size_t FrameSlotBytesForSize(int width, int height) {
+    return AlignChannelBytes(sizeof(FrameSlotHeader) + FrameBytesForSize(width, height) +
+                             MaskBytesForSize(width, height));
+}
+
+// One named data channel mapping (see "IPC layout" above).
+class SharedChannel {
+public:
+    SharedChannel() = default;
+    ~SharedChannel() { Close(); }
+
+    SharedChannel(const SharedChannel&) = delete;
+    SharedChannel& operator=(const SharedChannel&) = delete;
+
+    // Writer side: creates a zero-filled channel with `payload_bytes` of payload.
+    bool Create(const std::wstring& name, LONG generation, size_t payload_bytes) {
+        Close();
+        const uint64_t total = sizeof(ChannelHeader) + static_cast<uint64_t>(payload_bytes);
+        if (payload_bytes > static_cast<size_t>(LONG_MAX)) return false;
+        mapping_.reset(CreateFileMappingW(
+            INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(total >> 32), static_cast<DWORD>(total & 0xFFFFFFFFu),
+            name.c_str()));
+        // An existing object would be a stale generation of another size.
+        if (!mapping_.get() || GetLastError() == ERROR_ALREADY_EXISTS) {
+            Close();
+            return false;
+        }
+        view_ = MapViewOfFile(mapping_.get(), FILE_MAP_ALL_ACCESS, 0, 0, static_cast<size_t>(total));
+        if (!view_) {
+            Close();
+            return false;
+        }
+        ChannelHeader* h = header();
+        h->magic = kChannelMagic;
+        h->layout_version = kChannelLayoutVersion;
+        h->generation = generation;
+        h->seq = 0;
+        h->payload_bytes = static_cast<LONG>(payload_bytes);
+        generation_ = generation;
+        payload_bytes_ = payload_bytes;
+        return true;
+    }
+
+    // Reader side: opens the channel the writer published as `generation`.
+    bool Open(const std::wstring& name, LONG generation) {
+        Close();
+        mapping_.reset(OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name.c_str()));
+        if (!mapping_.get()) return false;
+        view_ = MapViewOfFile(mapping_.get(), FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        if (!view_) {
+            Close();
+            return false;
+        }
+        const ChannelHeader* h = header();
+        if (h->magic != kChannelMagic || h->layout_version != kChannelLayoutVersion ||
+            h->generation != generation || h->payload_bytes < 0) {
+            Close();
+            return false;
+        }
+        generation_ = generation;
+        payload_bytes_ = static_cast<size_t>(h->payload_bytes);
+        return true;
+    }
+
+    void Close() {
+        if (view_) {
+            UnmapViewOfFile(view_);
+            view_ = nullptr;
+        }
+        mapping_.reset();
+        generation_ = 0;
+        payload_bytes_ = 0;
+    }
+
+    bool IsOpen() const { return view_ != nullptr; }
+    LONG generation() const { return generation_; }
+    size_t payload_bytes() const { return payload_bytes_; }
+    ChannelHeader* header() const { return static_cast<ChannelHeader*>(view_); }
+    unsigned char* payload() const {
+        return static_cast<unsigned char*>(view_) + sizeof(ChannelHeader);
+    }
+
+    // Writer: brackets a payload update.
+    void BeginWrite() { InterlockedIncrement(&header()->seq); }
+    void EndWrite() { InterlockedIncrement(&header()->seq); }
+
+    // Reader: runs `read` against a consistent payload, retrying while the
+    // writer is mid-update. `read` must stay in bounds on torn data; its
+    // result is only kept when this returns true.
+    template <typename ReadFn>
+    bool ReadConsistent(DWORD timeout_ms, ReadFn&& read) const {
+        if (!IsOpen()) return false;
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            const LONG seq = ReadAcquire(&header()->seq);
+            if ((seq & 1) == 0) {
+                read();
+                MemoryBarrier();
+                if (ReadAcquire(&header()->seq) == seq) return true;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    ScopedHandle mapping_;
+    void* view_ = nullptr;
+    LONG generation_ = 0;
+    size_t payload_bytes_ = 0;
+};
+
+FrameRingHeader* FrameRing(const SharedChannel& channel) {
+    return reinterpret_cast<FrameRingHeader*>(channel.payload());
+}
+
+FrameSlotHeader* FrameRingSlot(const SharedChannel& channel, int index) {
+    return reinterpret_cast<FrameSlotHeader*>(
+        channel.payload() + sizeof(FrameRingHeader) +
+        static_cast<size_t>(index) * static_cast<size_t>(FrameRing(channel)->slot_bytes));
+}
+
+// The ring geometry is fixed at creation; checked once per opened generation.
+bool IsValidFrameRing(const SharedChannel& channel) {
+    if (!channel.IsOpen() || channel.payload_bytes() < sizeof(FrameRingHeader)) return false;
+    const FrameRingHeader* ring = FrameRing(channel);
+    if (!IsValidFrameSize(ring->frame_width, ring->frame_height)) return false;
+    const size_t slot_bytes = static_cast<size_t>(ring->slot_bytes);
+    return ring->slot_bytes > 0 &&
+           slot_bytes >= FrameSlotBytesForSize(ring->frame_width, ring->frame_height) &&
+           sizeof(FrameRingHeader) + kFrameRingSlots * slot_bytes <= channel.payload_bytes();
+}
+
+// A frame ring slot the helper holds. The client skips the slot until the
+// lease is destroyed; the lease also keeps the mapping the slot lives in.
+class FrameSlotLease {
+public:
+    FrameSlotLease(std::shared_ptr<SharedChannel> channel, int slot)
+        : channel_(std::move(channel)), slot_(slot) {}
+    ~FrameSlotLease() {
+        InterlockedAnd(&FrameRing(*channel_)->reader_slots, ~(1 << slot_));
+    }
+
+    FrameSlotLease(const FrameSlotLease&) = delete;
+    FrameSlotLease& operator=(const FrameSlotLease&) = delete;
+
+private:
+    std::shared_ptr<SharedChannel> channel_;
+    int slot_;
+};
+
+// Reader: follows the generation the writer published in `published`.
+bool SyncChannel(SharedChannel& channel, const volatile LONG* published,
+                 const std::wstring& prefix, const std::wstring& session_id) {
+    const LONG generation = ReadAcquire(published);
+    if (generation <= 0) {
+        channel.Close();
+        return false;
+    }
+    if (channel.IsOpen() && channel.generation() == generation) return true;
+    return channel.Open(MakeChannelName(prefix, session_id, generation), generation);
+}
+
+// Writer: makes sure `channel` holds `needed` payload bytes, replacing it by
+// a new generation (with headroom for growing payloads) when it is too small
+// or wastes more than three quarters, and publishes the generation.
+bool EnsureChannel(SharedChannel& channel, volatile LONG* published,
+                   const std::wstring& prefix, const std::wstring& session_id,
+                   size_t needed, bool exact) {
+    const size_t capacity = channel.payload_bytes();
+    if (channel.IsOpen() && needed <= capacity && needed >= capacity / 4) return true;
+    const size_t bytes = exact ? needed : AlignChannelBytes(needed + needed / 2);
+    const LONG generation = ReadAcquire(published) + 1;
+    if (!channel.Create(MakeChannelName(prefix, session_id, generation), generation, bytes)) {
+        std::cerr << "[WhiteboardCanvas] Failed to create helper channel ("
+                  << bytes << " bytes)" << std::endl;
+        return false;
+    }
+    InterlockedExchange(published, generation);
+    return true;
+}
+
+const wchar_t kFrameChannelPrefix[] = L"Local\\KaptchiWhiteboardFrames_";
+const wchar_t kOutputChannelPrefix[] = L"Local\\KaptchiWhiteboardOutputs_";
+const wchar_t kGraphChannelPrefix[] = L"Local\\KaptchiWhiteboardGraph_";
+const wchar_t kChangesChannelPrefix[] = L"Local\\KaptchiWhiteboardGraphChanges_";
+const wchar_t kResponseChannelPrefix[] = L"Local\\KaptchiWhiteboardResponse_";
+
 class WhiteboardHelperServer {
 public:
     explicit WhiteboardHelperServer(std::string session_id)
@@ -251,8 +618,17 @@ public:
         }
 
         WhiteboardCanvas canvas;
+        // Frames are processed on the canvas worker; it wakes us to publish
+        // the state they changed.
+        canvas.SetFrameProcessedCallback([this]() {
+            InterlockedOr(&shared_->wake_reasons, kWakeFrameDone);
+            SetEvent(wake_event_.get());
+        });
+        PersonMaskTracker person_tracker(GetWhiteboardPersonMask);
+        HelperStateSnapshot snapshot;
         cv::Mat last_viewport;
         cv::Mat last_overview;
+        uint64_t outputs_version = 0;   // bumped whenever last_viewport/last_overview change
         cv::Size latest_output_size(kDefaultCanvasWidth, kDefaultCanvasHeight);
         int last_graph_compare_request_id = 0;
         int graph_compare_result_id = 0;
@@ -262,15 +638,60 @@ public:
 
         int last_edit_request_id = 0;
         int last_mask_request_id = 0;
+        int last_graph_export_request_id = 0;
+        int last_graph_changes_request_id = 0;
         int edit_result_id = 0;
         bool edit_result_ready = false;
         bool edit_result_ok = false;
 
+        // The canvas detector lives here. Start it with the config the client
+        // wrote before launching us, so it is not loaded twice.
+        PersonDetectorConfig detector_config;
+        if (WaitAndLock(mutex_.get(), 1000)) {
+            detector_config = PersonDetectorConfigFromShared(*shared_);
+            Unlock(mutex_.get());
+        }
+        PersonDetector::Instance().Configure(detector_config);
+        PersonDetector::Instance().Start(GetModelPath);
+
+        // Apply whatever settings the client wrote before the loop started.
+        InterlockedOr(&shared_->wake_reasons, kWakeSettings);
+        SetEvent(wake_event_.get());
+
+        // Sleeps until the client names a reason; nothing runs on a timer.
         while (true) {
-            WaitForSingleObject(wake_event_.get(), kHelperLoopWaitMs);
+            WaitForSingleObject(wake_event_.get(), INFINITE);
+            const LONG reasons = InterlockedExchange(&shared_->wake_reasons, 0);
+            // A stale signal whose reasons an earlier wake already took.
+            if (reasons == 0) continue;
+
+            // Frames come through the ring and need no control block read.
+            if ((reasons & kWakeFrame) != 0) {
+                cv::Mat frame;
+                cv::Mat person_mask;
+                std::shared_ptr<const void> frame_lease;
+                if (TakeLatestFrame(frame, person_mask, frame_lease)) {
+                    latest_output_size = frame.size();
+                    if (person_mask.empty() || person_mask.size() != frame.size() ||
+                        person_mask.type() != CV_8UC1) {
+                        person_mask = person_tracker.Update(frame, g_yolo_fps.load());
+                    }
+                    // The canvas works on the ring slot itself and releases
+                    // the lease when it is done with the frame.
+                    canvas.ProcessSharedFrame(frame, person_mask, std::move(frame_lease));
+                }
+                LogFrameRingDrops();
+            }
+            if ((reasons & ~(kWakeFrame | kWakeFrameDone)) == 0) {
+                // No command: only the state a processed frame changed.
+                if ((reasons & kWakeFrameDone) != 0) WriteCanvasState(canvas);
+                continue;
+            }
 
-            HelperStateSnapshot snapshot;
             if (!ReadSnapshot(snapshot)) {
+                // Keep the reasons for the next attempt.
+                InterlockedOr(&shared_->wake_reasons, reasons & ~kWakeFrame);
+                SetEvent(wake_event_.get());
                 std::this_thread::sleep_for(std::chrono::milliseconds(5));
                 continue;
             }
@@ -278,42 +699,46 @@ public:
                 break;
             }
 
-            g_whiteboard_debug.store(snapshot.debug_enabled);
-            g_duplicate_debug_mode.store(snapshot.duplicate_debug_enabled);
-            const float previous_seen_threshold = g_absence_score_seen_threshold.load();
-            g_absence_score_seen_threshold.store(snapshot.absence_score_seen_threshold);
-            g_canvas_enhance_threshold.store(snapshot.enhance_threshold);
-            g_yolo_fps.store(snapshot.yolo_fps);
+            if ((reasons & kWakeSettings) != 0) {
+                g_whiteboard_debug.store(snapshot.debug_enabled);
+                g_duplicate_debug_mode.store(snapshot.duplicate_debug_enabled);
+                const float previous_seen_threshold = g_absence_score_seen_threshold.load();
+                g_absence_score_seen_threshold.store(snapshot.absence_score_seen_threshold);
+                g_canvas_enhance_threshold.store(snapshot.enhance_threshold);
+                g_yolo_fps.store(snapshot.yolo_fps);
+                if (!SamePersonDetectorConfig(snapshot.person_detector, detector_config)) {
+                    detector_config = snapshot.person_detector;
+                    PersonDetector::Instance().Configure(detector_config);
+                }
 
-            if (std::abs(previous_seen_threshold - snapshot.absence_score_seen_threshold) > 1e-6f) {
-                canvas.RefreshSeenThresholdVisibility();
-            }
+                if (std::abs(previous_seen_threshold - snapshot.absence_score_seen_threshold) > 1e-6f) {
+                    canvas.RefreshSeenThresholdVisibility();
+                }
 
-            canvas.SetCanvasViewMode(snapshot.canvas_view_mode);
-            canvas.SetRenderMode(snapshot.render_mode);
-            canvas.SetDuplicateDebugMode(snapshot.duplicate_debug_enabled);
+                canvas.SetCanvasViewMode(snapshot.canvas_view_mode);
+                canvas.SetRenderMode(snapshot.render_mode);
+                canvas.SetDuplicateDebugMode(snapshot.duplicate_debug_enabled);
+            }
 
+            // A mask from before a reset or camera restart must not be
+            // shifted onto the new session's frames.
+            if (snapshot.reset_requested || snapshot.person_mask_reset_requested) {
+                person_tracker.Reset();
+            }
             if (snapshot.reset_requested) {
                 canvas.Reset();
                 last_viewport.release();
                 last_overview.release();
+                outputs_version++;
             }
             if (snapshot.requested_active_subcanvas >= 0) {
                 canvas.SetActiveSubCanvas(snapshot.requested_active_subcanvas);
             }
 
-            if (snapshot.has_new_frame && !snapshot.frame.empty()) {
-                latest_output_size = snapshot.frame.size();
-                cv::Mat person_mask = snapshot.person_mask;
-                if (person_mask.empty() || person_mask.size() != snapshot.frame.size() ||
-                    person_mask.type() != CV_8UC1) {
-                    person_mask = GetWhiteboardPersonMask(snapshot.frame);
-                }
-                canvas.ProcessFrame(snapshot.frame, person_mask);
-            }
-
+            // Renders are memoized per canvas version, so an unchanged canvas
+            // hands back the same buffer and the outputs are not rewritten.
             const bool has_content = canvas.HasContent();
-            if (has_content) {
+            if (has_content && (reasons & kWakeViewport) != 0) {
                 cv::Size viewport_size = snapshot.viewport_size;
                 if (!IsValidFrameSize(viewport_size.width, viewport_size.height)) {
                     viewport_size = latest_output_size;
@@ -322,11 +747,14 @@ public:
                 if (IsValidFrameSize(viewport_size.width, viewport_size.height)) {
                     cv::Mat viewport;
                     if (canvas.GetViewport(snapshot.pan_x, snapshot.pan_y, snapshot.zoom,
-                                           viewport_size, viewport)) {
+                                           viewport_size, viewport) &&
+                        !IsSameImage(viewport, last_viewport)) {
                         last_viewport = viewport;
+                        outputs_version++;
                     }
                 }
-
+            }
+            if (has_content && (reasons & kWakeOverview) != 0) {
                 cv::Size overview_size = snapshot.overview_size;
                 if (!IsValidOverviewSize(overview_size.width, overview_size.height)) {
                     overview_size = latest_output_size;
@@ -341,13 +769,17 @@ public:
 
                 if (IsValidOverviewSize(overview_size.width, overview_size.height)) {
                     cv::Mat overview;
-                    if (canvas.GetOverviewBlocking(overview_size, overview)) {
+                    if (canvas.GetOverviewBlocking(overview_size, overview) &&
+                        !IsSameImage(overview, last_overview)) {
                         last_overview = overview;
+                        outputs_version++;
                     }
                 }
-            } else {
+            }
+            if (!has_content && (!last_viewport.empty() || !last_overview.empty())) {
                 last_viewport.release();
                 last_overview.release();
+                outputs_version++;
             }
 
             if (snapshot.graph_compare_request_id > 0 &&
@@ -380,45 +812,57 @@ public:
                 edit_result_ok = edit_ok;
                 edit_result_ready = true;
                 last_edit_request_id = snapshot.edit_request_id;
+                graph_export_stale_ = true;
             }
 
             // Process mask data request
-            int mask_bytes_written = 0;
-            bool mask_result_ready_flag = false;
-            int mask_result_id_val = 0;
             if (snapshot.mask_request_id > 0 &&
                 snapshot.mask_request_id != last_mask_request_id) {
                 // Use a heap buffer to avoid stack overflow
                 static thread_local std::vector<uint8_t> local_mask_buf(kMaxMaskDataBytes);
-                mask_bytes_written = canvas.GetGraphNodeMasks(
+                const int mask_bytes_written = canvas.GetGraphNodeMasks(
                     local_mask_buf.data(), kMaxMaskDataBytes);
-                mask_result_id_val = snapshot.mask_request_id;
-                mask_result_ready_flag = true;
                 last_mask_request_id = snapshot.mask_request_id;
+                WriteMaskResponse(snapshot.mask_request_id, local_mask_buf.data(),
+                                  std::max(0, mask_bytes_written));
+            }
 
-                // Write mask data directly under shared lock
-                if (WaitAndLock(mutex_.get(), 50)) {
-                    if (mask_bytes_written > 0) {
-                        std::memcpy(shared_->mask_data, local_mask_buf.data(),
-                                    mask_bytes_written);
-                    }
-                    shared_->mask_result_bytes = mask_bytes_written;
-                    shared_->mask_result_id = mask_result_id_val;
-                    shared_->mask_result_ready = 1;
-                    Unlock(mutex_.get());
-                }
+            // The graph is exported only on request, and only rebuilt when
+            // the canvas changed since the last export.
+            int graph_export_result_id = 0;
+            if (snapshot.graph_export_request_id > 0 &&
+                snapshot.graph_export_request_id != last_graph_export_request_id) {
+                WriteGraphExport(canvas, has_content);
+                graph_export_result_id = snapshot.graph_export_request_id;
+                last_graph_export_request_id = snapshot.graph_export_request_id;
+            }
+
+            // Graph changes come from the canvas' change log; only the
+            // events the client has not seen cross the process boundary.
+            if (snapshot.graph_changes_request_id > 0 &&
+                snapshot.graph_changes_request_id != last_graph_changes_request_id) {
+                static thread_local std::vector<float> local_changes(kMaxGraphChangeFloats);
+                const int max_floats =
+                    std::clamp(snapshot.graph_changes_max_floats, 0, kMaxGraphChangeFloats);
+                const int change_floats = canvas.GetGraphChanges(
+                    snapshot.graph_changes_since, local_changes.data(), max_floats);
+                last_graph_changes_request_id = snapshot.graph_changes_request_id;
+                WriteGraphChanges(snapshot.graph_changes_request_id, local_changes.data(),
+                                  std::max(0, change_floats));
             }
 
             WriteResults(canvas,
                          last_viewport,
                          last_overview,
+                         outputs_version,
                          graph_compare_result_ready,
                          graph_compare_result_id,
                          graph_compare_result_ok,
                          graph_compare_result,
                          edit_result_ready,
                          edit_result_id,
-                         edit_result_ok);
+                         edit_result_ok,
+                         graph_export_result_id);
         }
 
         return EXIT_SUCCESS;
@@ -478,6 +922,7 @@ private:
         snapshot.debug_enabled = shared_->whiteboard_debug != 0;
         snapshot.duplicate_debug_enabled = shared_->duplicate_debug_mode != 0;
         snapshot.reset_requested = shared_->reset_requested != 0;
+        snapshot.person_mask_reset_requested = shared_->person_mask_reset_requested != 0;
         snapshot.requested_active_subcanvas = shared_->pending_active_subcanvas;
         snapshot.pan_x = shared_->pan_x;
         snapshot.pan_y = shared_->pan_y;
@@ -485,6 +930,7 @@ private:
         snapshot.absence_score_seen_threshold = shared_->absence_score_seen_threshold;
         snapshot.enhance_threshold = shared_->enhance_threshold;
         snapshot.yolo_fps = shared_->yolo_fps;
+        snapshot.person_detector = PersonDetectorConfigFromShared(*shared_);
         snapshot.viewport_size = cv::Size(shared_->viewport_req_width, shared_->viewport_req_height);
         snapshot.overview_size = cv::Size(shared_->overview_req_width, shared_->overview_req_height);
         snapshot.graph_compare_request_id = static_cast<int>(shared_->graph_compare_request_id);
@@ -492,29 +938,10 @@ private:
         snapshot.graph_compare_node_b = static_cast<int>(shared_->graph_compare_node_b);
 
         shared_->reset_requested = 0;
+        shared_->person_mask_reset_requested = 0;
         shared_->pending_active_subcanvas = kNoSubCanvasRequest;
         shared_->helper_alive = 1;
 
-        if (shared_->frame_available != 0 && IsValidFrameSize(shared_->frame_width, shared_->frame_height)) {
-            const int frame_width = shared_->frame_width;
-            const int frame_height = shared_->frame_height;
-            const size_t frame_bytes = FrameBytesForSize(frame_width, frame_height);
-            snapshot.frame = cv::Mat(frame_height, frame_width, CV_8UC3);
-            std::memcpy(snapshot.frame.data, shared_->frame_bgr, frame_bytes);
-            snapshot.has_new_frame = true;
-
-            if (shared_->mask_width == frame_width && shared_->mask_height == frame_height) {
-                const size_t mask_bytes = MaskBytesForSize(frame_width, frame_height);
-                snapshot.person_mask = cv::Mat(frame_height, frame_width, CV_8UC1);
-                std::memcpy(snapshot.person_mask.data, shared_->person_mask, mask_bytes);
-            }
-            shared_->frame_available = 0;
-            shared_->frame_width = 0;
-            shared_->frame_height = 0;
-            shared_->mask_width = 0;
-            shared_->mask_height = 0;
-        }
-
         // Read edit commands
         snapshot.edit_request_id = static_cast<int>(shared_->edit_request_id);
         snapshot.edit_lock_all = shared_->edit_lock_all != 0;
@@ -531,64 +958,165 @@ private:
 
         // Read mask request
         snapshot.mask_request_id = static_cast<int>(shared_->mask_request_id);
+        snapshot.graph_export_request_id = static_cast<int>(shared_->graph_export_request_id);
+        snapshot.graph_changes_request_id = static_cast<int>(shared_->graph_changes_request_id);
+        snapshot.graph_changes_since = static_cast<int>(shared_->graph_changes_since);
+        snapshot.graph_changes_max_floats = static_cast<int>(shared_->graph_changes_max_floats);
 
         Unlock(mutex_.get());
         return true;
     }
 
+    // Reports frames the client overwrote before this loop got to them, at
+    // most once per kFrameRingLogInterval and only when the count grew.
+    void LogFrameRingDrops() {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_ring_log_ < kFrameRingLogInterval) return;
+        const LONG overwritten = ReadAcquire(&shared_->ring_overwritten);
+        const LONG discarded = ReadAcquire(&shared_->ring_discarded);
+        if (overwritten == logged_overwritten_ && discarded == logged_discarded_) return;
+        std::cout << "[WhiteboardCanvas] Frame ring: " << ReadAcquire(&shared_->ring_submitted)
+                  << " submitted, " << ReadAcquire(&shared_->ring_consumed) << " taken, "
+                  << overwritten - logged_overwritten_ << " overwritten and "
+                  << discarded - logged_discarded_ << " discarded since last report" << std::endl;
+        logged_overwritten_ = overwritten;
+        logged_discarded_ = discarded;
+        last_ring_log_ = now;
+    }
+
+    // Takes the newest frame from the ring without the shared mutex. frame and
+    // person_mask view the slot itself; `lease` must outlive every use of
+    // them. Returns false when no complete frame was waiting.
+    bool TakeLatestFrame(cv::Mat& frame, cv::Mat& person_mask,
+                         std::shared_ptr<const void>& lease) {
+        if (!shared_) return false;
+        // Leased slots keep an older mapping alive until the canvas lets go,
+        // so a new generation gets a channel object of its own.
+        const LONG published = ReadAcquire(&shared_->frame_channel_generation);
+        if (!frames_ || frames_->generation() != published) {
+            frames_ = std::make_shared<SharedChannel>();
+        }
+        const LONG opened_generation = frames_->generation();
+        if (!SyncChannel(*frames_, &shared_->frame_channel_generation,
+                         kFrameChannelPrefix, session_id_utf16_)) {
+            return false;
+        }
+        if (frames_->generation() != opened_generation && !IsValidFrameRing(*frames_)) {
+            std::cerr << "[WhiteboardCanvas] Ignoring malformed frame channel" << std::endl;
+            frames_->Close();
+            return false;
+        }
+        FrameRingHeader* ring = FrameRing(*frames_);
+
+        // Mark the slot held before claiming it: once the claim succeeds the
+        // client has already seen the mark and will not pick the slot.
+        LONG slot_index = -1;
+        while (true) {
+            slot_index = ReadAcquire(&ring->latest_slot);
+            if (slot_index < 0 || slot_index >= kFrameRingSlots) return false;
+            InterlockedOr(&ring->reader_slots, 1 << slot_index);
+            if (InterlockedCompareExchange(&ring->latest_slot, -1, slot_index) == slot_index) {
+                break;
+            }
+            InterlockedAnd(&ring->reader_slots, ~(1 << slot_index));
+        }
+        auto slot_lease = std::make_shared<FrameSlotLease>(frames_, slot_index);
+
+        FrameSlotHeader* slot = FrameRingSlot(*frames_, slot_index);
+        unsigned char* frame_data = reinterpret_cast<unsigned char*>(slot + 1);
+        const int frame_width = ring->frame_width;
+        const int frame_height = ring->frame_height;
+        const LONG seq = ReadAcquire(&slot->seq);
+        if (seq <= 0 || (seq & 1) != 0) {
+            // Published slots are always complete; this means a broken client.
+            InterlockedIncrement(&shared_->ring_discarded);
+            return false;
+        }
+        frame = cv::Mat(frame_height, frame_width, CV_8UC3, frame_data);
+        if (slot->has_mask != 0) {
+            person_mask = cv::Mat(frame_height, frame_width, CV_8UC1,
+                                  frame_data + FrameBytesForSize(frame_width, frame_height));
+        } else {
+            person_mask.release();
+        }
+        lease = std::move(slot_lease);
+
+        InterlockedExchange(&shared_->ring_last_consumed_seq, seq);
+        InterlockedIncrement(&shared_->ring_consumed);
+        return true;
+    }
+
+    void WriteMaskResponse(int request_id, const uint8_t* data, int bytes) {
+        if (!shared_) return;
+        const bool have_channel = EnsureChannel(
+            response_, &shared_->response_channel_generation, kResponseChannelPrefix,
+            session_id_utf16_, sizeof(MaskResponseHeader) + static_cast<size_t>(bytes), false);
+        if (have_channel) {
+            response_.BeginWrite();
+            auto* header = reinterpret_cast<MaskResponseHeader*>(response_.payload());
+            header->request_id = request_id;
+            header->bytes = bytes;
+            if (bytes > 0) std::memcpy(header + 1, data, static_cast<size_t>(bytes));
+            response_.EndWrite();
+        }
+
+        // A failed channel still answers, with no data, so the client stops waiting.
+        if (WaitAndLock(mutex_.get(), 50)) {
+            shared_->mask_result_id = request_id;
+            shared_->mask_result_ready = 1;
+            Unlock(mutex_.get());
+        }
+    }
+
+    void WriteGraphChanges(int request_id, const float* data, int floats) {
+        if (!shared_) return;
+        const size_t bytes = static_cast<size_t>(floats) * sizeof(float);
+        const bool have_channel = EnsureChannel(
+            changes_, &shared_->changes_channel_generation, kChangesChannelPrefix,
+            session_id_utf16_, sizeof(GraphChangesHeader) + bytes, false);
+        if (have_channel) {
+            changes_.BeginWrite();
+            auto* header = reinterpret_cast<GraphChangesHeader*>(changes_.payload());
+            header->request_id = request_id;
+            header->floats = floats;
+            if (bytes > 0) std::memcpy(header + 1, data, bytes);
+            changes_.EndWrite();
+        }
+
+        // As with masks, a failed channel still answers so the client stops waiting.
+        if (WaitAndLock(mutex_.get(), 50)) {
+            shared_->graph_changes_result_id = request_id;
+            Unlock(mutex_.get());
+        }
+    }
+
     void WriteResults(WhiteboardCanvas& canvas,
                       const cv::Mat& viewport,
                       const cv::Mat& overview,
+                      uint64_t outputs_version,
                       bool graph_compare_result_ready,
                       int graph_compare_result_id,
                       bool graph_compare_result_ok,
                       const float* graph_compare_result,
                       bool edit_result_ready,
                       int edit_result_id,
-                      bool edit_result_ok) {
+                      bool edit_result_ok,
+                      int graph_export_result_id) {
         if (!shared_) return;
 
-        // Read canvas state BEFORE acquiring the shared mutex.
-        // GetCanvasSize/GetSubCanvasCount/GetActiveSubCanvasIndex each lock
-        // state_mutex_ internally, which the worker thread may hold for
-        // hundreds of ms.  Doing this outside the shared mutex prevents the
-        // client from timing out on every read attempt.
-        const bool has_content = canvas.HasContent();
-        const cv::Size canvas_size = has_content ? canvas.GetCanvasSize() : cv::Size(0, 0);
-        const int subcanvas_count = has_content ? canvas.GetSubCanvasCount() : 0;
-        const int active_subcanvas = has_content ? canvas.GetActiveSubCanvasIndex() : -1;
-
-        // Pre-read graph debug data outside the shared mutex
-        int graph_node_count = 0;
-        int graph_node_floats = 0;
-        int graph_edge_count = 0;
-        int graph_contour_floats = 0;
-        int graph_bounds[4] = {0, 0, 0, 0};
-        bool graph_bounds_valid = false;
-        float local_graph_nodes[kMaxGraphNodeFloats];
-        int local_graph_edges[kMaxGraphEdgeInts];
-        // Use a heap buffer for contours (too large for stack)
-        static thread_local std::vector<float> local_graph_contours(kMaxGraphContourFloats);
+        const CanvasStateBlock state = ReadCanvasState(canvas);
 
-        if (has_content) {
-            graph_node_count = canvas.GetGraphNodeCount();
-            if (graph_node_count > 0) {
-                graph_node_floats = canvas.GetGraphNodes(local_graph_nodes, kMaxGraphNodes) * kGraphNodeStride;
-                graph_edge_count = canvas.GetGraphHardEdges(local_graph_edges, kMaxGraphEdges);
-                graph_contour_floats = canvas.GetGraphNodeContours(
-                    local_graph_contours.data(), kMaxGraphContourFloats);
-                graph_bounds_valid = canvas.GetGraphCanvasBounds(graph_bounds);
-            }
+        // Images go through their own channel, outside the shared mutex, so
+        // they never hold up commands or frame submission.
+        if (outputs_version != written_outputs_version_ &&
+            WriteOutputs(state.has_content ? viewport : cv::Mat(),
+                         state.has_content ? overview : cv::Mat())) {
+            written_outputs_version_ = outputs_version;
         }
 
         if (!WaitAndLock(mutex_.get(), 50)) return;
 
-        shared_->helper_alive = 1;
-        shared_->has_content = has_content ? 1 : 0;
-        shared_->canvas_width = canvas_size.width;
-        shared_->canvas_height = canvas_size.height;
-        shared_->subcanvas_count = subcanvas_count;
-        shared_->active_subcanvas = active_subcanvas;
+        StoreCanvasStateUnsafe(state);
         shared_->graph_compare_result_ready = graph_compare_result_ready ? 1 : 0;
         shared_->graph_compare_result_ok = graph_compare_result_ok ? 1 : 0;
         shared_->graph_compare_result_id = graph_compare_result_id;
@@ -598,73 +1126,171 @@ private:
                         sizeof(shared_->graph_compare_result));
         }
 
-        if (!has_content) {
-            shared_->viewport_width = 0;
-            shared_->viewport_height = 0;
-            shared_->overview_width = 0;
-            shared_->overview_height = 0;
-            shared_->graph_node_count = 0;
-            shared_->graph_node_floats_written = 0;
-            shared_->graph_edge_count = 0;
-            shared_->graph_contour_floats_written = 0;
-            shared_->graph_bounds_valid = 0;
-            Unlock(mutex_.get());
-            return;
+        // Write edit command results
+        if (edit_result_ready) {
+            shared_->edit_result_ready = 1;
+            shared_->edit_result_ok = edit_result_ok ? 1 : 0;
+            shared_->edit_result_id = edit_result_id;
         }
-
-        if (!viewport.empty() && IsValidFrameSize(viewport.cols, viewport.rows)) {
-            const size_t viewport_bytes = FrameBytesForSize(viewport.cols, viewport.rows);
-            std::memcpy(shared_->viewport_bgr, viewport.data, viewport_bytes);
-            shared_->viewport_width = viewport.cols;
-            shared_->viewport_height = viewport.rows;
-        } else {
-            shared_->viewport_width = 0;
-            shared_->viewport_height = 0;
+        if (graph_export_result_id > 0) {
+            shared_->graph_export_result_id = graph_export_result_id;
         }
 
-        if (!overview.empty() && IsValidOverviewSize(overview.cols, overview.rows)) {
-            const size_t overview_bytes = FrameBytesForSize(overview.cols, overview.rows);
-            std::memcpy(shared_->overview_bgr, overview.data, overview_bytes);
-            shared_->overview_width = overview.cols;
-            shared_->overview_height = overview.rows;
-        } else {
-            shared_->overview_width = 0;
-            shared_->overview_height = 0;
+        Unlock(mutex_.get());
+    }
+
+    // The canvas state the client polls, published after every command wake
+    // and every processed frame.
+    struct CanvasStateBlock {
+        bool has_content = false;
+        cv::Size canvas_size;
+        int subcanvas_count = 0;
+        int active_subcanvas = -1;
+        bool graph_export_current = false;
+        float perf_snapshot[kCanvasPerfSnapshotFloats];
+        int perf_snapshot_floats = 0;
+        float detector_stats[kPersonDetectorStatsFloats];
+        int detector_stats_floats = 0;
+    };
+
+    // Read canvas state BEFORE acquiring the shared mutex.
+    // GetCanvasSize/GetSubCanvasCount/GetActiveSubCanvasIndex each lock
+    // state_mutex_ internally, which the worker thread may hold for
+    // hundreds of ms.  Doing this outside the shared mutex prevents the
+    // client from timing out on every read attempt.
+    CanvasStateBlock ReadCanvasState(WhiteboardCanvas& canvas) const {
+        CanvasStateBlock state;
+        state.has_content = canvas.HasContent();
+        state.canvas_size = state.has_content ? canvas.GetCanvasSize() : cv::Size(0, 0);
+        state.subcanvas_count = state.has_content ? canvas.GetSubCanvasCount() : 0;
+        state.active_subcanvas = state.has_content ? canvas.GetActiveSubCanvasIndex() : -1;
+        state.graph_export_current = GraphExportCurrent(canvas, state.has_content);
+        // Stage timings are published even before the canvas has content so
+        // the debug screen can see why early frames are being gated.
+        state.perf_snapshot_floats =
+            canvas.GetPerfSnapshot(state.perf_snapshot, kCanvasPerfSnapshotFloats);
+        state.detector_stats_floats =
+            PersonDetector::Instance().GetStats(state.detector_stats, kPersonDetectorStatsFloats);
+        return state;
+    }
+
+    void StoreCanvasStateUnsafe(const CanvasStateBlock& state) {
+        shared_->helper_alive = 1;
+        shared_->has_content = state.has_content ? 1 : 0;
+        shared_->canvas_width = state.canvas_size.width;
+        shared_->canvas_height = state.canvas_size.height;
+        shared_->subcanvas_count = state.subcanvas_count;
+        shared_->active_subcanvas = state.active_subcanvas;
+        shared_->graph_export_current = state.graph_export_current ? 1 : 0;
+        if (state.perf_snapshot_floats > 0) {
+            std::memcpy(shared_->perf_snapshot, state.perf_snapshot,
+                        sizeof(float) * state.perf_snapshot_floats);
+        }
+        shared_->perf_snapshot_floats = state.perf_snapshot_floats;
+        if (state.detector_stats_floats > 0) {
+            std::memcpy(shared_->person_detector_stats, state.detector_stats,
+                        sizeof(float) * state.detector_stats_floats);
         }
+        shared_->person_detector_stats_floats = state.detector_stats_floats;
+    }
+
+    void WriteCanvasState(WhiteboardCanvas& canvas) {
+        if (!shared_) return;
+        const CanvasStateBlock state = ReadCanvasState(canvas);
+        if (!WaitAndLock(mutex_.get(), 50)) return;
+        StoreCanvasStateUnsafe(state);
+        Unlock(mutex_.get());
+    }
 
-        // Write graph debug data
-        shared_->graph_node_count = graph_node_count;
-        shared_->graph_node_floats_written = graph_node_floats;
-        shared_->graph_edge_count = graph_edge_count;
-        shared_->graph_contour_floats_written = graph_contour_floats;
-        if (graph_node_floats > 0) {
-            std::memcpy(shared_->graph_nodes, local_graph_nodes,
-                        static_cast<size_t>(graph_node_floats) * sizeof(float));
+    bool WriteOutputs(const cv::Mat& viewport, const cv::Mat& overview) {
+        const bool has_viewport = !viewport.empty() && viewport.isContinuous() &&
+                                  IsValidFrameSize(viewport.cols, viewport.rows);
+        const bool has_overview = !overview.empty() && overview.isContinuous() &&
+                                  IsValidOverviewSize(overview.cols, overview.rows);
+        const size_t viewport_bytes = has_viewport ? FrameBytesForSize(viewport.cols, viewport.rows) : 0;
+        const size_t overview_bytes = has_overview ? FrameBytesForSize(overview.cols, overview.rows) : 0;
+        const size_t overview_offset = kOutputsHeaderBytes + AlignChannelBytes(viewport_bytes);
+        if (!EnsureChannel(outputs_, &shared_->output_channel_generation, kOutputChannelPrefix,
+                           session_id_utf16_, overview_offset + overview_bytes, false)) {
+            return false;
         }
-        if (graph_edge_count > 0) {
-            std::memcpy(shared_->graph_edges, local_graph_edges,
-                        static_cast<size_t>(graph_edge_count) * kGraphEdgeStride * sizeof(int));
+
+        outputs_.BeginWrite();
+        auto* header = reinterpret_cast<OutputsHeader*>(outputs_.payload());
+        header->viewport_width = has_viewport ? viewport.cols : 0;
+        header->viewport_height = has_viewport ? viewport.rows : 0;
+        header->overview_width = has_overview ? overview.cols : 0;
+        header->overview_height = has_overview ? overview.rows : 0;
+        header->overview_offset = static_cast<LONG>(overview_offset);
+        if (has_viewport) {
+            std::memcpy(outputs_.payload() + kOutputsHeaderBytes, viewport.data, viewport_bytes);
         }
-        if (graph_contour_floats > 0) {
-            std::memcpy(shared_->graph_contours, local_graph_contours.data(),
-                        static_cast<size_t>(graph_contour_floats) * sizeof(float));
+        if (has_overview) {
+            std::memcpy(outputs_.payload() + overview_offset, overview.data, overview_bytes);
         }
-        shared_->graph_bounds_valid = graph_bounds_valid ? 1 : 0;
-        if (graph_bounds_valid) {
-            shared_->graph_bounds_x = graph_bounds[0];
-            shared_->graph_bounds_y = graph_bounds[1];
-            shared_->graph_bounds_w = graph_bounds[2];
-            shared_->graph_bounds_h = graph_bounds[3];
+        outputs_.EndWrite();
+        return true;
+    }
+
+    bool GraphExportCurrent(const WhiteboardCanvas& canvas, bool has_content) const {
+        return graph_.IsOpen() && !graph_export_stale_ &&
+               canvas.GetCanvasVersion() == exported_graph_version_ &&
+               has_content == exported_graph_has_content_;
+    }
+
+    void WriteGraphExport(WhiteboardCanvas& canvas, bool has_content) {
+        if (GraphExportCurrent(canvas, has_content)) return;
+        const uint64_t canvas_version = canvas.GetCanvasVersion();
+        int graph_node_count = 0;
+        int graph_node_floats = 0;
+        int graph_edge_count = 0;
+        int graph_contour_floats = 0;
+        int graph_bounds[4] = {0, 0, 0, 0};
+        bool graph_bounds_valid = false;
+        // Heap buffers; the contour buffer alone is 2 MB
+        static thread_local std::vector<float> local_graph_nodes(kMaxGraphNodeFloats);
+        static thread_local std::vector<int> local_graph_edges(kMaxGraphEdgeInts);
+        static thread_local std::vector<float> local_graph_contours(kMaxGraphContourFloats);
+
+        if (has_content) {
+            graph_node_count = canvas.GetGraphNodeCount();
+            if (graph_node_count > 0) {
+                graph_node_floats = canvas.GetGraphNodes(local_graph_nodes.data(), kMaxGraphNodes) * kGraphNodeStride;
+                graph_edge_count = canvas.GetGraphHardEdges(local_graph_edges.data(), kMaxGraphEdges);
+                graph_contour_floats = canvas.GetGraphNodeContours(
+                    local_graph_contours.data(), kMaxGraphContourFloats);
+                graph_bounds_valid = canvas.GetGraphCanvasBounds(graph_bounds);
+            }
         }
 
-        // Write edit command results
-        if (edit_result_ready) {
-            shared_->edit_result_ready = 1;
-            shared_->edit_result_ok = edit_result_ok ? 1 : 0;
-            shared_->edit_result_id = edit_result_id;
+        const size_t node_bytes = static_cast<size_t>(graph_node_floats) * sizeof(float);
+        const size_t edge_bytes = static_cast<size_t>(graph_edge_count) * kGraphEdgeStride * sizeof(int);
+        const size_t contour_bytes = static_cast<size_t>(graph_contour_floats) * sizeof(float);
+        if (!EnsureChannel(graph_, &shared_->graph_channel_generation, kGraphChannelPrefix,
+                           session_id_utf16_,
+                           sizeof(GraphExportHeader) + node_bytes + edge_bytes + contour_bytes,
+                           false)) {
+            return;
         }
 
-        Unlock(mutex_.get());
+        graph_.BeginWrite();
+        auto* header = reinterpret_cast<GraphExportHeader*>(graph_.payload());
+        unsigned char* data = reinterpret_cast<unsigned char*>(header + 1);
+        header->node_count = graph_node_count;
+        header->node_floats = graph_node_floats;
+        header->edge_count = graph_edge_count;
+        header->contour_floats = graph_contour_floats;
+        header->bounds_valid = graph_bounds_valid ? 1 : 0;
+        for (int i = 0; i < 4; ++i) header->bounds[i] = graph_bounds[i];
+        if (node_bytes > 0) std::memcpy(data, local_graph_nodes.data(), node_bytes);
+        if (edge_bytes > 0) std::memcpy(data + node_bytes, local_graph_edges.data(), edge_bytes);
+        if (contour_bytes > 0) {
+            std::memcpy(data + node_bytes + edge_bytes, local_graph_contours.data(), contour_bytes);
+        }
+        graph_.EndWrite();
+        exported_graph_version_ = canvas_version;
+        exported_graph_has_content_ = has_content;
+        graph_export_stale_ = false;
     }
 
     std::string session_id_utf8_;
@@ -673,6 +1299,18 @@ private:
     ScopedHandle mutex_;
     ScopedHandle wake_event_;
     SharedState* shared_ = nullptr;
+    std::shared_ptr<SharedChannel> frames_;
+    SharedChannel outputs_;
+    SharedChannel graph_;
+    SharedChannel changes_;
+    SharedChannel response_;
+    uint64_t written_outputs_version_ = 0;
+    uint64_t exported_graph_version_ = 0;
+    bool exported_graph_has_content_ = false;
+    bool graph_export_stale_ = false;       // edits since the last export
+    std::chrono::steady_clock::time_point last_ring_log_;
+    LONG logged_overwritten_ = 0;
+    LONG logged_discarded_ = 0;
 };
 
 }  // namespace
@@ -696,8 +1334,40 @@ struct WhiteboardCanvasHelperClient::Impl {
     mutable std::atomic<int> next_graph_compare_request_id{1};
     mutable std::atomic<int> next_edit_request_id{1};
     mutable std::atomic<int> next_mask_request_id{1};
+    mutable std::atomic<int> next_graph_export_request_id{1};
+    mutable std::atomic<int> next_graph_changes_request_id{1};
+    // Last values pushed by SyncSettings. The canvas re-syncs on every frame;
+    // unchanged settings must not wake the helper.
+    std::mutex settings_mutex;
+    bool settings_synced = false;
+    bool synced_debug_enabled = false;
+    bool synced_duplicate_debug_enabled = false;
+    float synced_absence_score_seen_threshold = 0.0f;
+    float synced_enhance_threshold = 0.0f;
+    float synced_yolo_fps = 0.0f;
+    int synced_detector_backend = 0;
+    int synced_detector_precision = 0;
+    int synced_detector_threads = 0;
+    // Data channels. Each has its own in-process mutex so that, as across the
+    // process boundary, the traffic classes never wait on each other.
+    std::mutex frames_mutex;            // frames + ring producer state
+    SharedChannel frames;
+    int ring_last_written = -1;
+    LONG ring_next_seq = 2;
+    mutable std::mutex outputs_mutex;
+    mutable SharedChannel outputs;
+    // Outputs at this (generation, seq) predate the last Reset and are hidden.
+    mutable LONG outputs_reset_generation = 0;
+    mutable LONG outputs_reset_seq = -1;
+    mutable std::mutex graph_mutex;
+    mutable SharedChannel graph;
+    mutable std::mutex changes_mutex;
+    mutable SharedChannel changes;
+    mutable std::mutex response_mutex;
+    mutable SharedChannel response;
 
     ~Impl() {
+        CloseChannels();
         if (shared) {
             UnmapViewOfFile(shared);
             shared = nullptr;
@@ -721,6 +1391,74 @@ struct WhiteboardCanvasHelperClient::Impl {
                                       std::memory_order_relaxed);
     }
 
+    void CloseChannels() {
+        {
+            std::lock_guard<std::mutex> lock(frames_mutex);
+            frames.Close();
+            ring_last_written = -1;
+        }
+        {
+            std::lock_guard<std::mutex> lock(outputs_mutex);
+            outputs.Close();
+            outputs_reset_generation = 0;
+            outputs_reset_seq = -1;
+        }
+        {
+            std::lock_guard<std::mutex> lock(graph_mutex);
+            graph.Close();
+        }
+        {
+            std::lock_guard<std::mutex> lock(changes_mutex);
+            changes.Close();
+        }
+        std::lock_guard<std::mutex> lock(response_mutex);
+        response.Close();
+    }
+
+    // Reads the rendered outputs consistently; `read` gets the header, the
+    // payload and its size. Returns false when there is nothing to read.
+    template <typename ReadFn>
+    bool ReadOutputs(ReadFn&& read) const {
+        std::lock_guard<std::mutex> lock(outputs_mutex);
+        if (!SyncChannel(outputs, &shared->output_channel_generation, kOutputChannelPrefix, session_id) ||
+            outputs.payload_bytes() < kOutputsHeaderBytes) {
+            return false;
+        }
+        if (outputs.generation() == outputs_reset_generation &&
+            ReadAcquire(&outputs.header()->seq) == outputs_reset_seq) {
+            return false;
+        }
+        return outputs.ReadConsistent(kImageReadTimeoutMs, [&]() {
+            read(*reinterpret_cast<const OutputsHeader*>(outputs.payload()), outputs.payload(),
+                 outputs.payload_bytes());
+        });
+    }
+
+    // Until the helper publishes outputs after a Reset, the old ones are stale.
+    void HideCurrentOutputs() const {
+        std::lock_guard<std::mutex> lock(outputs_mutex);
+        if (!SyncChannel(outputs, &shared->output_channel_generation, kOutputChannelPrefix, session_id)) {
+            return;
+        }
+        outputs_reset_generation = outputs.generation();
+        outputs_reset_seq = ReadAcquire(&outputs.header()->seq);
+    }
+
+    // Reads the graph export header (and optionally its data) consistently.
+    template <typename ReadFn>
+    bool ReadGraph(DWORD timeout_ms, ReadFn&& read) const {
+        std::lock_guard<std::mutex> lock(graph_mutex);
+        if (!SyncChannel(graph, &shared->graph_channel_generation, kGraphChannelPrefix, session_id) ||
+            graph.payload_bytes() < sizeof(GraphExportHeader)) {
+            return false;
+        }
+        return graph.ReadConsistent(timeout_ms, [&]() {
+            const auto* header = reinterpret_cast<const GraphExportHeader*>(graph.payload());
+            read(*header, reinterpret_cast<const unsigned char*>(header + 1),
+                 graph.payload_bytes() - sizeof(GraphExportHeader));
+        });
+    }
+
     void ResetCachedState() {
         cached_has_content.store(false, std::memory_order_relaxed);
         cached_canvas_view_mode.store(false, std::memory_order_relaxed);
@@ -741,11 +1479,42 @@ struct WhiteboardCanvasHelperClient::Impl {
         return true;
     }
 
-    void SignalHelper() const {
+    void SignalHelper(LONG reasons) const {
+        if (shared) {
+            InterlockedOr(&shared->wake_reasons, reasons);
+        }
         if (wake_event.get()) {
             SetEvent(wake_event.get());
         }
     }
+
+    // Asks the helper to bring the graph channel up to date and waits for the
+    // acknowledgement; skipped when the helper reports the export current.
+    // On timeout the previous export is still readable.
+    void RequestGraphExport() const {
+        const int request_id =
+            next_graph_export_request_id.fetch_add(1, std::memory_order_relaxed);
+        bool current = false;
+        if (!WithLock(20, [&]() {
+                current = shared->graph_export_current != 0;
+                if (!current) shared->graph_export_request_id = request_id;
+            })) {
+            return;
+        }
+        if (current) return;
+        SignalHelper(kWakeGraph);
+
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(kGraphExportTimeoutMs);
+        while (std::chrono::steady_clock::now() < deadline) {
+            bool done = false;
+            WithLock(kStateReadLockTimeoutMs, [&]() {
+                done = shared->graph_export_result_id == request_id;
+            });
+            if (done) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
 };
 
 WhiteboardCanvasHelperClient::WhiteboardCanvasHelperClient()
@@ -801,6 +1570,10 @@ bool WhiteboardCanvasHelperClient::Start() {
     impl_->shared->duplicate_debug_mode = 0;
     impl_->shared->enhance_threshold = 5.0f;
     impl_->shared->yolo_fps = 2.0f;
+    // The helper loads its detector as it starts; give it the config up front.
+    impl_->shared->person_detector_backend = g_person_detector_backend.load();
+    impl_->shared->person_detector_precision = g_person_detector_precision.load();
+    impl_->shared->person_detector_threads = g_person_detector_threads.load();
     impl_->shared->canvas_width = kDefaultCanvasWidth;
     impl_->shared->canvas_height = kDefaultCanvasHeight;
     impl_->ResetCachedState();
@@ -901,7 +1674,7 @@ void WhiteboardCanvasHelperClient::Stop() {
         impl_->WithLock(50, [&]() {
             impl_->shared->shutdown = 1;
         });
-        impl_->SignalHelper();
+        impl_->SignalHelper(kWakeSettings);
     }
 
     if (impl_->process.get()) {
@@ -910,6 +1683,11 @@ void WhiteboardCanvasHelperClient::Stop() {
 
     impl_->ready = false;
     impl_->ResetCachedState();
+    {
+        std::lock_guard<std::mutex> settings_lock(impl_->settings_mutex);
+        impl_->settings_synced = false;
+    }
+    impl_->CloseChannels();
     impl_->thread.reset();
     impl_->process.reset();
     if (impl_->shared) {
@@ -926,94 +1704,173 @@ bool WhiteboardCanvasHelperClient::IsReady() const {
 }
 
 void WhiteboardCanvasHelperClient::ProcessFrame(const cv::Mat& frame, const cv::Mat& person_mask) {
-    if (!IsReady() || frame.empty() || !IsValidFrameSize(frame.cols, frame.rows)) return;
+    if (!IsReady() || frame.empty() || !frame.isContinuous() ||
+        !IsValidFrameSize(frame.cols, frame.rows)) {
+        return;
+    }
 
     const bool has_person_mask =
-        !person_mask.empty() && person_mask.size() == frame.size() &&
-        person_mask.type() == CV_8UC1;
-
-    impl_->WithLock(kFrameSubmitLockTimeoutMs, [&]() {
-        impl_->RefreshCachedStateUnsafe();
-        const size_t frame_bytes = FrameBytesForSize(frame.cols, frame.rows);
-        std::memcpy(impl_->shared->frame_bgr, frame.data, frame_bytes);
-        impl_->shared->frame_width = frame.cols;
-        impl_->shared->frame_height = frame.rows;
-
-        if (has_person_mask) {
-            const size_t mask_bytes = MaskBytesForSize(frame.cols, frame.rows);
-            std::memcpy(impl_->shared->person_mask, person_mask.data, mask_bytes);
-            impl_->shared->mask_width = person_mask.cols;
-            impl_->shared->mask_height = person_mask.rows;
-        } else {
-            impl_->shared->mask_width = 0;
-            impl_->shared->mask_height = 0;
+        !person_mask.empty() && person_mask.isContinuous() &&
+        person_mask.size() == frame.size() && person_mask.type() == CV_8UC1;
+    SharedState* shared = impl_->shared;
+    std::lock_guard<std::mutex> frames_lock(impl_->frames_mutex);
+
+    // The ring is sized to the frame resolution; a new resolution gets a new
+    // generation, and the helper follows once it sees it published.
+    SharedChannel& frames = impl_->frames;
+    if (!frames.IsOpen() || FrameRing(frames)->frame_width != frame.cols ||
+        FrameRing(frames)->frame_height != frame.rows) {
+        const size_t slot_bytes = FrameSlotBytesForSize(frame.cols, frame.rows);
+        const LONG generation = ReadAcquire(&shared->frame_channel_generation) + 1;
+        if (!frames.Create(MakeChannelName(kFrameChannelPrefix, impl_->session_id, generation),
+                           generation, sizeof(FrameRingHeader) + kFrameRingSlots * slot_bytes)) {
+            return;
         }
+        FrameRingHeader* ring = FrameRing(frames);
+        ring->latest_slot = -1;
+        ring->reader_slots = 0;
+        ring->frame_width = frame.cols;
+        ring->frame_height = frame.rows;
+        ring->slot_bytes = static_cast<LONG>(slot_bytes);
+        impl_->ring_last_written = -1;
+        InterlockedExchange(&shared->frame_channel_generation, generation);
+    }
+    FrameRingHeader* ring = FrameRing(frames);
+
+    // Never write the slot published last (the helper may claim it any moment)
+    // or one the helper holds.
+    const LONG reader_slots = ReadAcquire(&ring->reader_slots);
+    int slot_index = -1;
+    for (int step = 1; step <= kFrameRingSlots; step++) {
+        const int candidate = (impl_->ring_last_written + step + kFrameRingSlots) % kFrameRingSlots;
+        if (candidate != impl_->ring_last_written && (reader_slots & (1 << candidate)) == 0) {
+            slot_index = candidate;
+            break;
+        }
+    }
+    // Every other slot is held: take back the last published frame if the
+    // helper has not claimed it yet (it is being replaced anyway).
+    if (slot_index < 0 && impl_->ring_last_written >= 0 &&
+        InterlockedCompareExchange(&ring->latest_slot, -1, impl_->ring_last_written) ==
+            impl_->ring_last_written) {
+        slot_index = impl_->ring_last_written;
+        InterlockedIncrement(&shared->ring_overwritten);
+    }
+    if (slot_index < 0) return;
+
+    FrameSlotHeader* slot = FrameRingSlot(frames, slot_index);
+    unsigned char* frame_data = reinterpret_cast<unsigned char*>(slot + 1);
+    const size_t frame_bytes = FrameBytesForSize(frame.cols, frame.rows);
+    const LONG seq = impl_->ring_next_seq;
+    impl_->ring_next_seq = seq + 2 > 0 ? seq + 2 : 2;
+    InterlockedExchange(&slot->seq, seq - 1);
+    std::memcpy(frame_data, frame.data, frame_bytes);
+    if (has_person_mask) {
+        std::memcpy(frame_data + frame_bytes, person_mask.data, MaskBytesForSize(frame.cols, frame.rows));
+    }
+    slot->has_mask = has_person_mask ? 1 : 0;
+    WriteRelease(&slot->seq, seq);
 
-        impl_->shared->frame_available = 1;
-    });
-    impl_->SignalHelper();
+    impl_->ring_last_written = slot_index;
+    const LONG replaced = InterlockedExchange(&ring->latest_slot, slot_index);
+    InterlockedIncrement(&shared->ring_submitted);
+    if (replaced >= 0) InterlockedIncrement(&shared->ring_overwritten);
+
+    // Cached canvas state is refreshed opportunistically; never wait for it.
+    impl_->WithLock(0, [&]() { impl_->RefreshCachedStateUnsafe(); });
+    impl_->SignalHelper(kWakeFrame);
+}
+
+int WhiteboardCanvasHelperClient::GetFrameRingStats(float* buffer, int max_floats) const {
+    if (!IsReady() || !buffer || max_floats < kCanvasFrameRingStatsFloats) return 0;
+    SharedState* shared = impl_->shared;
+    bool pending = false;
+    {
+        std::lock_guard<std::mutex> frames_lock(impl_->frames_mutex);
+        pending = impl_->frames.IsOpen() && ReadAcquire(&FrameRing(impl_->frames)->latest_slot) >= 0;
+    }
+    buffer[0] = static_cast<float>(kCanvasFrameRingStatsVersion);
+    buffer[1] = static_cast<float>(kFrameRingSlots);
+    buffer[2] = static_cast<float>(ReadAcquire(&shared->ring_submitted));
+    buffer[3] = static_cast<float>(ReadAcquire(&shared->ring_consumed));
+    buffer[4] = static_cast<float>(ReadAcquire(&shared->ring_overwritten));
+    buffer[5] = static_cast<float>(ReadAcquire(&shared->ring_discarded));
+    buffer[6] = pending ? 1.0f : 0.0f;
+    buffer[7] = static_cast<float>(ReadAcquire(&shared->ring_last_consumed_seq) / 2);
+    return kCanvasFrameRingStatsFloats;
+}
+
+// Resizes (or copies) the BGR image at `data` into out_frame. Returns false
+// when the stored geometry does not fit the channel payload (torn header).
+static bool CopyChannelImage(const unsigned char* data, size_t available, int width, int height,
+                             cv::Size view_size, cv::Mat& out_frame) {
+    if (width <= 0 || height <= 0 || FrameBytesForSize(width, height) > available) return false;
+    const cv::Mat source(height, width, CV_8UC3, const_cast<unsigned char*>(data));
+    if (width == view_size.width && height == view_size.height) {
+        source.copyTo(out_frame);
+    } else {
+        cv::resize(source, out_frame, view_size, 0, 0, cv::INTER_LINEAR);
+    }
+    return true;
 }
 
 bool WhiteboardCanvasHelperClient::GetViewport(float panX, float panY, float zoom,
                                                cv::Size viewSize, cv::Mat& out_frame) {
     if (!IsReady() || !IsValidFrameSize(viewSize.width, viewSize.height)) return false;
 
-    bool success = false;
-    impl_->WithLock(kImageReadLockTimeoutMs, [&]() {
+    impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
         impl_->RefreshCachedStateUnsafe();
         impl_->shared->pan_x = panX;
         impl_->shared->pan_y = panY;
         impl_->shared->zoom = zoom;
         impl_->shared->viewport_req_width = viewSize.width;
         impl_->shared->viewport_req_height = viewSize.height;
+    });
+    impl_->SignalHelper(kWakeViewport);
 
-        int source_width = impl_->shared->viewport_width;
-        int source_height = impl_->shared->viewport_height;
-        const unsigned char* source_buffer = impl_->shared->viewport_bgr;
-        if (source_width <= 0 || source_height <= 0) {
-            source_width = impl_->shared->overview_width;
-            source_height = impl_->shared->overview_height;
-            source_buffer = impl_->shared->overview_bgr;
-        }
-
-        if (IsValidFrameSize(source_width, source_height)) {
-            cv::Mat source(source_height, source_width, CV_8UC3,
-                           const_cast<unsigned char*>(source_buffer));
-            if (source_width == viewSize.width && source_height == viewSize.height) {
-                source.copyTo(out_frame);
-            } else {
-                cv::resize(source, out_frame, viewSize, 0, 0, cv::INTER_LINEAR);
-            }
-            success = true;
+    bool success = false;
+    cv::Mat frame;
+    impl_->ReadOutputs([&](const OutputsHeader& header, const unsigned char* payload, size_t bytes) {
+        success = false;
+        if (IsValidFrameSize(header.viewport_width, header.viewport_height)) {
+            success = CopyChannelImage(payload + kOutputsHeaderBytes, bytes - kOutputsHeaderBytes,
+                                       header.viewport_width, header.viewport_height,
+                                       viewSize, frame);
+        } else if (IsValidFrameSize(header.overview_width, header.overview_height) &&
+                   header.overview_offset >= static_cast<LONG>(kOutputsHeaderBytes) &&
+                   static_cast<size_t>(header.overview_offset) <= bytes) {
+            success = CopyChannelImage(payload + header.overview_offset, bytes - header.overview_offset,
+                                       header.overview_width, header.overview_height,
+                                       viewSize, frame);
         }
     });
-    impl_->SignalHelper();
+    if (success) out_frame = frame;
     return success;
 }
 
 bool WhiteboardCanvasHelperClient::GetOverview(cv::Size viewSize, cv::Mat& out_frame) {
     if (!IsReady() || viewSize.width <= 0 || viewSize.height <= 0) return false;
 
-    bool success = false;
-    impl_->WithLock(kImageReadLockTimeoutMs, [&]() {
+    impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
         impl_->RefreshCachedStateUnsafe();
         impl_->shared->overview_req_width = viewSize.width;
         impl_->shared->overview_req_height = viewSize.height;
+    });
+    impl_->SignalHelper(kWakeOverview);
 
-        const int source_width = impl_->shared->overview_width;
-        const int source_height = impl_->shared->overview_height;
-        if (IsValidOverviewSize(source_width, source_height)) {
-            cv::Mat source(source_height, source_width, CV_8UC3,
-                           impl_->shared->overview_bgr);
-            if (source_width == viewSize.width && source_height == viewSize.height) {
-                source.copyTo(out_frame);
-            } else {
-                cv::resize(source, out_frame, viewSize, 0, 0, cv::INTER_LINEAR);
-            }
-            success = true;
+    bool success = false;
+    cv::Mat frame;
+    impl_->ReadOutputs([&](const OutputsHeader& header, const unsigned char* payload, size_t bytes) {
+        success = false;
+        if (IsValidOverviewSize(header.overview_width, header.overview_height) &&
+            header.overview_offset >= static_cast<LONG>(kOutputsHeaderBytes) &&
+            static_cast<size_t>(header.overview_offset) <= bytes) {
+            success = CopyChannelImage(payload + header.overview_offset, bytes - header.overview_offset,
+                                       header.overview_width, header.overview_height,
+                                       viewSize, frame);
         }
     });
-    impl_->SignalHelper();
+    if (success) out_frame = frame;
     return success;
 }
 
@@ -1022,13 +1879,16 @@ void WhiteboardCanvasHelperClient::Reset() {
     impl_->ResetCachedState();
     impl_->WithLock(20, [&]() {
         impl_->shared->reset_requested = 1;
-        impl_->shared->viewport_width = 0;
-        impl_->shared->viewport_height = 0;
-        impl_->shared->overview_width = 0;
-        impl_->shared->overview_height = 0;
         impl_->shared->has_content = 0;
     });
-    impl_->SignalHelper();
+    impl_->HideCurrentOutputs();
+    impl_->SignalHelper(kWakeSettings);
+}
+
+void WhiteboardCanvasHelperClient::ResetPersonMask() {
+    if (!IsReady()) return;
+    if (!impl_->WithLock(20, [&]() { impl_->shared->person_mask_reset_requested = 1; })) return;
+    impl_->SignalHelper(kWakeSettings);
 }
 
 bool WhiteboardCanvasHelperClient::HasContent() const {
@@ -1051,7 +1911,7 @@ void WhiteboardCanvasHelperClient::SetCanvasViewMode(bool mode) {
         impl_->shared->canvas_view_mode = mode ? 1 : 0;
         impl_->RefreshCachedStateUnsafe();
     });
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeSettings);
 }
 
 void WhiteboardCanvasHelperClient::SetRenderMode(CanvasRenderMode mode) {
@@ -1061,7 +1921,7 @@ void WhiteboardCanvasHelperClient::SetRenderMode(CanvasRenderMode mode) {
         impl_->shared->render_mode = static_cast<LONG>(mode);
         impl_->RefreshCachedStateUnsafe();
     });
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeSettings);
 }
 
 CanvasRenderMode WhiteboardCanvasHelperClient::GetRenderMode() const {
@@ -1103,7 +1963,7 @@ void WhiteboardCanvasHelperClient::SetActiveSubCanvas(int idx) {
     impl_->WithLock(20, [&]() {
         impl_->shared->pending_active_subcanvas = idx;
     });
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeSettings);
 }
 
 int WhiteboardCanvasHelperClient::GetSortedSubCanvasIndex(int pos) const {
@@ -1118,24 +1978,81 @@ void WhiteboardCanvasHelperClient::SyncSettings(bool debug_enabled,
                                                 bool duplicate_debug_enabled,
                                                 float absence_score_seen_threshold,
                                                 float enhance_threshold,
-                                                float yolo_fps) {
+                                                float yolo_fps,
+                                                int detector_backend,
+                                                int detector_precision,
+                                                int detector_threads) {
     if (!IsReady()) return;
-    impl_->WithLock(20, [&]() {
+    std::lock_guard<std::mutex> settings_lock(impl_->settings_mutex);
+    if (impl_->settings_synced &&
+        impl_->synced_debug_enabled == debug_enabled &&
+        impl_->synced_duplicate_debug_enabled == duplicate_debug_enabled &&
+        impl_->synced_absence_score_seen_threshold == absence_score_seen_threshold &&
+        impl_->synced_enhance_threshold == enhance_threshold &&
+        impl_->synced_yolo_fps == yolo_fps &&
+        impl_->synced_detector_backend == detector_backend &&
+        impl_->synced_detector_precision == detector_precision &&
+        impl_->synced_detector_threads == detector_threads) {
+        return;
+    }
+    const bool written = impl_->WithLock(20, [&]() {
         impl_->shared->whiteboard_debug = debug_enabled ? 1 : 0;
         impl_->shared->duplicate_debug_mode = duplicate_debug_enabled ? 1 : 0;
         impl_->shared->absence_score_seen_threshold = absence_score_seen_threshold;
         impl_->shared->enhance_threshold = enhance_threshold;
         impl_->shared->yolo_fps = yolo_fps;
+        impl_->shared->person_detector_backend = detector_backend;
+        impl_->shared->person_detector_precision = detector_precision;
+        impl_->shared->person_detector_threads = detector_threads;
         impl_->RefreshCachedStateUnsafe();
     });
-    impl_->SignalHelper();
+    if (!written) return;
+    impl_->settings_synced = true;
+    impl_->synced_debug_enabled = debug_enabled;
+    impl_->synced_duplicate_debug_enabled = duplicate_debug_enabled;
+    impl_->synced_absence_score_seen_threshold = absence_score_seen_threshold;
+    impl_->synced_enhance_threshold = enhance_threshold;
+    impl_->synced_yolo_fps = yolo_fps;
+    impl_->synced_detector_backend = detector_backend;
+    impl_->synced_detector_precision = detector_precision;
+    impl_->synced_detector_threads = detector_threads;
+    impl_->SignalHelper(kWakeSettings);
+}
+
+// Byte offsets of the graph export sections after the header. Counts from a
+// torn or foreign header are clamped so reads never leave the payload.
+struct GraphExportSections {
+    size_t node_bytes = 0;
+    size_t edge_offset = 0;
+    size_t edge_bytes = 0;
+    size_t contour_offset = 0;
+    size_t contour_bytes = 0;
+};
+
+static GraphExportSections GetGraphExportSections(const GraphExportHeader& header, size_t data_bytes) {
+    GraphExportSections sections;
+    sections.node_bytes = std::min(data_bytes,
+        static_cast<size_t>(std::max<LONG>(0, header.node_floats)) * sizeof(float));
+    sections.edge_offset = sections.node_bytes;
+    sections.edge_bytes = std::min(data_bytes - sections.edge_offset,
+        static_cast<size_t>(std::max<LONG>(0, header.edge_count)) * kGraphEdgeStride * sizeof(int));
+    sections.contour_offset = sections.edge_offset + sections.edge_bytes;
+    sections.contour_bytes = std::min(data_bytes - sections.contour_offset,
+        static_cast<size_t>(std::max<LONG>(0, header.contour_floats)) * sizeof(float));
+    return sections;
+}
+
+void WhiteboardCanvasHelperClient::RefreshGraphExport() {
+    if (!IsReady()) return;
+    impl_->RequestGraphExport();
 }
 
 int WhiteboardCanvasHelperClient::GetGraphNodeCount() const {
     if (!IsReady()) return 0;
     int count = 0;
-    impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
-        count = static_cast<int>(impl_->shared->graph_node_count);
+    impl_->ReadGraph(kStateReadLockTimeoutMs, [&](const GraphExportHeader& header,
+                                                  const unsigned char*, size_t) {
+        count = static_cast<int>(header.node_count);
     });
     return count;
 }
@@ -1143,13 +2060,14 @@ int WhiteboardCanvasHelperClient::GetGraphNodeCount() const {
 int WhiteboardCanvasHelperClient::GetGraphNodes(float* buffer, int max_nodes) const {
     if (!IsReady() || !buffer || max_nodes <= 0) return 0;
     int count = 0;
-    impl_->WithLock(kImageReadLockTimeoutMs, [&]() {
-        const int total_floats = static_cast<int>(impl_->shared->graph_node_floats_written);
-        const int available_nodes = total_floats / kGraphNodeStride;
+    impl_->ReadGraph(kImageReadTimeoutMs, [&](const GraphExportHeader& header,
+                                              const unsigned char* data, size_t data_bytes) {
+        const GraphExportSections sections = GetGraphExportSections(header, data_bytes);
+        const int available_nodes =
+            static_cast<int>(sections.node_bytes / (kGraphNodeStride * sizeof(float)));
         count = std::min(available_nodes, max_nodes);
         if (count > 0) {
-            std::memcpy(buffer, impl_->shared->graph_nodes,
-                        static_cast<size_t>(count) * kGraphNodeStride * sizeof(float));
+            std::memcpy(buffer, data, static_cast<size_t>(count) * kGraphNodeStride * sizeof(float));
         }
     });
     return count;
@@ -1158,11 +2076,14 @@ int WhiteboardCanvasHelperClient::GetGraphNodes(float* buffer, int max_nodes) co
 int WhiteboardCanvasHelperClient::GetGraphHardEdges(int* buffer, int max_edges) const {
     if (!IsReady() || !buffer || max_edges <= 0) return 0;
     int count = 0;
-    impl_->WithLock(kImageReadLockTimeoutMs, [&]() {
-        const int available_edges = static_cast<int>(impl_->shared->graph_edge_count);
+    impl_->ReadGraph(kImageReadTimeoutMs, [&](const GraphExportHeader& header,
+                                              const unsigned char* data, size_t data_bytes) {
+        const GraphExportSections sections = GetGraphExportSections(header, data_bytes);
+        const int available_edges =
+            static_cast<int>(sections.edge_bytes / (kGraphEdgeStride * sizeof(int)));
         count = std::min(available_edges, max_edges);
         if (count > 0) {
-            std::memcpy(buffer, impl_->shared->graph_edges,
+            std::memcpy(buffer, data + sections.edge_offset,
                         static_cast<size_t>(count) * kGraphEdgeStride * sizeof(int));
         }
     });
@@ -1172,11 +2093,13 @@ int WhiteboardCanvasHelperClient::GetGraphHardEdges(int* buffer, int max_edges)
 int WhiteboardCanvasHelperClient::GetGraphNodeContours(float* buffer, int max_floats) const {
     if (!IsReady() || !buffer || max_floats <= 0) return 0;
     int written = 0;
-    impl_->WithLock(kImageReadLockTimeoutMs, [&]() {
-        const int available = static_cast<int>(impl_->shared->graph_contour_floats_written);
+    impl_->ReadGraph(kImageReadTimeoutMs, [&](const GraphExportHeader& header,
+                                              const unsigned char* data, size_t data_bytes) {
+        const GraphExportSections sections = GetGraphExportSections(header, data_bytes);
+        const int available = static_cast<int>(sections.contour_bytes / sizeof(float));
         written = std::min(available, max_floats);
         if (written > 0) {
-            std::memcpy(buffer, impl_->shared->graph_contours,
+            std::memcpy(buffer, data + sections.contour_offset,
                         static_cast<size_t>(written) * sizeof(float));
         }
     });
@@ -1186,18 +2109,72 @@ int WhiteboardCanvasHelperClient::GetGraphNodeContours(float* buffer, int max_fl
 bool WhiteboardCanvasHelperClient::GetGraphCanvasBounds(int* bounds) const {
     if (!IsReady() || !bounds) return false;
     bool valid = false;
-    impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
-        valid = impl_->shared->graph_bounds_valid != 0;
+    impl_->ReadGraph(kStateReadLockTimeoutMs, [&](const GraphExportHeader& header,
+                                                  const unsigned char*, size_t) {
+        valid = header.bounds_valid != 0;
         if (valid) {
-            bounds[0] = static_cast<int>(impl_->shared->graph_bounds_x);
-            bounds[1] = static_cast<int>(impl_->shared->graph_bounds_y);
-            bounds[2] = static_cast<int>(impl_->shared->graph_bounds_w);
-            bounds[3] = static_cast<int>(impl_->shared->graph_bounds_h);
+            for (int i = 0; i < 4; ++i) bounds[i] = static_cast<int>(header.bounds[i]);
         }
     });
     return valid;
 }
 
+int WhiteboardCanvasHelperClient::GetGraphChanges(int since_version, float* buffer,
+                                                  int max_floats) const {
+    if (!IsReady() || !buffer || max_floats <= 0) return 0;
+
+    const int request_id =
+        impl_->next_graph_changes_request_id.fetch_add(1, std::memory_order_relaxed);
+    const bool queued = impl_->WithLock(20, [&]() {
+        impl_->shared->graph_changes_since = since_version;
+        impl_->shared->graph_changes_max_floats = std::min(max_floats, kMaxGraphChangeFloats);
+        impl_->shared->graph_changes_request_id = request_id;
+    });
+    if (!queued) return 0;
+
+    impl_->SignalHelper(kWakeGraph);
+
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(kGraphExportTimeoutMs);
+    while (std::chrono::steady_clock::now() < deadline) {
+        bool ready = false;
+        impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
+            ready = impl_->shared->graph_changes_result_id == request_id;
+        });
+
+        if (ready) {
+            int floats_written = 0;
+            std::lock_guard<std::mutex> lock(impl_->changes_mutex);
+            if (!SyncChannel(impl_->changes, &impl_->shared->changes_channel_generation,
+                             kChangesChannelPrefix, impl_->session_id) ||
+                impl_->changes.payload_bytes() < sizeof(GraphChangesHeader)) {
+                return 0;
+            }
+            // A torn change set would be applied as real events; drop it.
+            const bool consistent = impl_->changes.ReadConsistent(kImageReadTimeoutMs, [&]() {
+                const auto* header =
+                    reinterpret_cast<const GraphChangesHeader*>(impl_->changes.payload());
+                const size_t available =
+                    (impl_->changes.payload_bytes() - sizeof(GraphChangesHeader)) / sizeof(float);
+                floats_written = 0;
+                // A set cut short would drop events, so it is taken whole or not at all.
+                if (header->request_id == request_id && header->floats > 0 &&
+                    header->floats <= max_floats &&
+                    static_cast<size_t>(header->floats) <= available) {
+                    floats_written = static_cast<int>(header->floats);
+                    std::memcpy(buffer, header + 1,
+                                static_cast<size_t>(floats_written) * sizeof(float));
+                }
+            });
+            return consistent ? floats_written : 0;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    return 0;
+}
+
 bool WhiteboardCanvasHelperClient::CompareGraphNodes(int id_a, int id_b, float* result) const {
     if (!IsReady() || !result) return false;
 
@@ -1213,7 +2190,7 @@ bool WhiteboardCanvasHelperClient::CompareGraphNodes(int id_a, int id_b, float*
     });
     if (!queued) return false;
 
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeGraph);
 
     const auto deadline = std::chrono::steady_clock::now() +
                           std::chrono::milliseconds(kGraphCompareTimeoutMs);
@@ -1248,6 +2225,30 @@ bool WhiteboardCanvasHelperClient::CompareGraphNodes(int id_a, int id_b, float*
     return false;
 }
 
+int WhiteboardCanvasHelperClient::GetPerfSnapshot(float* buffer, int max_floats) const {
+    if (!IsReady() || !buffer || max_floats <= 0) return 0;
+    int written = 0;
+    impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
+        const int available = static_cast<int>(impl_->shared->perf_snapshot_floats);
+        if (available <= 0 || available > max_floats) return;
+        std::memcpy(buffer, impl_->shared->perf_snapshot, sizeof(float) * available);
+        written = available;
+    });
+    return written;
+}
+
+int WhiteboardCanvasHelperClient::GetPersonDetectorStats(float* buffer, int max_floats) const {
+    if (!IsReady() || !buffer || max_floats <= 0) return 0;
+    int written = 0;
+    impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
+        const int available = static_cast<int>(impl_->shared->person_detector_stats_floats);
+        if (available <= 0 || available > max_floats) return;
+        std::memcpy(buffer, impl_->shared->person_detector_stats, sizeof(float) * available);
+        written = available;
+    });
+    return written;
+}
+
 int WhiteboardCanvasHelperClient::LockAllGraphNodes() {
     if (!IsReady()) return 0;
 
@@ -1264,7 +2265,7 @@ int WhiteboardCanvasHelperClient::LockAllGraphNodes() {
     });
     if (!queued) return 0;
 
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeEdit);
 
     const auto deadline = std::chrono::steady_clock::now() +
                           std::chrono::milliseconds(kEditCommandTimeoutMs);
@@ -1283,8 +2284,10 @@ int WhiteboardCanvasHelperClient::LockAllGraphNodes() {
         if (ready) {
             // Return node count from shared state as approximation
             int count = 0;
-            impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
-                count = static_cast<int>(impl_->shared->graph_node_count);
+            impl_->RequestGraphExport();
+            impl_->ReadGraph(kStateReadLockTimeoutMs, [&](const GraphExportHeader& header,
+                                                          const unsigned char*, size_t) {
+                count = static_cast<int>(header.node_count);
             });
             return ok ? count : 0;
         }
@@ -1321,7 +2324,7 @@ bool WhiteboardCanvasHelperClient::ApplyUserEdits(const int* delete_ids, int del
     });
     if (!queued) return false;
 
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeEdit);
 
     const auto deadline = std::chrono::steady_clock::now() +
                           std::chrono::milliseconds(kEditCommandTimeoutMs);
@@ -1356,33 +2359,44 @@ int WhiteboardCanvasHelperClient::GetGraphNodeMasks(uint8_t* buffer, int max_byt
         impl_->shared->mask_request_id = request_id;
         impl_->shared->mask_result_ready = 0;
         impl_->shared->mask_result_id = 0;
-        impl_->shared->mask_result_bytes = 0;
     });
     if (!queued) return 0;
 
-    impl_->SignalHelper();
+    impl_->SignalHelper(kWakeGraph);
 
     const auto deadline = std::chrono::steady_clock::now() +
                           std::chrono::milliseconds(kMaskRequestTimeoutMs);
     while (std::chrono::steady_clock::now() < deadline) {
         bool ready = false;
-        int bytes_written = 0;
-
         impl_->WithLock(kStateReadLockTimeoutMs, [&]() {
             ready = impl_->shared->mask_result_ready != 0 &&
                     impl_->shared->mask_result_id == request_id;
-            if (ready) {
-                bytes_written = static_cast<int>(impl_->shared->mask_result_bytes);
-                if (bytes_written > 0) {
-                    const int copy_bytes = std::min(bytes_written, max_bytes);
-                    std::memcpy(buffer, impl_->shared->mask_data, copy_bytes);
-                    bytes_written = copy_bytes;
-                }
-            }
         });
 
         if (ready) {
-            return bytes_written;
+            // The payload was published before the ready flag; the response
+            // channel header says which request it answers.
+            int bytes_written = 0;
+            std::lock_guard<std::mutex> lock(impl_->response_mutex);
+            if (!SyncChannel(impl_->response, &impl_->shared->response_channel_generation,
+                             kResponseChannelPrefix, impl_->session_id) ||
+                impl_->response.payload_bytes() < sizeof(MaskResponseHeader)) {
+                return 0;
+            }
+            // A read the helper kept overwriting may have copied a torn payload.
+            const bool consistent = impl_->response.ReadConsistent(kImageReadTimeoutMs, [&]() {
+                const auto* header =
+                    reinterpret_cast<const MaskResponseHeader*>(impl_->response.payload());
+                const size_t available =
+                    impl_->response.payload_bytes() - sizeof(MaskResponseHeader);
+                bytes_written = 0;
+                if (header->request_id == request_id && header->bytes > 0) {
+                    bytes_written = static_cast<int>(std::min<size_t>(
+                        {static_cast<size_t>(header->bytes), available, static_cast<size_t>(max_bytes)}));
+                    std::memcpy(buffer, header + 1, bytes_written);
+                }
+            });
+            return consistent ? bytes_written : 0;
         }
 
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -1402,6 +2416,7 @@ bool IsWhiteboardCanvasHelperProcess() {
 
 int RunWhiteboardCanvasHelperMain(const std::string& session_id) {
     SetWhiteboardCanvasHelperProcessMode(true, session_id);
+    // The server starts the helper's own detector once it has the client's config.
     WhiteboardHelperServer server(session_id);
     return server.Run();
 }
@@ -7,6 +7,21 @@
 class WhiteboardCanvas;
 enum class CanvasRenderMode : int;
 
+// ---------------------------------------------------------------------------
+// Frame ring stats layout (floats) written by GetFrameRingStats:
+//
+//   [0] layout version
+//   [1] ring slots
+//   [2] frames submitted by the client
+//   [3] frames taken by the helper
+//   [4] frames overwritten before the helper took them
+//   [5] frames the helper discarded because the slot was incomplete
+//   [6] 1 while a submitted frame waits for the helper
+//   [7] id of the last frame the helper took
+// ---------------------------------------------------------------------------
+static constexpr int kCanvasFrameRingStatsVersion = 1;
+static constexpr int kCanvasFrameRingStatsFloats = 8;
+
 class WhiteboardCanvasHelperClient {
 public:
     WhiteboardCanvasHelperClient();
@@ -21,6 +36,8 @@ public:
                      cv::Size viewSize, cv::Mat& out_frame);
     bool GetOverview(cv::Size viewSize, cv::Mat& out_frame);
     void Reset();
+    // Drops the helper's person mask, e.g. when the host's camera restarts.
+    void ResetPersonMask();
     bool HasContent() const;
     bool IsCanvasViewMode() const;
     void SetCanvasViewMode(bool mode);
@@ -36,17 +53,33 @@ public:
                       bool duplicate_debug_enabled,
                       float absence_score_seen_threshold,
                       float enhance_threshold,
-                      float yolo_fps);
+                      float yolo_fps,
+                      int detector_backend,
+                      int detector_precision,
+                      int detector_threads);
 
-    // Graph debug methods (read from shared memory written by helper process)
+    // Graph debug methods (read from shared memory written by helper process).
+    // The getters read the last export; RefreshGraphExport asks for a new one
+    // unless the helper reports it current.
+    void RefreshGraphExport();
     int GetGraphNodeCount() const;
     int GetGraphNodes(float* buffer, int max_nodes) const;
     int GetGraphHardEdges(int* buffer, int max_edges) const;
     int GetGraphNodeContours(float* buffer, int max_floats) const;
+    int GetGraphChanges(int since_version, float* buffer, int max_floats) const;
     bool GetGraphCanvasBounds(int* bounds) const;
     bool CompareGraphNodes(int id_a, int id_b, float* result) const;
     int  GetGraphNodeMasks(uint8_t* buffer, int max_bytes) const;
 
+    // Worker stage timings (snapshot published by the helper with each result)
+    int GetPerfSnapshot(float* buffer, int max_floats) const;
+
+    // Submit/drop counters of the client -> helper frame ring (layout above)
+    int GetFrameRingStats(float* buffer, int max_floats) const;
+
+    // Stats of the helper's person detector (PersonDetector::GetStats layout)
+    int GetPersonDetectorStats(float* buffer, int max_floats) const;
+
     // User edit commands (routed through shared memory to helper process)
     int LockAllGraphNodes();
     bool ApplyUserEdits(const int* delete_ids, int delete_count,
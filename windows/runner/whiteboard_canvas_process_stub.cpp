@@ -0,0 +1,80 @@
+// ============================================================================
+// whiteboard_canvas_process_stub.cpp -- Helper-process client for non-Win32
+//
+// The out-of-process canvas relies on Win32 shared memory, named mutexes and
+// CreateProcess. On other platforms (headless builds, replay bench) the client
+// never starts, so WhiteboardCanvas falls back to its in-process worker.
+// ============================================================================
+
+#include "whiteboard_canvas_process.h"
+
+#include "whiteboard_canvas.h"
+
+namespace {
+
+bool g_is_helper_process = false;
+
+}  // namespace
+
+struct WhiteboardCanvasHelperClient::Impl {};
+
+WhiteboardCanvasHelperClient::WhiteboardCanvasHelperClient()
+    : impl_(std::make_unique<Impl>()) {}
+
+WhiteboardCanvasHelperClient::~WhiteboardCanvasHelperClient() = default;
+
+bool WhiteboardCanvasHelperClient::Start() { return false; }
+void WhiteboardCanvasHelperClient::Stop() {}
+bool WhiteboardCanvasHelperClient::IsReady() const { return false; }
+void WhiteboardCanvasHelperClient::ProcessFrame(const cv::Mat&, const cv::Mat&) {}
+bool WhiteboardCanvasHelperClient::GetViewport(float, float, float, cv::Size, cv::Mat&) {
+    return false;
+}
+bool WhiteboardCanvasHelperClient::GetOverview(cv::Size, cv::Mat&) { return false; }
+void WhiteboardCanvasHelperClient::Reset() {}
+void WhiteboardCanvasHelperClient::ResetPersonMask() {}
+bool WhiteboardCanvasHelperClient::HasContent() const { return false; }
+bool WhiteboardCanvasHelperClient::IsCanvasViewMode() const { return false; }
+void WhiteboardCanvasHelperClient::SetCanvasViewMode(bool) {}
+void WhiteboardCanvasHelperClient::SetRenderMode(CanvasRenderMode) {}
+CanvasRenderMode WhiteboardCanvasHelperClient::GetRenderMode() const {
+    return CanvasRenderMode::kStroke;
+}
+cv::Size WhiteboardCanvasHelperClient::GetCanvasSize() const { return cv::Size(); }
+int WhiteboardCanvasHelperClient::GetSubCanvasCount() const { return 0; }
+int WhiteboardCanvasHelperClient::GetActiveSubCanvasIndex() const { return -1; }
+void WhiteboardCanvasHelperClient::SetActiveSubCanvas(int) {}
+int WhiteboardCanvasHelperClient::GetSortedSubCanvasIndex(int) const { return -1; }
+int WhiteboardCanvasHelperClient::GetSortedPosition(int) const { return -1; }
+void WhiteboardCanvasHelperClient::SyncSettings(bool, bool, float, float, float,
+                                                int, int, int) {}
+
+void WhiteboardCanvasHelperClient::RefreshGraphExport() {}
+int WhiteboardCanvasHelperClient::GetGraphNodeCount() const { return 0; }
+int WhiteboardCanvasHelperClient::GetGraphNodes(float*, int) const { return 0; }
+int WhiteboardCanvasHelperClient::GetGraphHardEdges(int*, int) const { return 0; }
+int WhiteboardCanvasHelperClient::GetGraphNodeContours(float*, int) const { return 0; }
+int WhiteboardCanvasHelperClient::GetGraphChanges(int, float*, int) const { return 0; }
+bool WhiteboardCanvasHelperClient::GetGraphCanvasBounds(int*) const { return false; }
+bool WhiteboardCanvasHelperClient::CompareGraphNodes(int, int, float*) const { return false; }
+int WhiteboardCanvasHelperClient::GetGraphNodeMasks(uint8_t*, int) const { return 0; }
+int WhiteboardCanvasHelperClient::GetPerfSnapshot(float*, int) const { return 0; }
+int WhiteboardCanvasHelperClient::GetFrameRingStats(float*, int) const { return 0; }
+int WhiteboardCanvasHelperClient::GetPersonDetectorStats(float*, int) const { return 0; }
+
+int WhiteboardCanvasHelperClient::LockAllGraphNodes() { return 0; }
+bool WhiteboardCanvasHelperClient::ApplyUserEdits(const int*, int, const float*, int) {
+    return false;
+}
+
+void SetWhiteboardCanvasHelperProcessMode(bool helper_mode, const std::string&) {
+    g_is_helper_process = helper_mode;
+}
+
+bool IsWhiteboardCanvasHelperProcess() {
+    return g_is_helper_process;
+}
+
+int RunWhiteboardCanvasHelperMain(const std::string&) {
+    return 1;
+}
@@ -1,6 +1,10 @@
 #include "whiteboard_enhance.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 
 #ifndef M_PI
@@ -73,16 +77,64 @@ static cv::Mat DoG(const cv::Mat& img,
 
     NormalizeKernel(kernel, 1.0);
 
+    // One direct 1 x k_size pass per kernel row, summed top to bottom. A single
+    // k_size x k_size filter2D switches to a DFT once the image is large enough,
+    // and that rounds differently on a strip than on the full frame; row passes
+    // always run direct, so every pixel sees the same arithmetic at any height.
     cv::Mat K(k_size, k_size, CV_64F, kernel.data());
-    cv::Mat img_f;
+    cv::Mat img_f, padded;
     img.convertTo(img_f, CV_32F);
-    cv::Mat result_f;
-    cv::filter2D(img_f, result_f, CV_32F, K);
+    cv::copyMakeBorder(img_f, padded, y, y, 0, 0, cv::BORDER_REFLECT_101);
+    cv::Mat result_f = cv::Mat::zeros(img_f.size(), img_f.type());
+    cv::Mat row_f;
+    for (int v = 0; v < k_size; ++v) {
+        cv::filter2D(padded.rowRange(v, v + img_f.rows), row_f, CV_32F, K.row(v),
+                     cv::Point(-1, -1), 0.0, cv::BORDER_REFLECT_101 | cv::BORDER_ISOLATED);
+        result_f += row_f;
+    }
     cv::Mat result;
     result_f.convertTo(result, CV_8U);  // round and clip to [0,255]
     return result;
 }
 
+// ---------------------------------------------------------------------------
+// SeparableDoG — same result as DoG(img, k_size, sigma_1, 0) without the dense
+// kernel. NormalizeKernel leaves the centre as the only negative entry, so the
+// positive part is G without its centre tap, scaled by 1/S:
+//   out = (G * img - g0 * img) / S - img
+// where G is the separable Gaussian and S = sum(G) - g0.
+// ---------------------------------------------------------------------------
+static cv::Mat SeparableDoG(const cv::Mat& img, int k_size, double sigma_1) {
+    const int r = (k_size - 1) / 2;
+    const double co1 = 1.0 / (2.0 * sigma_1 * sigma_1);
+    const double co2 = 1.0 / (2.0 * M_PI * sigma_1 * sigma_1);
+    cv::Mat g1d(k_size, 1, CV_64F);
+    double g1d_sum = 0.0;
+    for (int u = -r; u <= r; ++u) {
+        g1d.at<double>(u + r) = std::exp(-(u * u) * co1);
+        g1d_sum += g1d.at<double>(u + r);
+    }
+    // 2-D tap (u, v) = co2 * g1d[u] * g1d[v]; centre tap g0 = co2.
+    const double g0 = co2;
+    const double S = co2 * g1d_sum * g1d_sum - g0;
+
+    cv::Mat img_f;
+    img.convertTo(img_f, CV_32F);
+    cv::Mat blur_f;
+    cv::Mat kx = g1d * (co2 / S);
+    cv::sepFilter2D(img_f, blur_f, CV_32F, kx, g1d);
+    cv::Mat result;
+    // out = blur / S - (g0 / S + 1) * img, rounded and clipped like convertTo.
+    cv::addWeighted(blur_f, 1.0, img_f, -(g0 / S + 1.0), 0.0, result, CV_8U);
+    return result;
+}
+
+static std::atomic<bool> g_use_reference_dog{false};
+
+void SetWhiteboardEnhanceReferenceDoG(bool enabled) {
+    g_use_reference_dog.store(enabled, std::memory_order_relaxed);
+}
+
 // ---------------------------------------------------------------------------
 // get_black_white_indices — histogram scan for clip points
 // ---------------------------------------------------------------------------
@@ -104,38 +156,42 @@ static std::pair<int, int> GetBlackWhiteIndices(const std::vector<float>& hist,
 }
 
 // ---------------------------------------------------------------------------
-// contrast_stretch
-// black_point / white_point are percentages (e.g. 2.0 and 99.5).
+// Histogram helpers
+// The reference loops counted with `hist[v] += 1.0f`, which stops growing at
+// 2^24; clamping exact integer counts reproduces those bins bit for bit.
 // ---------------------------------------------------------------------------
-static cv::Mat ContrastStretch(const cv::Mat& img,
-                               float black_point, float white_point) {
-    // Total pixels across all channels
-    const int tot = img.rows * img.cols * img.channels();
-    const float black_count = tot * black_point / 100.0f;
-    const float white_count = tot * white_point / 100.0f;
-    const float white_thresh = tot - white_count;
+static float CountAsFloat(uint64_t n) {
+    return static_cast<float>(std::min<uint64_t>(n, uint64_t(1) << 24));
+}
 
-    // 1. Build a single global histogram
-    std::vector<float> hist(256, 0.0f);
-    if (img.isContinuous()) {
-        const uchar* ptr = img.ptr<uchar>();
-        for (int i = 0; i < tot; ++i) {
-            hist[ptr[i]] += 1.0f;
-        }
-    } else {
-        for (int r = 0; r < img.rows; ++r) {
-            const uchar* ptr = img.ptr<uchar>(r);
-            for (int c = 0; c < img.cols * img.channels(); ++c) {
-                hist[ptr[c]] += 1.0f;
-            }
+// One pass over an 8UC3 image, one 256-bin histogram per channel.
+static void ChannelHistograms(const cv::Mat& img, uint32_t hist[3][256]) {
+    std::memset(hist, 0, sizeof(uint32_t) * 3 * 256);
+    const int rows = img.isContinuous() ? 1 : img.rows;
+    const int cols = img.isContinuous() ? static_cast<int>(img.total()) : img.cols;
+    for (int r = 0; r < rows; ++r) {
+        const uchar* p = img.ptr<uchar>(r);
+        for (int c = 0; c < cols; ++c, p += 3) {
+            hist[0][p[0]]++;
+            hist[1][p[1]]++;
+            hist[2][p[2]]++;
         }
     }
+}
 
-    // 2. Get global black/white indices
-    auto [bi, wi] = GetBlackWhiteIndices(hist, black_count, white_thresh);
+// ---------------------------------------------------------------------------
+// contrast_stretch LUT
+// black_point / white_point are percentages (e.g. 2.0 and 99.5) of all
+// channel samples; one global table for every channel.
+// ---------------------------------------------------------------------------
+static void BuildContrastStretchLut(const std::vector<float>& hist, int tot,
+                                    float black_point, float white_point,
+                                    uchar lut_data[256]) {
+    const float black_count = tot * black_point / 100.0f;
+    const float white_count = tot * white_point / 100.0f;
+    const float white_thresh = tot - white_count;
 
-    // 3. Apply the same LUT to all channels
-    uchar lut_data[256];
+    auto [bi, wi] = GetBlackWhiteIndices(hist, black_count, white_thresh);
     for (int i = 0; i < 256; ++i) {
         if (i < bi)
             lut_data[i] = 0;
@@ -148,111 +204,236 @@ static cv::Mat ContrastStretch(const cv::Mat& img,
         else
             lut_data[i] = 0;
     }
-    
-    cv::Mat lut(1, 256, CV_8U, lut_data);
-    cv::Mat result;
-    // cv::LUT cleanly applies the single-channel LUT to all 3 channels
-    cv::LUT(img, lut, result); 
-    return result;
 }
 
 // ---------------------------------------------------------------------------
-// gamma correction
+// gamma correction LUT
 // ---------------------------------------------------------------------------
-static cv::Mat GammaCorrect(const cv::Mat& img, double gamma_value) {
+static void BuildGammaLut(double gamma_value, uchar lut_data[256]) {
     const double ig = 1.0 / gamma_value;
-    uchar lut_data[256];
     for (int i = 0; i < 256; ++i)
         lut_data[i] = static_cast<uchar>(
             std::round(std::pow(i / 255.0, ig) * 255.0));
-    cv::Mat lut(1, 256, CV_8U, lut_data);
-    cv::Mat result;
-    cv::LUT(img, lut, result);
-    return result;
 }
 
 // ---------------------------------------------------------------------------
-// color_balance — per-channel contrast stretch via cumulative histogram.
-// low_per / high_per are percentages (e.g. 2.0 and 1.0).
+// color_balance LUT — one channel, stretch via cumulative histogram.
+// low_per / high_per are percentages (e.g. 2.0 and 1.0); tot is the pixel count.
 // ---------------------------------------------------------------------------
-static cv::Mat ColorBalance(const cv::Mat& img,
-                             float low_per, float high_per) {
-    const int tot = img.rows * img.cols;
+static void BuildColorBalanceLut(const uint64_t counts[256], int tot,
+                                 float low_per, float high_per,
+                                 uchar lut_data[256]) {
     const float low_count  = tot * low_per / 100.0f;
     const float high_count = tot * (100.0f - high_per) / 100.0f;
 
-    std::vector<cv::Mat> channels;
-    cv::split(img, channels);
-
-    for (auto& ch : channels) {
-        // Cumulative histogram
-        float cum[256] = {};
-        for (int r = 0; r < ch.rows; ++r)
-            for (int c = 0; c < ch.cols; ++c)
-                cum[ch.at<uchar>(r, c)] += 1.0f;
-        for (int i = 1; i < 256; ++i)
-            cum[i] += cum[i - 1];
-
-        // searchsorted equivalent
-        int li = 0, hi = 255;
-        for (int i = 0; i < 256; ++i) { if (cum[i] >= low_count)  { li = i; break; } }
-        for (int i = 0; i < 256; ++i) { if (cum[i] >= high_count) { hi = i; break; } }
-
-        if (li == hi) continue;
-
-        uchar lut_data[256];
-        for (int i = 0; i < 256; ++i) {
-            if (i < li)
-                lut_data[i] = 0;
-            else if (i > hi)
-                lut_data[i] = 255;
-            else
-                lut_data[i] = static_cast<uchar>(
-                    std::round(static_cast<float>(i - li) /
-                               static_cast<float>(hi - li) * 255.0f));
-        }
-        cv::Mat lut(1, 256, CV_8U, lut_data);
-        cv::LUT(ch, lut, ch);
+    float cum[256];
+    for (int i = 0; i < 256; ++i) cum[i] = CountAsFloat(counts[i]);
+    for (int i = 1; i < 256; ++i)
+        cum[i] += cum[i - 1];
+
+    // searchsorted equivalent
+    int li = 0, hi = 255;
+    for (int i = 0; i < 256; ++i) { if (cum[i] >= low_count)  { li = i; break; } }
+    for (int i = 0; i < 256; ++i) { if (cum[i] >= high_count) { hi = i; break; } }
+    if (li == hi) {
+        for (int i = 0; i < 256; ++i) lut_data[i] = static_cast<uchar>(i);
+        return;
     }
 
-    cv::Mat result;
-    cv::merge(channels, result);
-    return result;
+    for (int i = 0; i < 256; ++i) {
+        if (i < li)
+            lut_data[i] = 0;
+        else if (i > hi)
+            lut_data[i] = 255;
+        else
+            lut_data[i] = static_cast<uchar>(
+                std::round(static_cast<float>(i - li) /
+                           static_cast<float>(hi - li) * 255.0f));
+    }
 }
 
 // ---------------------------------------------------------------------------
-// WhiteboardEnhance — public entry point
+// Enhance stages shared by the serial and strip-parallel entry points.
+// Negate → ContrastStretch → GaussianBlur → Gamma → ColorBalance, with the
+// pointwise steps on each side of the blur composed into one table:
+//   before: stretch[255 - v]        (global, from the negated histogram)
+//   after:  balance_c[gamma[v]]     (per channel; the balance histogram is the
+//                                    blur histogram pushed through gamma)
 // Parameters are taken verbatim from the reference Python implementation.
 // ---------------------------------------------------------------------------
-cv::Mat WhiteboardEnhance(const cv::Mat& bgr, float threshold) {
-    // --- parameters matching the Python reference ---
-    constexpr int    DOG_K    = 31;
-    constexpr double DOG_S1   = 100.0;
-    constexpr double DOG_S2   = 0.0;
-    constexpr float  CS_BLK   = 2.0f;
-    constexpr float  CS_WHT   = 99.5f;
-    constexpr int    GB_K     = 3;
-    constexpr double GB_SIG   = 1.0;
-    constexpr double GAMMA    = 1.1;
-    constexpr float  CB_LOW   = 0.1f;
-    constexpr float  CB_HIGH  = 1.0f;
-    cv::Mat dog_img = DoG(bgr, DOG_K, DOG_S1, DOG_S2);
-    // Suppress background noise: zero out pixels below the threshold before
-    // contrast-stretching, so faint surface texture doesn't get amplified.
-    if (threshold > 0.0f) {
-        cv::Mat gray_dog;
-        cv::cvtColor(dog_img, gray_dog, cv::COLOR_BGR2GRAY);
-        dog_img.setTo(0, gray_dog < static_cast<int>(threshold));
+static constexpr float  kStretchBlackPct = 2.0f;
+static constexpr float  kStretchWhitePct = 99.5f;
+static constexpr int    kBlurKernelSize  = 3;
+static constexpr double kBlurSigma       = 1.0;
+static constexpr double kGamma           = 1.1;
+static constexpr float  kBalanceLowPct   = 0.1f;
+static constexpr float  kBalanceHighPct  = 1.0f;
+
+struct ChannelHist { uint32_t bins[3][256]; };
+
+static void AccumulateHist(ChannelHist& total, const ChannelHist& part) {
+    for (int c = 0; c < 3; ++c)
+        for (int i = 0; i < 256; ++i) total.bins[c][i] += part.bins[c][i];
+}
+
+// Zero DoG pixels whose gray response is below the threshold, so faint surface
+// texture doesn't get amplified by the contrast stretch.
+static void SuppressWeakResponse(cv::Mat& dog_img, float threshold) {
+    if (threshold <= 0.0f) return;
+    cv::Mat gray_dog;
+    cv::cvtColor(dog_img, gray_dog, cv::COLOR_BGR2GRAY);
+    dog_img.setTo(0, gray_dog < static_cast<int>(threshold));
+}
+
+// Negate + contrast stretch as one table, from the DoG histogram of the whole image.
+static cv::Mat BuildStretchLut(const ChannelHist& dog_hist, int pixel_count) {
+    std::vector<float> neg_hist(256, 0.0f);
+    for (int i = 0; i < 256; ++i)
+        neg_hist[255 - i] = CountAsFloat(uint64_t(dog_hist.bins[0][i]) +
+                                         dog_hist.bins[1][i] + dog_hist.bins[2][i]);
+    uchar stretch[256];
+    BuildContrastStretchLut(neg_hist, pixel_count * 3, kStretchBlackPct, kStretchWhitePct,
+                            stretch);
+    cv::Mat lut(1, 256, CV_8U);
+    for (int v = 0; v < 256; ++v) lut.ptr<uchar>(0)[v] = stretch[255 - v];
+    return lut;
+}
+
+static void BlurStretched(const cv::Mat& src, cv::Mat& dst) {
+    cv::Mat k1d = cv::getGaussianKernel(kBlurKernelSize, kBlurSigma);
+    cv::sepFilter2D(src, dst, -1, k1d, k1d);
+}
+
+// Gamma + per-channel colour balance as one 3-channel table, from the
+// histogram of the whole blurred image.
+static cv::Mat BuildBalanceLut(const ChannelHist& blur_hist, int pixel_count) {
+    uchar gamma[256];
+    BuildGammaLut(kGamma, gamma);
+    cv::Mat lut(1, 256, CV_8UC3);
+    for (int c = 0; c < 3; ++c) {
+        uint64_t gamma_hist[256] = {};
+        for (int i = 0; i < 256; ++i) gamma_hist[gamma[i]] += blur_hist.bins[c][i];
+        uchar balance[256];
+        BuildColorBalanceLut(gamma_hist, pixel_count, kBalanceLowPct, kBalanceHighPct, balance);
+        for (int v = 0; v < 256; ++v)
+            lut.ptr<uchar>(0)[v * 3 + c] = balance[gamma[v]];
     }
-    cv::Mat neg_img;
-    cv::bitwise_not(dog_img, neg_img);
-    cv::Mat cs_img    = ContrastStretch(neg_img, CS_BLK, CS_WHT);
+    return lut;
+}
+
+// ---------------------------------------------------------------------------
+// WhiteboardDoG — DoG stage with the WhiteboardEnhance parameters
+// ---------------------------------------------------------------------------
+static constexpr int    kDogKernelSize = 31;
+static constexpr double kDogSigma1     = 100.0;
+static constexpr double kDogSigma2     = 0.0;
+
+cv::Mat WhiteboardDoG(const cv::Mat& bgr, WhiteboardDoGMode mode) {
+    if (mode == WhiteboardDoGMode::kReference)
+        return DoG(bgr, kDogKernelSize, kDogSigma1, kDogSigma2);
+    return SeparableDoG(bgr, kDogKernelSize, kDogSigma1);
+}
+
+// ---------------------------------------------------------------------------
+// WhiteboardEnhance — public entry point
+// ---------------------------------------------------------------------------
+static WhiteboardDoGMode CurrentDoGMode() {
+    return g_use_reference_dog.load(std::memory_order_relaxed)
+        ? WhiteboardDoGMode::kReference : WhiteboardDoGMode::kSeparable;
+}
+
+cv::Mat WhiteboardEnhance(const cv::Mat& bgr, float threshold) {
+    cv::Mat dog_img = WhiteboardDoG(bgr, CurrentDoGMode());
+    SuppressWeakResponse(dog_img, threshold);
+    const int pixel_count = dog_img.rows * dog_img.cols;
+
+    ChannelHist hist;
+    ChannelHistograms(dog_img, hist.bins);
+    cv::Mat cs_img;
+    cv::LUT(dog_img, BuildStretchLut(hist, pixel_count), cs_img);
+
     cv::Mat blur_img;
-    {
-        cv::Mat k1d = cv::getGaussianKernel(GB_K, GB_SIG);
-        cv::sepFilter2D(cs_img, blur_img, -1, k1d, k1d);
-    }
-    cv::Mat gamma_img = GammaCorrect(blur_img, GAMMA);
-    return ColorBalance(gamma_img, CB_LOW, CB_HIGH);
+    BlurStretched(cs_img, blur_img);
+
+    ChannelHistograms(blur_img, hist.bins);
+    cv::Mat result;
+    cv::LUT(blur_img, BuildBalanceLut(hist, pixel_count), result);
+    return result;
 }
 
+// ---------------------------------------------------------------------------
+// WhiteboardEnhanceParallel — horizontal strips over OpenCV's worker pool
+//
+// Each strip runs DoG on its rows plus kDogKernelSize / 2 + 1 halo rows, so
+// the DoG (radius 15) and the 3x3 blur (radius 1) see the same neighbours as
+// on the full frame; image edges are reflected exactly as before. Both DoG
+// modes use only direct (non-DFT) filters, so a pixel's DoG value does not
+// depend on the strip height. Histograms are summed across strips before each
+// table is built, so the output is identical to WhiteboardEnhance in either
+// mode; enhance_dog_bench checks both.
+// ---------------------------------------------------------------------------
+static constexpr int kParallelMinStripRows = 64;
+
+cv::Mat WhiteboardEnhanceParallel(const cv::Mat& bgr, float threshold, int strip_count) {
+    const int rows = bgr.rows;
+    if (strip_count <= 0) strip_count = std::max(1, cv::getNumThreads()) * 2;
+    strip_count = std::min(strip_count, rows / kParallelMinStripRows);
+    if (strip_count <= 1 || bgr.type() != CV_8UC3) return WhiteboardEnhance(bgr, threshold);
+
+    const int blur_halo = kBlurKernelSize / 2;
+    const int dog_halo = kDogKernelSize / 2;
+    const WhiteboardDoGMode mode = CurrentDoGMode();
+    auto strip_range = [&](int s) {
+        return cv::Range(rows * s / strip_count, rows * (s + 1) / strip_count);
+    };
+
+    // Phase 1: DoG + suppression on strip +- blur halo, histogram of the strip.
+    std::vector<cv::Mat> dog_strips(strip_count);
+    std::vector<ChannelHist> hists(strip_count);
+    cv::parallel_for_(cv::Range(0, strip_count), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            const cv::Range r = strip_range(s);
+            const int keep0 = std::max(0, r.start - blur_halo);
+            const int keep1 = std::min(rows, r.end + blur_halo);
+            const int in0 = std::max(0, keep0 - dog_halo);
+            const int in1 = std::min(rows, keep1 + dog_halo);
+            cv::Mat dog = WhiteboardDoG(bgr.rowRange(in0, in1), mode);
+            cv::Mat kept = dog.rowRange(keep0 - in0, keep1 - in0);
+            SuppressWeakResponse(kept, threshold);
+            dog_strips[s] = kept;
+            ChannelHistograms(kept.rowRange(r.start - keep0, r.end - keep0), hists[s].bins);
+        }
+    });
+    ChannelHist total = {};
+    for (const auto& h : hists) AccumulateHist(total, h);
+    const cv::Mat stretch_lut = BuildStretchLut(total, rows * bgr.cols);
+
+    // Phase 2: stretch + blur per strip, histogram of the blurred strip.
+    cv::Mat blur_img(bgr.size(), CV_8UC3);
+    cv::parallel_for_(cv::Range(0, strip_count), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            const cv::Range r = strip_range(s);
+            const int keep0 = std::max(0, r.start - blur_halo);
+            cv::Mat cs_strip, blurred;
+            cv::LUT(dog_strips[s], stretch_lut, cs_strip);
+            BlurStretched(cs_strip, blurred);
+            cv::Mat dst = blur_img.rowRange(r);
+            blurred.rowRange(r.start - keep0, r.end - keep0).copyTo(dst);
+            ChannelHistograms(dst, hists[s].bins);
+        }
+    });
+    total = {};
+    for (const auto& h : hists) AccumulateHist(total, h);
+    const cv::Mat balance_lut = BuildBalanceLut(total, rows * bgr.cols);
+
+    // Phase 3: final table.
+    cv::Mat result(bgr.size(), CV_8UC3);
+    cv::parallel_for_(cv::Range(0, strip_count), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            const cv::Range r = strip_range(s);
+            cv::Mat dst = result.rowRange(r);
+            cv::LUT(blur_img.rowRange(r), balance_lut, dst);
+        }
+    });
+    return result;
+}
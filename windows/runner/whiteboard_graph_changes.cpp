@@ -0,0 +1,196 @@
+#include "whiteboard_graph_changes.h"
+
+#include <algorithm>
+
+namespace {
+
+// Record fields that place the node: bbox x, y, w, h and centroid x, y.
+constexpr int kFirstGeometryField = 1;
+constexpr int kLastGeometryField = 6;
+
+// Record fields the canvas bumps on nearly every frame: absence score and
+// last seen frame. They alone do not make a node updated; events and
+// snapshots still carry their current values.
+constexpr int kAbsenceScoreField = 8;
+constexpr int kLastSeenFrameField = 9;
+
+bool GeometryChanged(const std::vector<float>& a, const std::vector<float>& b) {
+    return !std::equal(a.begin() + kFirstGeometryField, a.begin() + kLastGeometryField + 1,
+                       b.begin() + kFirstGeometryField);
+}
+
+bool RecordChanged(const std::vector<float>& a, const std::vector<float>& b) {
+    for (int i = 0; i < kGraphChangeNodeFloats; ++i) {
+        if (i == kAbsenceScoreField || i == kLastSeenFrameField) continue;
+        if (a[i] != b[i]) return true;
+    }
+    return false;
+}
+
+std::vector<float> NodePayload(const std::vector<float>& record,
+                               const std::vector<float>& outline, bool with_outline) {
+    std::vector<float> payload(record);
+    if (with_outline) {
+        payload.push_back(static_cast<float>(outline.size() / 2));
+        payload.insert(payload.end(), outline.begin(), outline.end());
+    }
+    return payload;
+}
+
+}  // namespace
+
+void GraphChangeLog::Update(const float* nodes, int node_count,
+                            const int* edges, int edge_count,
+                            const float* contours, int contour_floats,
+                            const int* bounds) {
+    bounds_valid_ = bounds != nullptr;
+    for (int i = 0; i < 4; ++i) bounds_[i] = bounds ? bounds[i] : 0;
+
+    std::unordered_map<int, NodeState> current;
+    current.reserve(static_cast<size_t>(std::max(0, node_count)));
+    for (int i = 0; nodes && i < node_count; ++i) {
+        const float* r = nodes + static_cast<size_t>(i) * kGraphChangeNodeFloats;
+        current[static_cast<int>(r[0])].record.assign(r, r + kGraphChangeNodeFloats);
+    }
+    int pos = 0;
+    while (contours && pos + 2 <= contour_floats) {
+        const int id = static_cast<int>(contours[pos]);
+        const int points = static_cast<int>(contours[pos + 1]);
+        pos += 2;
+        if (points < 0 || points > (contour_floats - pos) / 2) break;
+        auto it = current.find(id);
+        if (it != current.end()) {
+            it->second.outline.assign(contours + pos, contours + pos + points * 2);
+        }
+        pos += points * 2;
+    }
+    std::set<std::pair<int, int>> current_edges;
+    for (int i = 0; edges && i < edge_count; ++i) {
+        const int a = std::min(edges[i * 2], edges[i * 2 + 1]);
+        const int b = std::max(edges[i * 2], edges[i * 2 + 1]);
+        if (a != b) current_edges.emplace(a, b);
+    }
+
+    // Staged in GraphChangeType order (see the layout comment).
+    std::vector<Event> staged;
+    auto stage = [&](GraphChangeType type, int a, int b, std::vector<float> payload) {
+        Event event;
+        event.type = type;
+        event.a = a;
+        event.b = b;
+        event.payload = std::move(payload);
+        staged.push_back(std::move(event));
+    };
+    for (const auto& edge : edges_) {
+        if (!current_edges.count(edge)) stage(GraphChangeType::kEdgeRemoved, edge.first, edge.second, {});
+    }
+    for (const auto& entry : nodes_) {
+        if (!current.count(entry.first)) stage(GraphChangeType::kNodeRemoved, entry.first, 0, {});
+    }
+    std::vector<const std::pair<const int, NodeState>*> moved;
+    std::vector<const std::pair<const int, NodeState>*> updated;
+    for (const auto& entry : current) {
+        const NodeState& node = entry.second;
+        auto previous = nodes_.find(entry.first);
+        if (previous == nodes_.end()) {
+            stage(GraphChangeType::kNodeAdded, entry.first, 0,
+                  NodePayload(node.record, node.outline, true));
+        } else if (GeometryChanged(previous->second.record, node.record) ||
+                   previous->second.outline != node.outline) {
+            moved.push_back(&entry);
+        } else if (RecordChanged(previous->second.record, node.record)) {
+            updated.push_back(&entry);
+        }
+    }
+    for (const auto* entry : moved) {
+        stage(GraphChangeType::kNodeMoved, entry->first, 0,
+              NodePayload(entry->second.record, entry->second.outline, true));
+    }
+    for (const auto* entry : updated) {
+        stage(GraphChangeType::kNodeUpdated, entry->first, 0,
+              NodePayload(entry->second.record, entry->second.outline, false));
+    }
+    for (const auto& edge : current_edges) {
+        if (!edges_.count(edge)) stage(GraphChangeType::kEdgeAdded, edge.first, edge.second, {});
+    }
+
+    nodes_ = std::move(current);
+    edges_ = std::move(current_edges);
+    if (staged.empty()) return;
+
+    version_++;
+    for (Event& event : staged) {
+        event.version = version_;
+        retained_floats_ += kGraphChangeEventFloats + event.payload.size();
+        events_.push_back(std::move(event));
+    }
+    Trim();
+}
+
+void GraphChangeLog::Trim() {
+    while (retained_floats_ > kMaxRetainedFloats && !events_.empty()) {
+        const uint64_t oldest = events_.front().version;
+        while (!events_.empty() && events_.front().version == oldest) {
+            retained_floats_ -= kGraphChangeEventFloats + events_.front().payload.size();
+            events_.pop_front();
+        }
+        floor_version_ = oldest;
+    }
+}
+
+int GraphChangeLog::Read(int64_t since, float* buffer, int max_floats) const {
+    if (!buffer || max_floats < kGraphChangesHeaderFloats) return 0;
+    std::fill(buffer, buffer + kGraphChangesHeaderFloats, 0.0f);
+    buffer[0] = static_cast<float>(kGraphChangesLayoutVersion);
+    buffer[1] = static_cast<float>(since);
+    buffer[5] = static_cast<float>(version_);
+    buffer[7] = bounds_valid_ ? 1.0f : 0.0f;
+    for (int i = 0; i < 4; ++i) buffer[8 + i] = static_cast<float>(bounds_[i]);
+
+    // Events after `since` are only all here when nothing newer was dropped;
+    // a `since` from the future belongs to another log (helper restart).
+    if (since < static_cast<int64_t>(floor_version_) || since > static_cast<int64_t>(version_)) {
+        buffer[2] = static_cast<float>(version_);
+        buffer[4] = 1.0f;
+        return kGraphChangesHeaderFloats;
+    }
+
+    auto it = std::partition_point(events_.begin(), events_.end(), [&](const Event& event) {
+        return static_cast<int64_t>(event.version) <= since;
+    });
+    uint64_t reached = static_cast<uint64_t>(since);
+    int event_count = 0;
+    int written = kGraphChangesHeaderFloats;
+    while (it != events_.end()) {
+        const uint64_t version = it->version;
+        auto end = it;
+        size_t floats = 0;
+        while (end != events_.end() && end->version == version) {
+            floats += kGraphChangeEventFloats + end->payload.size();
+            ++end;
+        }
+        if (floats > static_cast<size_t>(max_floats - written)) break;
+        for (; it != end; ++it) {
+            float* e = buffer + written;
+            e[0] = static_cast<float>(static_cast<int>(it->type));
+            e[1] = static_cast<float>(it->a);
+            e[2] = static_cast<float>(it->b);
+            e[3] = static_cast<float>(it->payload.size());
+            std::copy(it->payload.begin(), it->payload.end(), e + kGraphChangeEventFloats);
+            written += kGraphChangeEventFloats + static_cast<int>(it->payload.size());
+            event_count++;
+        }
+        reached = version;
+    }
+
+    // Not even the next version fits: only a snapshot can catch up.
+    if (event_count == 0 && reached < version_) {
+        buffer[2] = static_cast<float>(version_);
+        buffer[4] = 1.0f;
+        return kGraphChangesHeaderFloats;
+    }
+    buffer[2] = static_cast<float>(reached);
+    buffer[3] = static_cast<float>(event_count);
+    buffer[6] = static_cast<float>(written - kGraphChangesHeaderFloats);
+    return written;
+}
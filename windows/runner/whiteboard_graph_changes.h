@@ -0,0 +1,104 @@
+#pragma once
+// ============================================================================
+// whiteboard_graph_changes.h -- Versioned change log of the canvas graph
+//
+// The debug and edit screens used to pull the whole graph (node records, hard
+// edges and every contour) on each refresh. GraphChangeLog diffs the exported
+// graph against the previous export and keeps the differences as events under
+// a version number, so a screen can ask for "everything since version v" and
+// only receive what changed. A caller too far behind (or new) is told to take
+// a full snapshot through the regular graph getters and resume from there.
+// ============================================================================
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Floats per node record, as written by WhiteboardCanvas::GetGraphNodes.
+static constexpr int kGraphChangeNodeFloats = 24;
+
+enum class GraphChangeType : int {
+    kEdgeRemoved = 1,   // a < b
+    kNodeRemoved = 2,
+    kNodeAdded = 3,     // payload: node record, point count, outline points
+    kNodeMoved = 4,     // bbox, centroid or outline changed; payload as kNodeAdded
+    kNodeUpdated = 5,   // other record fields only; payload: node record. Absence
+                        // score and last seen frame alone do not count.
+    kEdgeAdded = 6,     // a < b
+};
+
+// ---------------------------------------------------------------------------
+// Change set layout (floats) written by GraphChangeLog::Read:
+//
+//   [0] layout version            [6]  event floats after the header
+//   [1] since (as requested)      [7]  1 = canvas bounds valid
+//   [2] version the events reach  [8]  bounds min x    [10] bounds max x
+//   [3] event count               [9]  bounds min y    [11] bounds max y
+//   [4] 1 = take a full snapshot, then resume from [2]; no events follow
+//   [5] latest version
+//   then events: type, a, b, payload floats P, P payload floats
+//
+// A `since` of -1 always asks for a snapshot, to learn the version to start
+// from. Bounds are those of the latest version.
+// Node events carry the node id in `a`; edge events the two node ids. Node
+// outlines are canvas coordinates: point count n, then n x/y pairs. Within a
+// version events come in GraphChangeType order, so applying them in sequence
+// never leaves an edge without its nodes. Only whole versions are returned;
+// when [2] < [5] the buffer was too small for the rest and the caller asks
+// again from [2]. Versions stay exact in a float up to 2^24.
+// ---------------------------------------------------------------------------
+static constexpr int kGraphChangesLayoutVersion = 1;
+static constexpr int kGraphChangesHeaderFloats = 12;
+static constexpr int kGraphChangeEventFloats = 4;   // event floats before the payload
+
+// Not thread-safe; the owner serializes Update and Read.
+class GraphChangeLog {
+public:
+    // Oldest versions are dropped once the retained events exceed this.
+    static constexpr size_t kMaxRetainedFloats = 1 << 20;
+
+    // Diffs a full export against the previous one and records the changes
+    // under a new version (none when nothing changed). `nodes` holds
+    // node_count records, `edges` edge_count id pairs, `contours` the
+    // GetGraphNodeContours layout ([id, n, x0, y0, ...] per node) and
+    // `bounds` the canvas bounds (nullptr = none).
+    void Update(const float* nodes, int node_count,
+                const int* edges, int edge_count,
+                const float* contours, int contour_floats,
+                const int* bounds);
+
+    // Writes the layout above for the events after `since`. Returns the
+    // floats written, or 0 when max_floats cannot hold the header.
+    int Read(int64_t since, float* buffer, int max_floats) const;
+
+    uint64_t version() const { return version_; }
+
+private:
+    struct NodeState {
+        std::vector<float> record;      // kGraphChangeNodeFloats
+        std::vector<float> outline;     // n x/y pairs
+    };
+
+    struct Event {
+        uint64_t version = 0;
+        GraphChangeType type = GraphChangeType::kNodeAdded;
+        int a = 0;
+        int b = 0;
+        std::vector<float> payload;
+    };
+
+    void Trim();
+
+    std::unordered_map<int, NodeState> nodes_;
+    std::set<std::pair<int, int>> edges_;
+    std::deque<Event> events_;          // ascending version
+    bool bounds_valid_ = false;
+    int bounds_[4] = {0, 0, 0, 0};
+    size_t retained_floats_ = 0;
+    uint64_t version_ = 0;
+    uint64_t floor_version_ = 0;        // events up to here were dropped
+};
@@ -0,0 +1,335 @@
+#include "yolo_person_detector.h"
+
+#include <opencv2/dnn.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+YoloInputTensor::YoloInputTensor(int input_size)
+    : input_size_(input_size) {}
+
+const cv::Mat& YoloInputTensor::Prepare(const cv::Mat& frame_bgr) {
+    if (frame_bgr.size() != frame_size_ || letterbox_.empty()) {
+        frame_size_ = frame_bgr.size();
+        scale_ = std::min(static_cast<float>(input_size_) / frame_bgr.cols,
+                          static_cast<float>(input_size_) / frame_bgr.rows);
+        const int w = std::max(1, static_cast<int>(std::lround(frame_bgr.cols * scale_)));
+        const int h = std::max(1, static_cast<int>(std::lround(frame_bgr.rows * scale_)));
+        content_ = cv::Rect((input_size_ - w) / 2, (input_size_ - h) / 2, w, h);
+        letterbox_.create(input_size_, input_size_, CV_8UC3);
+        letterbox_.setTo(cv::Scalar::all(kPadValue));
+    }
+
+    // Resizing into the ROI writes in place; the padding stays painted.
+    cv::Mat content = letterbox_(content_);
+    cv::resize(frame_bgr, content, content_.size(), 0, 0, cv::INTER_LINEAR);
+    cv::dnn::blobFromImage(letterbox_, blob_, 1.0 / 255.0, cv::Size(), cv::Scalar(), true, false);
+    return blob_;
+}
+
+cv::Rect2f YoloInputTensor::ToFrame(float cx, float cy, float w, float h) const {
+    const float inv = 1.0f / scale_;
+    return cv::Rect2f((cx - 0.5f * w - content_.x) * inv,
+                      (cy - 0.5f * h - content_.y) * inv,
+                      w * inv, h * inv);
+}
+
+std::vector<PersonBox> DecodeYoloPersons(const cv::Mat& output,
+                                         const YoloInputTensor& input,
+                                         const cv::Size& frame_size,
+                                         float conf_threshold,
+                                         float nms_threshold) {
+    std::vector<PersonBox> persons;
+    if (output.dims != 3 || output.type() != CV_32F || !output.isContinuous()) return persons;
+    const int channels = output.size[1];   // cx, cy, w, h, class scores...
+    const int anchors = output.size[2];
+    if (channels < 5 || anchors <= 0) return persons;
+
+    // Channel-major: each channel is one contiguous row over all anchors.
+    const float* data = output.ptr<float>();
+    const float* cx = data;
+    const float* cy = data + anchors;
+    const float* bw = data + 2 * static_cast<size_t>(anchors);
+    const float* bh = data + 3 * static_cast<size_t>(anchors);
+    const cv::Mat person_scores(1, anchors, CV_32F, const_cast<float*>(data + 4 * static_cast<size_t>(anchors)));
+
+    cv::Mat hits;
+    cv::compare(person_scores, conf_threshold, hits, cv::CMP_GT);
+    std::vector<cv::Point> hit_points;
+    cv::findNonZero(hits, hit_points);
+    if (hit_points.empty()) return persons;
+
+    const cv::Rect frame_rect(0, 0, frame_size.width, frame_size.height);
+    const float* scores = person_scores.ptr<float>();
+    std::vector<cv::Rect> boxes;
+    std::vector<float> confidences;
+    boxes.reserve(hit_points.size());
+    confidences.reserve(hit_points.size());
+    for (const cv::Point& p : hit_points) {
+        const int i = p.x;
+        const cv::Rect2f r = input.ToFrame(cx[i], cy[i], bw[i], bh[i]);
+        const cv::Rect box = cv::Rect(static_cast<int>(r.x), static_cast<int>(r.y),
+                                      static_cast<int>(r.width), static_cast<int>(r.height)) & frame_rect;
+        if (box.area() <= 0) continue;
+        boxes.push_back(box);
+        confidences.push_back(scores[i]);
+    }
+
+    std::vector<int> indices;
+    cv::dnn::NMSBoxes(boxes, confidences, conf_threshold, nms_threshold, indices);
+    persons.reserve(indices.size());
+    for (int idx : indices) persons.push_back({boxes[idx], confidences[idx]});
+    return persons;
+}
+
+// ---------------------------------------------------------------------------
+// PersonDetector
+// ---------------------------------------------------------------------------
+
+namespace {
+
+const char* ModelFileName(PersonDetectorPrecision precision) {
+    switch (precision) {
+        case PersonDetectorPrecision::kFp16: return "yolo11n_fp16.onnx";
+        case PersonDetectorPrecision::kInt8: return "yolo11n_int8.onnx";
+        case PersonDetectorPrecision::kFp32:
+        default: return "yolo11n.onnx";
+    }
+}
+
+void ApplyBackend(cv::dnn::Net& net, const PersonDetectorConfig& config) {
+    if (config.backend == PersonDetectorBackend::kOpenVinoCpu) {
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_INFERENCE_ENGINE);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        return;
+    }
+    net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(config.precision == PersonDetectorPrecision::kFp16
+                                ? cv::dnn::DNN_TARGET_CPU_FP16
+                                : cv::dnn::DNN_TARGET_CPU);
+}
+
+cv::dnn::Net ReadModel(const std::string& path) {
+    try {
+        return cv::dnn::readNetFromONNX(path);
+    } catch (const cv::Exception& e) {
+        std::cerr << "[PersonDetector] Failed to load " << path << ": " << e.what() << std::endl;
+        return cv::dnn::Net();
+    }
+}
+
+// Two passes per input size: the first allocates (and for OpenVINO compiles),
+// the second settles the caches.
+void WarmUp(cv::dnn::Net& net, int input_size, std::vector<cv::Mat>& outputs) {
+    const cv::Mat gray_frame(720, 1280, CV_8UC3, cv::Scalar::all(114));
+    YoloInputTensor input(input_size);
+    for (int pass = 0; pass < 2; pass++) {
+        net.setInput(input.Prepare(gray_frame));
+        net.forward(outputs, net.getUnconnectedOutLayersNames());
+    }
+}
+
+double MsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+PersonDetector& PersonDetector::Instance() {
+    static PersonDetector instance;
+    return instance;
+}
+
+PersonDetector::~PersonDetector() {
+    if (loader_.joinable()) loader_.join();
+}
+
+void PersonDetector::Start(ModelPathFn model_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    model_path_ = std::move(model_path);
+    if (loader_running_ || state_ != State::kIdle) return;
+    if (loader_.joinable()) loader_.join();
+    loader_running_ = true;
+    state_ = State::kLoading;
+    loader_ = std::thread(&PersonDetector::LoaderLoop, this);
+}
+
+void PersonDetector::Configure(const PersonDetectorConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requested_ = config;
+    if (!model_path_) return;  // Start picks up requested_
+    reload_requested_ = true;
+    if (loader_running_) return;
+    // The previous loader has already released the lock for good.
+    if (loader_.joinable()) loader_.join();
+    loader_running_ = true;
+    state_ = State::kLoading;
+    loader_ = std::thread(&PersonDetector::LoaderLoop, this);
+}
+
+void PersonDetector::LoaderLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        reload_requested_ = false;
+        const PersonDetectorConfig config = requested_;
+        lock.unlock();
+        const bool ok = LoadAndWarmUp(config);
+        lock.lock();
+        if (reload_requested_) continue;
+        // A failed reload keeps serving the previous network.
+        state_ = ok || has_net_ ? State::kReady : State::kFailed;
+        break;
+    }
+    loader_running_ = false;
+}
+
+bool PersonDetector::LoadAndWarmUp(const PersonDetectorConfig& requested) {
+    ModelPathFn model_path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        model_path = model_path_;
+    }
+    PersonDetectorConfig config = requested;
+    cv::setNumThreads(config.threads > 0 ? config.threads : cv::getNumberOfCPUs());
+
+    const auto load_start = std::chrono::steady_clock::now();
+    cv::dnn::Net net = ReadModel(model_path(ModelFileName(config.precision)));
+    if (net.empty() && config.precision != PersonDetectorPrecision::kFp32) {
+        std::cerr << "[PersonDetector] " << ModelFileName(config.precision)
+                  << " unavailable, using FP32" << std::endl;
+        config.precision = PersonDetectorPrecision::kFp32;
+        net = ReadModel(model_path(ModelFileName(config.precision)));
+    }
+    if (net.empty()) return false;
+    ApplyBackend(net, config);
+    const double load_ms = MsSince(load_start);
+
+    const auto warmup_start = std::chrono::steady_clock::now();
+    std::vector<cv::Mat> outputs;
+    try {
+        WarmUp(net, kFullInputSize, outputs);
+    } catch (const cv::Exception& e) {
+        if (config.backend == PersonDetectorBackend::kOpenCvCpu) {
+            std::cerr << "[PersonDetector] Warm-up failed: " << e.what() << std::endl;
+            return false;
+        }
+        // Typically an OpenCV build without OpenVINO.
+        std::cerr << "[PersonDetector] Backend unavailable, using OpenCV CPU: " << e.what() << std::endl;
+        config.backend = PersonDetectorBackend::kOpenCvCpu;
+        ApplyBackend(net, config);
+        try {
+            WarmUp(net, kFullInputSize, outputs);
+        } catch (const cv::Exception& e2) {
+            std::cerr << "[PersonDetector] Warm-up failed: " << e2.what() << std::endl;
+            return false;
+        }
+    }
+    // Models exported with a fixed 640 input reject the canvas size.
+    bool small_input_ok = true;
+    try {
+        WarmUp(net, kCanvasInputSize, outputs);
+    } catch (const cv::Exception&) {
+        std::cerr << "[PersonDetector] Model only accepts " << kFullInputSize
+                  << "px input" << std::endl;
+        small_input_ok = false;
+    }
+    const double warmup_ms = MsSince(warmup_start);
+
+    {
+        std::lock_guard<std::mutex> net_lock(net_mutex_);
+        net_ = net;
+        outputs_.clear();
+        small_input_ok_ = small_input_ok;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = config;
+    has_net_ = true;
+    load_ms_ = load_ms;
+    warmup_ms_ = warmup_ms;
+    inferences_ = 0;
+    latency_count_ = 0;
+    latency_next_ = 0;
+    last_ms_ = 0.0;
+    std::cout << "[PersonDetector] Ready: load " << load_ms << " ms, warm-up " << warmup_ms
+              << " ms" << std::endl;
+    return true;
+}
+
+bool PersonDetector::Detect(YoloInputTensor& input, const cv::Mat& frame_bgr,
+                            float conf_threshold, float nms_threshold,
+                            std::vector<PersonBox>& persons) {
+    persons.clear();
+    if (frame_bgr.empty()) return false;
+    // A frame that arrives during the load is skipped, not held up.
+    if (!IsReady()) return false;
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> net_lock(net_mutex_);
+        if (input.input_size() != kFullInputSize && !small_input_ok_) {
+            input = YoloInputTensor(kFullInputSize);
+        }
+        try {
+            net_.setInput(input.Prepare(frame_bgr));
+            net_.forward(outputs_, net_.getUnconnectedOutLayersNames());
+        } catch (const cv::Exception& e) {
+            std::cerr << "[PersonDetector] Inference failed: " << e.what() << std::endl;
+            return false;
+        }
+        if (outputs_.empty()) return false;
+        persons = DecodeYoloPersons(outputs_[0], input, frame_bgr.size(),
+                                    conf_threshold, nms_threshold);
+    }
+    RecordLatency(MsSince(start));
+    return true;
+}
+
+bool PersonDetector::IsReady() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return has_net_;
+}
+
+void PersonDetector::RecordLatency(double ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    inferences_++;
+    last_ms_ = ms;
+    latency_ms_[latency_next_] = ms;
+    latency_next_ = (latency_next_ + 1) % kLatencyWindow;
+    latency_count_ = std::min(latency_count_ + 1, kLatencyWindow);
+}
+
+int PersonDetector::GetStats(float* buffer, int max_floats) const {
+    if (!buffer || max_floats < kPersonDetectorStatsFloats) return 0;
+    std::fill(buffer, buffer + kPersonDetectorStatsFloats, 0.0f);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer[0] = static_cast<float>(kPersonDetectorStatsVersion);
+    buffer[1] = static_cast<float>(state_);
+    buffer[2] = static_cast<float>(requested_.backend);
+    buffer[3] = static_cast<float>(active_.backend);
+    buffer[4] = static_cast<float>(requested_.precision);
+    buffer[5] = static_cast<float>(active_.precision);
+    buffer[6] = static_cast<float>(cv::getNumThreads());
+    buffer[7] = static_cast<float>(load_ms_);
+    buffer[8] = static_cast<float>(warmup_ms_);
+    buffer[9] = static_cast<float>(inferences_);
+    buffer[10] = static_cast<float>(latency_count_);
+    buffer[11] = static_cast<float>(last_ms_);
+    if (latency_count_ > 0) {
+        std::vector<double> sorted(latency_ms_, latency_ms_ + latency_count_);
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double ms : sorted) sum += ms;
+        const auto nearest_rank = [&](double p) {
+            const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+            return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+        };
+        buffer[12] = static_cast<float>(sum / sorted.size());
+        buffer[13] = static_cast<float>(nearest_rank(50.0));
+        buffer[14] = static_cast<float>(nearest_rank(90.0));
+        buffer[15] = static_cast<float>(sorted.back());
+    }
+    return kPersonDetectorStatsFloats;
+}
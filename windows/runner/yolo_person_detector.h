@@ -0,0 +1,172 @@
+#pragma once
+// ============================================================================
+// yolo_person_detector.h -- YOLOv11n person detector shared by the app
+//
+// Front-end: letterboxes frames into a reused square NCHW input tensor (aspect
+// ratio kept, gray padding as in Ultralytics training) and decodes class 0
+// straight from the channel-major [1, 4 + classes, anchors] output: the score
+// row is thresholded in one vectorized pass and only surviving anchors build
+// boxes.
+//
+// PersonDetector owns the one network instance. It is loaded and warmed up on
+// a background thread at startup, can be switched to another backend, model
+// precision or thread count at runtime, and keeps inference latency stats.
+// ============================================================================
+
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PersonBox {
+    cv::Rect box;   // frame pixels, clipped to the frame
+    float score = 0.0f;
+};
+
+class YoloInputTensor {
+public:
+    // input_size: square network input side, a multiple of 32 (320, 416, 640).
+    explicit YoloInputTensor(int input_size);
+
+    int input_size() const { return input_size_; }
+
+    // Letterboxes frame_bgr (CV_8UC3) and returns the 1x3xSxS CV_32F blob, RGB,
+    // scaled to [0, 1]. The returned Mat is reused by the next call.
+    const cv::Mat& Prepare(const cv::Mat& frame_bgr);
+
+    // Maps a network-space box (center, size) back to frame pixels.
+    cv::Rect2f ToFrame(float cx, float cy, float w, float h) const;
+
+private:
+    static constexpr int kPadValue = 114;
+
+    int input_size_;
+    cv::Mat letterbox_;         // SxS CV_8UC3, padding painted once per geometry
+    cv::Mat blob_;
+    cv::Size frame_size_;       // geometry of the last Prepare
+    cv::Rect content_;          // resized frame inside letterbox_
+    float scale_ = 1.0f;        // network pixels per frame pixel
+};
+
+// Person (COCO class 0) detections after NMS. `output` is the first network
+// output, [1, 4 + classes, anchors] CV_32F; `input` the tensor it was run on.
+std::vector<PersonBox> DecodeYoloPersons(const cv::Mat& output,
+                                         const YoloInputTensor& input,
+                                         const cv::Size& frame_size,
+                                         float conf_threshold,
+                                         float nms_threshold);
+
+// ---------------------------------------------------------------------------
+// PersonDetector
+// ---------------------------------------------------------------------------
+
+enum class PersonDetectorBackend : int {
+    kOpenCvCpu = 0,     // OpenCV DNN on the CPU
+    kOpenVinoCpu = 1,   // OpenVINO (Inference Engine) on the CPU; needs an OpenVINO build of OpenCV
+};
+
+enum class PersonDetectorPrecision : int {
+    kFp32 = 0,          // models/yolo11n.onnx
+    kFp16 = 1,          // models/yolo11n_fp16.onnx
+    kInt8 = 2,          // models/yolo11n_int8.onnx (QDQ-quantized)
+};
+
+struct PersonDetectorConfig {
+    PersonDetectorBackend backend = PersonDetectorBackend::kOpenCvCpu;
+    PersonDetectorPrecision precision = PersonDetectorPrecision::kFp32;
+    int threads = 0;    // cv::setNumThreads (process-wide); 0 = all cores
+};
+
+// ---------------------------------------------------------------------------
+// Stats layout (floats) written by PersonDetector::GetStats:
+//
+//   [0] layout version            [8]  warm-up ms
+//   [1] state (0 idle, 1 loading, [9]  inferences since load
+//       2 ready, 3 failed)        [10] samples in the latency window
+//   [2] requested backend         [11] last inference ms
+//   [3] active backend            [12] mean ms over the window
+//   [4] requested precision       [13] p50 ms
+//   [5] active precision          [14] p90 ms
+//   [6] threads                   [15] max ms
+//   [7] model load ms
+//
+// Backend and precision use the enum values above. "Active" differs from
+// "requested" when a variant was unavailable and the detector fell back.
+// Inference time covers letterbox, forward and decode.
+// ---------------------------------------------------------------------------
+static constexpr int kPersonDetectorStatsVersion = 1;
+static constexpr int kPersonDetectorStatsFloats = 16;
+
+class PersonDetector {
+public:
+    // Network input sides: the canvas needs only coarse lecturer boxes.
+    static constexpr int kFullInputSize = 640;
+    static constexpr int kCanvasInputSize = 416;
+
+    // Maps a model file name to its absolute path.
+    using ModelPathFn = std::function<std::string(const std::string& file_name)>;
+
+    static PersonDetector& Instance();
+
+    // Starts loading and warming up the model on a background thread.
+    // Later calls only update the path resolver.
+    void Start(ModelPathFn model_path);
+
+    // Reloads the model with `config` in the background. Detections keep
+    // using the previous network until the new one is warm.
+    void Configure(const PersonDetectorConfig& config);
+
+    // Detects persons in frame_bgr through `input`. The tensor is only touched
+    // under the network lock, so callers may share one. Never waits for the
+    // loader: returns false while the first model is still loading, or when
+    // none is available.
+    bool Detect(YoloInputTensor& input, const cv::Mat& frame_bgr,
+                float conf_threshold, float nms_threshold,
+                std::vector<PersonBox>& persons);
+
+    // True once a model is loaded and warm; Detect can run.
+    bool IsReady() const;
+
+    // Writes the layout above. Returns kPersonDetectorStatsFloats, or 0 when
+    // max_floats is too small.
+    int GetStats(float* buffer, int max_floats) const;
+
+private:
+    enum class State : int { kIdle = 0, kLoading = 1, kReady = 2, kFailed = 3 };
+
+    static constexpr int kLatencyWindow = 64;
+
+    PersonDetector() = default;
+    ~PersonDetector();
+
+    void LoaderLoop();
+    bool LoadAndWarmUp(const PersonDetectorConfig& config);
+    void RecordLatency(double ms);
+
+    mutable std::mutex mutex_;            // everything below except the net
+    ModelPathFn model_path_;
+    PersonDetectorConfig requested_;
+    PersonDetectorConfig active_;
+    State state_ = State::kIdle;
+    bool has_net_ = false;
+    bool reload_requested_ = false;
+    bool loader_running_ = false;
+    std::thread loader_;
+    double load_ms_ = 0.0;
+    double warmup_ms_ = 0.0;
+    uint64_t inferences_ = 0;
+    double latency_ms_[kLatencyWindow] = {};
+    int latency_count_ = 0;
+    int latency_next_ = 0;
+    double last_ms_ = 0.0;
+
+    std::mutex net_mutex_;                // the network, its outputs, small_input_ok_
+    cv::dnn::Net net_;
+    std::vector<cv::Mat> outputs_;
+    bool small_input_ok_ = true;          // model accepts inputs other than 640
+};